@@ -0,0 +1,317 @@
+// engine 吞吐和延迟基准测试, 遍历 优化等级 x 执行模式 x 线程数 x batch x 并发数,
+// 输入为按 GetInputTensorDescs 生成的随机数据, 结果输出为表格和 json
+// ./build/release/bin/bench_engine --model_path
+// modelzoo/yolov8n/data/yolov8n.onnx --intra_op_threads 1,2,4
+// --graph_optimize_levels 1,99 --json_path build/bench_engine.json
+// 动态 batch 模型:
+// ./build/release/bin/bench_engine --model_path
+// modelzoo/mnist_dynamic/data/mnist_dynamic.onnx --batch_sizes 1,4,16
+
+#include <gflags/gflags.h>
+
+#include "inference/onnxruntime/onnxruntime.h"
+#include <cpptoolkit/fp16/half.hpp>
+#include <cpptoolkit/log/log.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <thread>
+
+using half_float::half;
+
+DEFINE_string(model_path, "modelzoo/yolov8n/data/yolov8n.onnx", "model path");
+DEFINE_string(device, "cpu", "cpu or gpu");
+DEFINE_string(batch_sizes, "1",
+              "comma separated batch sizes, only used by dynamic model");
+DEFINE_string(intra_op_threads, "1", "comma separated intra op num threads");
+DEFINE_string(inter_op_threads, "1", "comma separated inter op num threads");
+DEFINE_string(exe_modes, "0", "comma separated exe modes, 0: sequential, "
+                              "1: parallel");
+DEFINE_string(graph_optimize_levels, "99",
+              "comma separated graph optimize levels, 0/1/2/99");
+DEFINE_string(concurrency, "1",
+              "comma separated number of exec contexts running concurrently");
+DEFINE_int32(warmup, 10, "warmup runs of each exec context");
+DEFINE_int32(iterations, 100, "timed runs of each exec context");
+DEFINE_string(json_path, "bench_engine.json", "json result path");
+
+namespace {
+
+struct BenchConfig {
+  int graph_optimize_level = 99;
+  int exe_mode = 0;
+  int intra_op_threads = 1;
+  int inter_op_threads = 1;
+  int batch_size = 1;
+  int concurrency = 1;
+};
+
+struct BenchResult {
+  BenchConfig config;
+  int samples_per_run = 1;
+  double elapsed_s = 0;
+  double runs_per_s = 0;
+  double samples_per_s = 0;
+  inference::InferenceStats stats;
+};
+
+std::vector<int> ParseIntList(const std::string &str) {
+  std::vector<int> result;
+  std::stringstream ss(str);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    if (!item.empty()) {
+      result.push_back(std::stoi(item));
+    }
+  }
+  return result;
+}
+
+void FillRandom(void *p, inference::TensorDataType data_type, int64_t elem_cnt,
+                std::mt19937 &rng) {
+  std::uniform_real_distribution<float> dist(0.f, 1.f);
+  switch (data_type) {
+  case inference::kFP32:
+    for (int64_t i = 0; i < elem_cnt; i++) {
+      ((float *)p)[i] = dist(rng);
+    }
+    break;
+  case inference::kFP16:
+    for (int64_t i = 0; i < elem_cnt; i++) {
+      ((half *)p)[i] = half(dist(rng));
+    }
+    break;
+  case inference::kInt8:
+  case inference::kUint8:
+    for (int64_t i = 0; i < elem_cnt; i++) {
+      ((uint8_t *)p)[i] = rng() & 0xFF;
+    }
+    break;
+  default:
+    // int64 一般是索引或者 shape, 随机值可能越界, 填 0
+    memset(p, 0, inference::GetElemMemSize(data_type, elem_cnt));
+    break;
+  }
+}
+
+// 按模型的输入描述生成 batch_size 个样本的随机输入
+void FillSyntheticInputs(const inference::InferenceEngine &engine,
+                         inference::InferenceExecContext *ctx,
+                         int batch_size, std::mt19937 &rng) {
+  const auto &descs = engine.GetInputTensorDescs();
+  for (auto &[name, tensor] : ctx->GetInputTensors()) {
+    const auto &desc = descs.at(name);
+    int64_t elem_cnt =
+        inference::GetElemCntFromShape(desc.shape, std::max(batch_size, 1));
+    FillRandom(tensor.p, desc.data_type, elem_cnt, rng);
+  }
+}
+
+// 静态模型每次推理的样本数为第一个输入的 batch 维
+int GetSamplesPerRun(const inference::InferenceEngine &engine,
+                     int batch_size) {
+  if (engine.IsDynamicModel()) {
+    return batch_size;
+  }
+  const auto &descs = engine.GetInputTensorDescs();
+  const auto &names = engine.GetInputNodeNames();
+  if (names.empty()) {
+    return 1;
+  }
+  const auto &shape = descs.at(names[0]).shape;
+  return !shape.empty() && shape[0] > 0 ? (int)shape[0] : 1;
+}
+
+int RunBench(inference::OnnxRuntimeEngine &engine, const BenchConfig &config,
+             BenchResult *result) {
+  int run_batch_size = engine.IsDynamicModel() ? config.batch_size : -1;
+
+  std::mt19937 rng(0);
+  std::vector<inference::InferenceExecContextUPtr> contexts;
+  for (int i = 0; i < config.concurrency; i++) {
+    auto ctx = engine.CreateExecContext();
+    if (!ctx) {
+      return -1;
+    }
+    FillSyntheticInputs(engine, ctx.get(), config.batch_size, rng);
+    for (int j = 0; j < FLAGS_warmup; j++) {
+      if (ctx->Run(run_batch_size) != 0) {
+        LOG_ERROR("warmup failed, batch size: {}", config.batch_size);
+        return -1;
+      }
+    }
+    contexts.push_back(std::move(ctx));
+  }
+
+  engine.ResetStats();
+  std::atomic<int> failed{0};
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (auto &ctx : contexts) {
+    threads.emplace_back([&failed, ctx = ctx.get(), run_batch_size]() {
+      for (int i = 0; i < FLAGS_iterations; i++) {
+        if (ctx->Run(run_batch_size) != 0) {
+          failed++;
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto end = std::chrono::steady_clock::now();
+  if (failed > 0) {
+    LOG_ERROR("{} runs failed", failed.load());
+    return -1;
+  }
+
+  result->config = config;
+  result->samples_per_run = GetSamplesPerRun(engine, config.batch_size);
+  result->elapsed_s = std::chrono::duration<double>(end - start).count();
+  result->stats = engine.GetStats();
+  result->runs_per_s = result->stats.run_count / result->elapsed_s;
+  result->samples_per_s = result->runs_per_s * result->samples_per_run;
+  return 0;
+}
+
+void LogTable(const std::vector<BenchResult> &results) {
+  LOG_INFO("| {:>3} | {:>4} | {:>5} | {:>5} | {:>5} | {:>4} | {:>10} | {:>11} "
+           "| {:>9} | {:>9} | {:>9} | {:>9} | {:>9} |",
+           "opt", "mode", "intra", "inter", "batch", "conc", "runs/s",
+           "samples/s", "mean(ms)", "p50(ms)", "p90(ms)", "p99(ms)",
+           "max(ms)");
+  for (auto &r : results) {
+    const auto &c = r.config;
+    const auto &t = r.stats.total;
+    LOG_INFO("| {:>3} | {:>4} | {:>5} | {:>5} | {:>5} | {:>4} | {:>10.2f} | "
+             "{:>11.2f} | {:>9.3f} | {:>9.3f} | {:>9.3f} | {:>9.3f} | "
+             "{:>9.3f} |",
+             c.graph_optimize_level, c.exe_mode, c.intra_op_threads,
+             c.inter_op_threads, r.samples_per_run, c.concurrency,
+             r.runs_per_s, r.samples_per_s, t.mean_us / 1e3, t.p50_us / 1e3,
+             t.p90_us / 1e3, t.p99_us / 1e3, t.max_us / 1e3);
+  }
+}
+
+std::string LatencyToJson(const inference::LatencySummary &s) {
+  return fmt::format("{{\"mean_us\": {:.3f}, \"p50_us\": {:.3f}, "
+                     "\"p90_us\": {:.3f}, \"p99_us\": {:.3f}, "
+                     "\"max_us\": {:.3f}}}",
+                     s.mean_us, s.p50_us, s.p90_us, s.p99_us, s.max_us);
+}
+
+std::string ToJson(const std::vector<BenchResult> &results) {
+  std::string json = "{\n";
+  json += fmt::format("  \"model_path\": \"{}\",\n", FLAGS_model_path);
+  json += fmt::format("  \"device\": \"{}\",\n", FLAGS_device);
+  json += fmt::format("  \"warmup\": {},\n", FLAGS_warmup);
+  json += fmt::format("  \"iterations\": {},\n", FLAGS_iterations);
+  json += "  \"results\": [\n";
+  for (size_t i = 0; i < results.size(); i++) {
+    const auto &r = results[i];
+    const auto &c = r.config;
+    json += "    {";
+    json += fmt::format("\"graph_optimize_level\": {}, \"exe_mode\": {}, ",
+                        c.graph_optimize_level, c.exe_mode);
+    json += fmt::format("\"intra_op_threads\": {}, \"inter_op_threads\": {}, ",
+                        c.intra_op_threads, c.inter_op_threads);
+    json += fmt::format("\"batch_size\": {}, \"concurrency\": {}, ",
+                        r.samples_per_run, c.concurrency);
+    json += fmt::format("\"runs\": {}, \"elapsed_s\": {:.6f}, ",
+                        r.stats.run_count, r.elapsed_s);
+    json += fmt::format("\"runs_per_s\": {:.3f}, \"samples_per_s\": {:.3f}, ",
+                        r.runs_per_s, r.samples_per_s);
+    json += fmt::format("\"latency\": {}, \"setup_latency\": {}, "
+                        "\"run_latency\": {}",
+                        LatencyToJson(r.stats.total),
+                        LatencyToJson(r.stats.setup),
+                        LatencyToJson(r.stats.run));
+    json += i + 1 < results.size() ? "},\n" : "}\n";
+  }
+  json += "  ]\n}\n";
+  return json;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  cpptoolkit::LogInit();
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  auto batch_sizes = ParseIntList(FLAGS_batch_sizes);
+  auto concurrency_list = ParseIntList(FLAGS_concurrency);
+  if (batch_sizes.empty() || concurrency_list.empty()) {
+    LOG_ERROR("batch_sizes and concurrency can not be empty");
+    return -1;
+  }
+
+  auto params = inference::GetDefaultOnnxRuntimeEngineParams();
+  params.model_path = FLAGS_model_path;
+  params.device_type =
+      FLAGS_device == "gpu" ? inference::kGPU : inference::kCPU;
+  params.max_batch_size =
+      *std::max_element(batch_sizes.begin(), batch_sizes.end());
+
+  std::vector<BenchResult> results;
+  for (int level : ParseIntList(FLAGS_graph_optimize_levels)) {
+    for (int exe_mode : ParseIntList(FLAGS_exe_modes)) {
+      for (int intra : ParseIntList(FLAGS_intra_op_threads)) {
+        for (int inter : ParseIntList(FLAGS_inter_op_threads)) {
+          params.graph_optimize_level = level;
+          params.exe_mode = exe_mode;
+          params.intra_op_num_threads = intra;
+          params.inter_op_num_threads = inter;
+
+          inference::OnnxRuntimeEngine engine;
+          if (engine.Init(params) != 0) {
+            LOG_ERROR("init engine failed, model: {}", FLAGS_model_path);
+            return -1;
+          }
+          // 静态模型只测试模型自身的 batch
+          std::vector<int> run_batch_sizes = batch_sizes;
+          if (!engine.IsDynamicModel()) {
+            run_batch_sizes = {1};
+          }
+
+          for (int batch_size : run_batch_sizes) {
+            for (int concurrency : concurrency_list) {
+              BenchConfig config{level, exe_mode, intra, inter, batch_size,
+                                 concurrency};
+              BenchResult result;
+              if (RunBench(engine, config, &result) != 0) {
+                return -1;
+              }
+              results.push_back(result);
+              LOG_INFO("opt: {}, mode: {}, intra: {}, inter: {}, batch: {}, "
+                       "concurrency: {}, samples/s: {:.2f}, p50: {:.3f} ms",
+                       level, exe_mode, intra, inter, result.samples_per_run,
+                       concurrency, result.samples_per_s,
+                       result.stats.total.p50_us / 1e3);
+            }
+          }
+        }
+      }
+    }
+  }
+
+  LOG_INFO("model: {}, device: {}, warmup: {}, iterations: {}",
+           FLAGS_model_path, FLAGS_device, FLAGS_warmup, FLAGS_iterations);
+  LogTable(results);
+
+  auto json = ToJson(results);
+  if (!FLAGS_json_path.empty()) {
+    std::ofstream file(FLAGS_json_path);
+    if (!file.is_open()) {
+      LOG_ERROR("open json file: {} failed", FLAGS_json_path);
+      return -1;
+    }
+    file << json;
+    LOG_INFO("write json result: {}", FLAGS_json_path);
+  }
+  return 0;
+}
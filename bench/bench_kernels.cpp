@@ -0,0 +1,499 @@
+// 前处理和后处理热点函数的微基准测试, 使用 640x640/1024x1024 图像,
+// 8400 个 anchor 的输出和 10-1000 个候选框
+// ./build/release/bin/bench_kernels --benchmark_filter=NMS
+// ./build/release/bin/bench_kernels --benchmark_format=json
+
+#include <benchmark/benchmark.h>
+
+#include "modelzoo/common/batch_preprocess.h"
+#include "modelzoo/common/img_common.hpp"
+#include "modelzoo/common/nms.h"
+#include "modelzoo/common/preprocess.h"
+#include "modelzoo/common/rotated_nms.h"
+#include "modelzoo/common/yolo_decode.h"
+#include "modelzoo/common/yolo_head.hpp"
+#include "modelzoo/common/yolo_seg_mask.h"
+#include "modelzoo/yolo11n_obb/yolo11n_obb.h"
+
+#include <cmath>
+#include <random>
+#include <thread>
+
+namespace {
+
+constexpr int kAnchorNum = 8400;
+constexpr int kClassNum = 80;
+// 输入图像为 1080p, letterbox 到 640 时缩放 3 倍
+const cv::Size kRawSize(1920, 1080);
+
+cv::Mat RandomImage(const cv::Size &size) {
+  cv::Mat img(size, CV_8UC3);
+  cv::randu(img, cv::Scalar::all(0), cv::Scalar::all(255));
+  return img;
+}
+
+// 候选框聚集在若干个目标附近, 与真实检测输出一样有大量重叠
+struct Candidates {
+  std::vector<cv::Rect> boxes;
+  std::vector<float> scores;
+  std::vector<modelzoo::Yolo11NObb::Box> obb_boxes;
+};
+
+Candidates RandomCandidates(int num, int class_num) {
+  std::mt19937 rng(num);
+  std::uniform_real_distribution<float> center(50.f, 590.f);
+  std::uniform_real_distribution<float> size(20.f, 120.f);
+  std::normal_distribution<float> jitter(0.f, 4.f);
+  std::uniform_real_distribution<float> score(0.1f, 1.f);
+  std::uniform_real_distribution<float> angle(0.f, 1.5f);
+
+  Candidates candidates;
+  int object_num = std::max(1, num / 5);
+  for (int i = 0; i < num; i++) {
+    std::mt19937 object_rng(i % object_num);
+    float cx = center(object_rng), cy = center(object_rng);
+    float w = size(object_rng), h = size(object_rng);
+    float a = angle(object_rng);
+    int class_id = (i % object_num) % class_num;
+    cx += jitter(rng);
+    cy += jitter(rng);
+    w += jitter(rng);
+    h += jitter(rng);
+    float s = score(rng);
+    candidates.boxes.emplace_back(int(cx - w / 2), int(cy - h / 2), int(w),
+                                  int(h));
+    candidates.scores.push_back(s);
+    candidates.obb_boxes.push_back({{cx, cy, w, h}, a, s, class_id});
+  }
+  return candidates;
+}
+
+// [4 + class_num + extra, anchor_num] 的 YOLO 输出, 约 1% 的 anchor 分数超过阈值
+cv::Mat RandomYoloOutput(int class_num, int extra_num) {
+  int rows = 4 + class_num + extra_num;
+  cv::Mat output(rows, kAnchorNum, CV_32F);
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> low_score(0.f, 0.05f);
+  std::uniform_real_distribution<float> high_score(0.3f, 0.9f);
+  std::uniform_real_distribution<float> extra(-1.f, 1.f);
+  auto candidates = RandomCandidates(kAnchorNum, class_num);
+  for (int i = 0; i < kAnchorNum; i++) {
+    // 目标在 640x360 的有效区域内, 还原到 1080p 后不越界
+    const auto &obb = candidates.obb_boxes[i];
+    output.at<float>(0, i) = obb.box[0];
+    output.at<float>(1, i) = obb.box[1] * 0.5f + 20.f;
+    output.at<float>(2, i) = std::min(obb.box[2], 60.f);
+    output.at<float>(3, i) = std::min(obb.box[3], 30.f);
+    for (int c = 0; c < class_num; c++) {
+      output.at<float>(4 + c, i) = low_score(rng);
+    }
+    if (i % 100 == 0) {
+      output.at<float>(4 + obb.class_id, i) = high_score(rng);
+    }
+    for (int e = 0; e < extra_num; e++) {
+      output.at<float>(4 + class_num + e, i) = extra(rng);
+    }
+  }
+  return output;
+}
+
+void BM_LetterBoxPadImage(benchmark::State &state) {
+  int size = state.range(0);
+  auto img = RandomImage(kRawSize);
+  for (auto _ : state) {
+    auto result = imgutils::LetterBoxPadImage(img, cv::Size(size, size));
+    benchmark::DoNotOptimize(result);
+  }
+}
+BENCHMARK(BM_LetterBoxPadImage)
+    ->Arg(640)
+    ->Arg(1024)
+    ->Unit(benchmark::kMicrosecond);
+
+void BM_BlobNormalizeFromImage(benchmark::State &state) {
+  int size = state.range(0);
+  auto data_type = (inference::TensorDataType)state.range(1);
+  auto img = RandomImage(cv::Size(size, size));
+  std::vector<float> blob(3 * size * size);
+  for (auto _ : state) {
+    imgutils::BlobNormalizeFromImage(img, blob.data(), data_type);
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(state.iterations() * img.total() * img.elemSize());
+}
+BENCHMARK(BM_BlobNormalizeFromImage)
+    ->Args({640, inference::kFP32})
+    ->Args({640, inference::kFP16})
+    ->Args({1024, inference::kFP32})
+    ->Args({1024, inference::kFP16})
+    ->Unit(benchmark::kMicrosecond);
+
+// args: 图像大小, SimdLevel(-1 为当前 CPU 支持的最高指令集), 是否输出 FP16,
+// 是否按行并行
+void BM_HwcToChw(benchmark::State &state) {
+  int size = state.range(0);
+  auto level = state.range(1) < 0 ? imgutils::GetSimdLevel()
+                                  : (imgutils::SimdLevel)state.range(1);
+  bool fp16 = state.range(2);
+  bool parallel = state.range(3);
+  if (level > imgutils::GetSimdLevel()) {
+    state.SkipWithError("simd level not supported");
+    return;
+  }
+  state.SetLabel(imgutils::SimdLevelName(level));
+  auto img = RandomImage(cv::Size(size, size));
+  std::vector<float> blob(3 * size * size);
+  for (auto _ : state) {
+    if (fp16) {
+      imgutils::HwcToChw(img, (half_float::half *)blob.data(), 1.0f / 255.0f,
+                         level, parallel);
+    } else {
+      imgutils::HwcToChw(img, blob.data(), 1.0f / 255.0f, level, parallel);
+    }
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(state.iterations() * img.total() * img.elemSize());
+}
+BENCHMARK(BM_HwcToChw)
+    ->ArgsProduct({{640, 1024}, {0, 1, 2, 3}, {0, 1}, {0}})
+    ->ArgsProduct({{1024}, {-1}, {0, 1}, {1}})
+    ->Unit(benchmark::kMicrosecond);
+
+// LetterBoxPadImage + BlobNormalizeFromImage 与融合实现的对比
+void BM_LetterBoxBlob(benchmark::State &state) {
+  int size = state.range(0);
+  auto img = RandomImage(kRawSize);
+  std::vector<float> blob(3 * size * size);
+  for (auto _ : state) {
+    auto [dst_img, scale] =
+        imgutils::LetterBoxPadImage(img, cv::Size(size, size));
+    imgutils::BlobNormalizeFromImage(dst_img, blob.data(), inference::kFP32);
+    benchmark::ClobberMemory();
+  }
+}
+BENCHMARK(BM_LetterBoxBlob)
+    ->Arg(640)
+    ->Arg(1024)
+    ->Unit(benchmark::kMicrosecond);
+
+void BM_LetterBoxPreprocessor(benchmark::State &state) {
+  int size = state.range(0);
+  auto img = RandomImage(kRawSize);
+  std::vector<float> blob(3 * size * size);
+  imgutils::PreprocessSpec spec;
+  spec.size = cv::Size(size, size);
+  imgutils::Preprocessor preprocessor(spec);
+  for (auto _ : state) {
+    imgutils::PreprocessInfo info;
+    preprocessor.Run(img, blob.data(), &info);
+    benchmark::ClobberMemory();
+  }
+}
+BENCHMARK(BM_LetterBoxPreprocessor)
+    ->Arg(640)
+    ->Arg(1024)
+    ->Unit(benchmark::kMicrosecond);
+
+// args: 线程池的线程数, 0 时在调用线程中串行执行
+void BM_BlobNormalizeBatch(benchmark::State &state) {
+  const int batch_size = 32;
+  const int size = 640;
+  int thread_num = state.range(0);
+  std::vector<cv::Mat> imgs(batch_size, RandomImage(cv::Size(size, size)));
+  std::vector<float> blob(batch_size * 3 * size * size);
+  inference::TensorDataPointer tensor;
+  tensor.data_type = inference::kFP32;
+  tensor.mem_size = 3 * size * size * sizeof(float);
+  for (int i = 0; i < batch_size; i++) {
+    tensor.p_arr.push_back(blob.data() + i * 3 * size * size);
+  }
+  std::unique_ptr<inference::ThreadPool> pool;
+  if (thread_num > 0) {
+    pool = std::make_unique<inference::ThreadPool>(thread_num);
+  }
+  for (auto _ : state) {
+    imgutils::BlobNormalizeBatch(pool.get(), imgs, tensor);
+    benchmark::ClobberMemory();
+  }
+}
+BENCHMARK(BM_BlobNormalizeBatch)
+    ->Arg(0)
+    ->Arg(std::max(1, (int)std::thread::hardware_concurrency() - 1))
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+void BM_Softmax(benchmark::State &state) {
+  int len = state.range(0);
+  std::vector<float> input(len);
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> dist(-10.f, 10.f);
+  for (auto &v : input) {
+    v = dist(rng);
+  }
+  for (auto _ : state) {
+    auto result = imgutils::Softmax(input.data(), len * sizeof(float),
+                                    inference::kFP32);
+    benchmark::DoNotOptimize(result);
+  }
+}
+BENCHMARK(BM_Softmax)->Arg(10)->Arg(1000)->Arg(kAnchorNum);
+
+void BM_DecodeYoloDetect(benchmark::State &state) {
+  auto data_type = (inference::TensorDataType)state.range(0);
+  cv::Mat output = RandomYoloOutput(kClassNum, 0);
+  if (data_type == inference::kFP16) {
+    output.convertTo(output, CV_16F);
+  }
+  inference::TensorDataPointer o_tensor(
+      output.data, output.total() * output.elemSize(), output.total(),
+      {1, output.rows, output.cols}, data_type, inference::kCPU);
+  imgutils::Threshold threshold = {0.25f, 0.5f};
+  for (auto _ : state) {
+    std::vector<imgutils::DetectBox> result;
+    imgutils::DecodeYoloDetect(o_tensor, kClassNum, threshold, 3.f, &result);
+    benchmark::DoNotOptimize(result);
+  }
+}
+BENCHMARK(BM_DecodeYoloDetect)
+    ->Arg(inference::kFP32)
+    ->Arg(inference::kFP16)
+    ->Unit(benchmark::kMicrosecond);
+
+// args: SimdLevel, 输出的数据类型; 只包含解码, 不包含 NMS
+void BM_DecodeYoloHead(benchmark::State &state) {
+  auto level = (imgutils::SimdLevel)state.range(0);
+  auto data_type = (inference::TensorDataType)state.range(1);
+  if (level > imgutils::GetSimdLevel()) {
+    state.SkipWithError("simd level not supported");
+    return;
+  }
+  state.SetLabel(imgutils::SimdLevelName(level));
+  cv::Mat output = RandomYoloOutput(kClassNum, 0);
+  if (data_type == inference::kFP16) {
+    output.convertTo(output, CV_16F);
+  }
+  inference::TensorDataPointer o_tensor(
+      output.data, output.total() * output.elemSize(), output.total(),
+      {1, output.rows, output.cols}, data_type, inference::kCPU);
+  imgutils::YoloCandidates candidates;
+  for (auto _ : state) {
+    imgutils::DecodeYoloHead(o_tensor, kClassNum, 0.25f, level, &candidates);
+    benchmark::DoNotOptimize(candidates);
+  }
+}
+BENCHMARK(BM_DecodeYoloHead)
+    ->ArgsProduct({{0, 1, 2}, {inference::kFP32, inference::kFP16}})
+    ->Unit(benchmark::kMicrosecond);
+
+// 编译期特化的输出头与运行期通用版本的对比, 80 类, FP32
+template <typename Head>
+void BM_DecodeYoloHeadAs(benchmark::State &state) {
+  cv::Mat output = RandomYoloOutput(kClassNum, 0);
+  const auto &kernels = imgutils::GetYoloRowKernels(imgutils::GetSimdLevel());
+  imgutils::YoloCandidates candidates;
+  for (auto _ : state) {
+    imgutils::DecodeYoloHead<Head>((const float *)output.data, output.cols,
+                                   kClassNum, 0, 0.25f, kernels, &candidates);
+    benchmark::DoNotOptimize(candidates);
+  }
+}
+BENCHMARK_TEMPLATE(BM_DecodeYoloHeadAs, imgutils::YoloV8DetectHead)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_DecodeYoloHeadAs, imgutils::DynamicYoloHead)
+    ->Unit(benchmark::kMicrosecond);
+
+void BM_NMSBoxes(benchmark::State &state) {
+  auto candidates = RandomCandidates(state.range(0), kClassNum);
+  for (auto _ : state) {
+    std::vector<int> indices;
+    cv::dnn::NMSBoxes(candidates.boxes, candidates.scores, 0.25f, 0.5f,
+                      indices);
+    benchmark::DoNotOptimize(indices);
+  }
+}
+BENCHMARK(BM_NMSBoxes)
+    ->Arg(10)
+    ->Arg(100)
+    ->Arg(1000)
+    ->Arg(5000)
+    ->Unit(benchmark::kMicrosecond);
+
+// args: 候选框数, 是否按类别, 与上面的 cv::dnn::NMSBoxes 对比
+void BM_Nms(benchmark::State &state) {
+  auto candidates = RandomCandidates(state.range(0), kClassNum);
+  imgutils::NmsBoxes boxes;
+  for (size_t i = 0; i < candidates.boxes.size(); i++) {
+    const auto &box = candidates.boxes[i];
+    boxes.AddXYWH(box.x, box.y, box.width, box.height, candidates.scores[i],
+                  candidates.obb_boxes[i].class_id);
+  }
+  imgutils::NmsParams params;
+  params.class_aware = state.range(1);
+  for (auto _ : state) {
+    std::vector<int> indices;
+    imgutils::Nms(boxes, params, &indices);
+    benchmark::DoNotOptimize(indices);
+  }
+}
+BENCHMARK(BM_Nms)
+    ->ArgsProduct({{10, 100, 1000, 5000}, {0, 1}})
+    ->Unit(benchmark::kMicrosecond);
+
+// 改为 imgutils::RotatedNms 之前 Yolo11NObb 中的 ProbiouNMS, 逐对计算
+// probiou, 作为 BM_RotatedNms 的对比基线
+namespace legacy {
+
+void covariance_matrix(float w, float h, float r, float &a_val, float &b_val,
+                       float &c_val) {
+  // 检查输入参数的有效性
+  if (w < 0 || h < 0) {
+    a_val = b_val = c_val = 0;
+    return;
+  }
+  float a = (w * w) / 12;
+  float b = (h * h) / 12;
+  float cos_r = cosf(r);
+  float sin_r = sinf(r);
+
+  a_val = a * cos_r * cos_r + b * sin_r * sin_r;
+  b_val = a * sin_r * sin_r + b * cos_r * cos_r;
+  c_val = (a - b) * sin_r * cos_r;
+}
+
+float square(float x) {
+  return x * x; // 返回输入数的平方
+}
+
+using YoloTempBox = modelzoo::Yolo11NObb::Box;
+
+float probiou2(const YoloTempBox &obb1, const YoloTempBox &obb2, float eps) {
+  float a1, b1, c1;
+  float a2, b2, c2;
+
+  covariance_matrix(obb1.box[2], obb1.box[3], obb1.angle, a1, b1, c1);
+  covariance_matrix(obb2.box[2], obb2.box[3], obb2.angle, a2, b2, c2);
+
+  float x1 = obb1.box[0] + obb1.box[2] / 2;
+  float y1 = obb1.box[1] + obb1.box[3] / 2;
+  float x2 = obb2.box[0] + obb2.box[2] / 2;
+  float y2 = obb2.box[1] + obb2.box[3] / 2;
+
+  float t1 = ((a1 + a2) * square(y1 - y2) + (b1 + b2) * square(x1 - x2)) /
+             ((a1 + a2) * (b1 + b2) - square(c1 + c2) + eps);
+  float t2 = ((c1 + c2) * (x2 - x1) * (y1 - y2)) /
+             ((a1 + a2) * (b1 + b2) - square(c1 + c2) + eps);
+  float t3 = log(
+      ((a1 + a2) * (b1 + b2) - square(c1 + c2)) /
+          (4 * sqrt(a1 * b1 - square(c1)) * sqrt(a2 * b2 - square(c2)) + eps) +
+      eps);
+
+  float bd = 0.25f * t1 + 0.5f * t2 + 0.5f * t3;
+  float hd = sqrtf(1.0f - expf(-fminf(fmaxf(bd, eps), 100.0f)) + eps);
+
+  return 1.0f - hd;
+}
+
+void ProbiouNMS(std::vector<YoloTempBox> &yolo_temp_boxes, float nmsThresh) {
+  std::sort(yolo_temp_boxes.begin(), yolo_temp_boxes.end(),
+            [](const YoloTempBox &a, const YoloTempBox &b) {
+              return a.score > b.score;
+            });
+  std::vector<bool> remove_flags(yolo_temp_boxes.size(), false);
+
+  for (size_t i = 0; i < yolo_temp_boxes.size(); ++i) {
+    if (remove_flags[i] || yolo_temp_boxes[i].score == 0)
+      continue;
+
+    for (size_t j = i + 1; j < yolo_temp_boxes.size(); ++j) {
+      if (remove_flags[j] || yolo_temp_boxes[j].score == 0 ||
+          yolo_temp_boxes[i].class_id != yolo_temp_boxes[j].class_id)
+        continue;
+
+      if (probiou2(yolo_temp_boxes[i], yolo_temp_boxes[j], 1e-7) > nmsThresh) {
+        remove_flags[j] = true;
+      }
+    }
+  }
+  std::vector<YoloTempBox> newBoxes;
+  for (size_t i = 0; i < yolo_temp_boxes.size(); ++i) {
+    if (!remove_flags[i]) {
+      newBoxes.push_back(yolo_temp_boxes[i]);
+    }
+  }
+  yolo_temp_boxes = std::move(newBoxes);
+}
+
+} // namespace legacy
+
+// args: 候选框数, 与 BM_RotatedNms/x/1 使用相同的输入, 只支持按类别;
+// 每次迭代包含一次候选框的拷贝
+void BM_ProbiouNMSLegacy(benchmark::State &state) {
+  auto candidates = RandomCandidates(state.range(0), 15);
+  for (auto _ : state) {
+    auto boxes = candidates.obb_boxes;
+    legacy::ProbiouNMS(boxes, 0.45f);
+    benchmark::DoNotOptimize(boxes);
+  }
+}
+BENCHMARK(BM_ProbiouNMSLegacy)
+    ->Arg(10)
+    ->Arg(100)
+    ->Arg(1000)
+    ->Arg(5000)
+    ->Unit(benchmark::kMicrosecond);
+
+// args: 候选框数, 是否按类别, 不包含 Yolo11NObb::Box 的转换
+void BM_RotatedNms(benchmark::State &state) {
+  auto candidates = RandomCandidates(state.range(0), 15);
+  imgutils::RotatedNmsBoxes boxes;
+  for (const auto &obb : candidates.obb_boxes) {
+    boxes.Add(obb.box[0], obb.box[1], obb.box[2], obb.box[3], obb.angle,
+              obb.score, obb.class_id);
+  }
+  imgutils::NmsParams params;
+  params.score_threshold = 0.0f;
+  params.iou_threshold = 0.45f;
+  params.class_aware = state.range(1);
+  for (auto _ : state) {
+    std::vector<int> indices;
+    imgutils::RotatedNms(boxes, params, &indices);
+    benchmark::DoNotOptimize(indices);
+  }
+}
+BENCHMARK(BM_RotatedNms)
+    ->ArgsProduct({{10, 100, 1000, 5000}, {0, 1}})
+    ->Unit(benchmark::kMicrosecond);
+
+cv::Mat RandomSegProtos() {
+  cv::Mat protos(std::vector<int>{1, 32, 160, 160}, CV_32F);
+  cv::randn(protos, 0, 1);
+  return protos;
+}
+
+// args: 目标框边长, 原图 1920x1080 letterbox 到 640x640
+void BM_DecodeYoloSegMask(benchmark::State &state) {
+  int box_size = state.range(0);
+  float scale = kRawSize.width / 640.f;
+  cv::Vec4f trans(1.0f / scale, 1.0f / scale, 0, 0);
+  cv::Mat protos = RandomSegProtos();
+  cv::Mat mask_coeffs(1, 32, CV_32F);
+  cv::randn(mask_coeffs, 0, 1);
+  cv::Rect bound(600, 300, box_size, box_size);
+  for (auto _ : state) {
+    cv::Mat mask;
+    std::vector<cv::Point> contour;
+    imgutils::DecodeYoloSegMask(mask_coeffs, protos, trans, kRawSize,
+                                cv::Size(640, 640), bound, 0.5f, &mask,
+                                &contour);
+    benchmark::DoNotOptimize(contour);
+  }
+}
+BENCHMARK(BM_DecodeYoloSegMask)
+    ->Arg(64)
+    ->Arg(256)
+    ->Arg(512)
+    ->Unit(benchmark::kMicrosecond);
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,71 @@
+// 对比使用优化模型缓存前后 engine Init 的耗时
+// ./build/debug/bin/experiment_init_cache --model_path
+// modelzoo/yolov8n/data/yolov8n.onnx --graph_optimize_level 99
+
+#include <gflags/gflags.h>
+
+#include "inference/onnxruntime/onnxruntime.h"
+#include <cpptoolkit/log/log.h>
+
+#include <chrono>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+DEFINE_string(model_path, "modelzoo/yolov8n/data/yolov8n.onnx", "model path");
+DEFINE_string(cache_dir, "build/optimized_model_cache", "cache dir");
+DEFINE_string(device, "cpu", "cpu or gpu");
+DEFINE_int32(graph_optimize_level, 99, "graph optimize level");
+DEFINE_int32(repeat, 5, "init repeat times");
+
+namespace {
+
+double InitCostMs(const inference::InferenceParams &params) {
+  inference::OnnxRuntimeEngine engine;
+  auto start = std::chrono::steady_clock::now();
+  int ret = engine.Init(params);
+  auto end = std::chrono::steady_clock::now();
+  if (ret != 0) {
+    LOG_ERROR("init engine failed: {}", ret);
+    return -1;
+  }
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+double AvgInitCostMs(const inference::InferenceParams &params, int repeat) {
+  double sum = 0;
+  for (int i = 0; i < repeat; i++) {
+    sum += InitCostMs(params);
+  }
+  return sum / repeat;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  cpptoolkit::LogInit();
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  auto params = inference::GetDefaultOnnxRuntimeEngineParams();
+  params.model_path = FLAGS_model_path;
+  params.device_type =
+      FLAGS_device == "gpu" ? inference::kGPU : inference::kCPU;
+  params.graph_optimize_level = FLAGS_graph_optimize_level;
+
+  std::error_code ec;
+  fs::remove_all(FLAGS_cache_dir, ec);
+
+  double no_cache_ms = AvgInitCostMs(params, FLAGS_repeat);
+
+  params.optimized_model_cache_dir = FLAGS_cache_dir;
+  double write_cache_ms = InitCostMs(params);
+  double hit_cache_ms = AvgInitCostMs(params, FLAGS_repeat);
+
+  LOG_INFO("model: {}, graph_optimize_level: {}, repeat: {}", FLAGS_model_path,
+           FLAGS_graph_optimize_level, FLAGS_repeat);
+  LOG_INFO("| {:<16} | {:>12} |", "case", "init (ms)");
+  LOG_INFO("| {:<16} | {:>12.3f} |", "no cache", no_cache_ms);
+  LOG_INFO("| {:<16} | {:>12.3f} |", "write cache", write_cache_ms);
+  LOG_INFO("| {:<16} | {:>12.3f} |", "hit cache", hit_cache_ms);
+  return 0;
+}
@@ -0,0 +1,117 @@
+// 使用 onnxruntime 性能分析统计每个算子类型和节点的耗时, 可以对比两次结果
+// ./build/debug/bin/experiment_profile --model_path
+// modelzoo/yolov8n/data/yolov8n.onnx --repeat 100
+// 对比重新导出的模型:
+// ./build/debug/bin/experiment_profile --model_path new.onnx
+// --base_profile build/profile/onnxruntime_profile_xxx.json
+// 只汇总已有的文件:
+// ./build/debug/bin/experiment_profile --profile_files a.json,b.json
+
+#include <gflags/gflags.h>
+
+#include "inference/onnxruntime/onnxruntime.h"
+#include "inference/onnxruntime/onnxruntime_profile.h"
+#include <cpptoolkit/log/log.h>
+#include <cpptoolkit/strings/to_string.h>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+DEFINE_string(model_path, "modelzoo/yolov8n/data/yolov8n.onnx", "model path");
+DEFINE_string(device, "cpu", "cpu or gpu");
+DEFINE_int32(graph_optimize_level, 99, "graph optimize level");
+DEFINE_int32(intra_op_num_threads, 1, "intra op num threads");
+DEFINE_int32(max_batch_size, 1, "max batch size of dynamic model");
+DEFINE_int32(batch_size, -1, "run batch size, -1 for default");
+DEFINE_int32(repeat, 100, "run repeat times");
+DEFINE_string(profile_prefix, "build/profile/onnxruntime_profile",
+              "profile output prefix");
+DEFINE_string(profile_files, "",
+              "comma separated profile files, summarize them without running");
+DEFINE_string(base_profile, "",
+              "comma separated profile files to compare with");
+DEFINE_int32(top_n, 20, "print top n op types and nodes, <= 0 for all");
+
+namespace {
+
+std::vector<std::string> SplitFiles(const std::string &files) {
+  std::vector<std::string> result;
+  std::stringstream ss(files);
+  std::string file;
+  while (std::getline(ss, file, ',')) {
+    if (!file.empty()) {
+      result.push_back(file);
+    }
+  }
+  return result;
+}
+
+// 推理耗时与输入内容基本无关, 所有输入填 0
+int RunProfile(std::vector<std::string> *profile_files) {
+  auto params = inference::GetDefaultOnnxRuntimeEngineParams();
+  params.model_path = FLAGS_model_path;
+  params.device_type =
+      FLAGS_device == "gpu" ? inference::kGPU : inference::kCPU;
+  params.graph_optimize_level = FLAGS_graph_optimize_level;
+  params.intra_op_num_threads = FLAGS_intra_op_num_threads;
+  params.max_batch_size = FLAGS_max_batch_size;
+  params.enable_profiling = true;
+  params.profile_prefix = FLAGS_profile_prefix;
+
+  std::error_code ec;
+  fs::create_directories(fs::path(FLAGS_profile_prefix).parent_path(), ec);
+
+  inference::OnnxRuntimeEngine engine;
+  if (engine.Init(params) != 0) {
+    LOG_ERROR("init engine failed, model: {}", FLAGS_model_path);
+    return -1;
+  }
+  for (auto &[name, tensor] : engine.GetInputTensors()) {
+    size_t batch_num = std::max<size_t>(1, tensor.p_arr.size());
+    memset(tensor.p, 0, tensor.mem_size * batch_num);
+  }
+  for (int i = 0; i < FLAGS_repeat; i++) {
+    if (engine.Run(FLAGS_batch_size) != 0) {
+      LOG_ERROR("run engine failed");
+      return -1;
+    }
+  }
+  LOG_INFO("{}", cpptoolkit::ToString(engine.GetStats()));
+  *profile_files = engine.EndProfiling();
+  return profile_files->empty() ? -1 : 0;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  cpptoolkit::LogInit();
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  auto profile_files = SplitFiles(FLAGS_profile_files);
+  if (profile_files.empty() && RunProfile(&profile_files) != 0) {
+    return -1;
+  }
+
+  inference::ProfileSummary summary;
+  if (inference::ParseOnnxRuntimeProfile(profile_files, &summary) != 0) {
+    return -1;
+  }
+  LOG_INFO("model: {}, profile files: {}\n{}", FLAGS_model_path,
+           cpptoolkit::ToString(profile_files),
+           inference::DumpProfileSummary(summary, FLAGS_top_n));
+
+  auto base_files = SplitFiles(FLAGS_base_profile);
+  if (!base_files.empty()) {
+    inference::ProfileSummary base;
+    if (inference::ParseOnnxRuntimeProfile(base_files, &base) != 0) {
+      return -1;
+    }
+    LOG_INFO("compare with: {}\n{}", cpptoolkit::ToString(base_files),
+             inference::DumpProfileDiff(base, summary, FLAGS_top_n));
+  }
+  return 0;
+}
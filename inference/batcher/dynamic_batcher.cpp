@@ -0,0 +1,174 @@
+#include "inference/batcher/dynamic_batcher.h"
+
+#include <cpptoolkit/log/log.h>
+
+namespace inference {
+
+namespace {
+
+template <typename TensorPointers>
+std::vector<TensorPointers> SplitBatchSlots(const TensorPointers &tensors,
+                                            int batch_size) {
+  std::vector<TensorPointers> slots(batch_size);
+  for (auto &[name, tensor] : tensors) {
+    for (int i = 0; i < batch_size; i++) {
+      TensorDataPointer slot = tensor;
+      slot.p = tensor.p_arr.empty() ? tensor.p : tensor.p_arr[i];
+      slot.p_arr.clear();
+      slots[i][name] = std::move(slot);
+    }
+  }
+  return slots;
+}
+
+} // namespace
+
+int DynamicBatcher::Init(InferenceEngine *engine,
+                         const DynamicBatcherParams &params) {
+  if (ready_) {
+    LOG_WARN("DynamicBatcher::Init: batcher is ready, deinit first");
+    Deinit();
+  }
+
+  if (!engine || !engine->IsReady()) {
+    LOG_ERROR("DynamicBatcher::Init: engine is not ready");
+    return -1;
+  }
+  if (!engine->IsDynamicModel()) {
+    LOG_ERROR("DynamicBatcher::Init: engine must be dynamic model");
+    return -1;
+  }
+
+  max_batch_size_ = engine->GetMaxBatchSize();
+  if (params.max_batch_size > 0 && params.max_batch_size < max_batch_size_) {
+    max_batch_size_ = params.max_batch_size;
+  }
+  max_wait_ = std::chrono::microseconds(std::max(params.max_wait_us, 0));
+
+  ctx_ = engine->CreateExecContext();
+  if (!ctx_) {
+    LOG_ERROR("DynamicBatcher::Init: create exec context failed");
+    return -1;
+  }
+  input_slots_ = SplitBatchSlots(ctx_->GetInputTensors(), max_batch_size_);
+  output_slots_ = SplitBatchSlots(ctx_->GetOutputTensors(), max_batch_size_);
+
+  stop_ = false;
+  worker_ = std::thread([this]() { WorkerLoop(); });
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ready_ = true;
+  }
+  return 0;
+}
+
+void DynamicBatcher::Deinit() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ready_ = false;
+    stop_ = true;
+  }
+  cv_.notify_all();
+  if (worker_.joinable()) {
+    worker_.join();
+  }
+
+  input_slots_.clear();
+  output_slots_.clear();
+  ctx_.reset();
+}
+
+std::future<int> DynamicBatcher::Submit(SampleFillFunc fill,
+                                        SampleGatherFunc gather) {
+  Request request;
+  request.fill = std::move(fill);
+  request.gather = std::move(gather);
+  request.enqueue_time = std::chrono::steady_clock::now();
+  auto future = request.promise.get_future();
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!ready_ || stop_) {
+      LOG_ERROR("DynamicBatcher::Submit: batcher is not ready");
+      request.promise.set_value(-1);
+      return future;
+    }
+    requests_.push_back(std::move(request));
+  }
+  cv_.notify_one();
+  return future;
+}
+
+void DynamicBatcher::WorkerLoop() {
+  std::vector<Request> batch;
+  batch.reserve(max_batch_size_);
+
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this]() { return stop_ || !requests_.empty(); });
+      if (requests_.empty()) {
+        return;
+      }
+
+      // 以最早的请求为准等待凑满 batch, 退出时不再等待
+      auto deadline = requests_.front().enqueue_time + max_wait_;
+      cv_.wait_until(lock, deadline, [this]() {
+        return stop_ || requests_.size() >= (size_t)max_batch_size_;
+      });
+
+      int batch_size = std::min((int)requests_.size(), max_batch_size_);
+      for (int i = 0; i < batch_size; i++) {
+        batch.push_back(std::move(requests_.front()));
+        requests_.pop_front();
+      }
+    }
+
+    RunBatch(batch);
+    batch.clear();
+  }
+}
+
+void DynamicBatcher::RunBatch(std::vector<Request> &batch) {
+  // 填充失败的请求不占用 slot
+  std::vector<Request *> filled;
+  filled.reserve(batch.size());
+  for (auto &request : batch) {
+    int slot = filled.size();
+    int ret = -1;
+    try {
+      ret = request.fill(input_slots_[slot]);
+    } catch (const std::exception &e) {
+      LOG_ERROR("DynamicBatcher: fill sample failed: {}", e.what());
+    }
+    if (ret != 0) {
+      request.promise.set_value(ret);
+      continue;
+    }
+    filled.push_back(&request);
+  }
+  if (filled.empty()) {
+    return;
+  }
+
+  int ret = ctx_->Run(filled.size());
+  if (ret != 0) {
+    LOG_ERROR("DynamicBatcher: run batch:{} failed: {}", filled.size(), ret);
+  }
+
+  for (int i = 0; i < filled.size(); i++) {
+    auto *request = filled[i];
+    if (ret == 0 && request->gather) {
+      try {
+        request->gather(output_slots_[i]);
+      } catch (const std::exception &e) {
+        LOG_ERROR("DynamicBatcher: gather sample failed: {}", e.what());
+        request->promise.set_value(-1);
+        continue;
+      }
+    }
+    request->promise.set_value(ret);
+  }
+}
+
+} // namespace inference
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "inference/inference_engine.h"
+#include <cpptoolkit/construct/construct.h>
+
+namespace inference {
+
+struct DynamicBatcherParams {
+  // 单次合并的最大 batch, <= 0 时使用 engine 的 max batch size
+  int max_batch_size = -1;
+  // 第一个请求到达后最多等待多久凑 batch
+  int max_wait_us = 1000;
+};
+
+// 单个样本的输入输出视图, p 指向该样本在 batch 中的 slot, shape[0] 为 1
+using SampleFillFunc = std::function<int(const InputTensorPointers &inputs)>;
+using SampleGatherFunc =
+    std::function<void(const OutputTensorPointers &outputs)>;
+
+/**
+ * @brief 动态 batch 调度器
+ *
+ * 多个线程提交单样本请求, 工作线程按照 max_batch_size/max_wait_us
+ * 合并成一个 batch 推理一次, 再把每个样本的输出分发回各自的请求
+ *
+ * fill 和 gather 回调在调度器的工作线程中执行, 只应做拷贝这类轻量操作
+ */
+class DynamicBatcher {
+public:
+  DynamicBatcher() {}
+  ~DynamicBatcher() { Deinit(); }
+
+  CPP_TK_NON_COPY_CONSTRUCT(DynamicBatcher);
+  CPP_TK_NON_MOVE_CONSTRUCT(DynamicBatcher);
+
+  // engine 必须是已经初始化的动态 batch 模型, 且生命周期长于 batcher
+  int Init(InferenceEngine *engine, const DynamicBatcherParams &params = {});
+  void Deinit();
+
+  bool IsReady() const { return ready_.load(); }
+  int GetMaxBatchSize() const { return max_batch_size_; }
+
+  /**
+   * @brief 提交一个单样本请求
+   *
+   * @param fill 将样本写入 inputs 对应的 slot, 返回非 0 表示失败
+   * @param gather 推理成功后从 outputs 对应的 slot 读取结果
+   * @return future 的值为 0 表示成功
+   */
+  std::future<int> Submit(SampleFillFunc fill, SampleGatherFunc gather);
+
+private:
+  struct Request {
+    SampleFillFunc fill;
+    SampleGatherFunc gather;
+    std::promise<int> promise;
+    std::chrono::steady_clock::time_point enqueue_time;
+  };
+
+  void WorkerLoop();
+  void RunBatch(std::vector<Request> &batch);
+
+  // 在 mutex_ 中写入, Submit 在 mutex_ 中读取, IsReady 不加锁读取
+  std::atomic<bool> ready_{false};
+  int max_batch_size_ = 1;
+  std::chrono::microseconds max_wait_{0};
+
+  InferenceExecContextUPtr ctx_ = nullptr;
+  std::vector<InputTensorPointers> input_slots_;
+  std::vector<OutputTensorPointers> output_slots_;
+
+  std::deque<Request> requests_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool stop_ = false;
+  std::thread worker_;
+};
+
+} // namespace inference
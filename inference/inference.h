@@ -1,11 +1,25 @@
 #pragma once
 
 #include "inference/tensor/tensor.h"
+#include "inference/utils/mapped_file.h"
 #include <cpptoolkit/exception/exception.h>
 #include <unordered_map>
+#include <vector>
 
 namespace inference {
 
+enum ModelLoadMode {
+  // onnxruntime 直接读取 model_path
+  kModelLoadFile = 0,
+  // 每个 engine 单独 mmap 模型文件
+  kModelLoadMmap = 1,
+  // 进程内同一个模型文件只 mmap 一次, 所有 engine 共享这份只读映射;
+  // .onnx 模型仍然由 onnxruntime 解析出自己的一份拷贝, 只节省文件读取,
+  // 不节省常驻内存; .ort 格式模型的权重和 weight_path 外部数据的权重
+  // 直接引用这份映射, 不再拷贝到各个 session, 所有 engine 共享同一份内存
+  kModelLoadSharedMmap = 2,
+};
+
 struct InferenceParams {
   // device
   DeviceType device_type = kCPU;
@@ -15,17 +29,72 @@ struct InferenceParams {
   std::string model_path;
   std::string weight_path;
 
+  // 从内存加载模型, 优先级: model_data > model_mapping > model_path;
+  // model_data 由调用方持有, 需要在 engine Deinit 之前保持有效
+  const void *model_data = nullptr;
+  size_t model_data_size = 0;
+  // 已经映射好的模型文件, engine 会持有引用直到 Deinit
+  MappedFileSPtr model_mapping = nullptr;
+  // 从 model_path 加载时的方式, 从内存加载时 weight_path(外部数据文件)
+  // 同样按该方式映射, 文件名需要和模型中记录的外部数据路径一致
+  ModelLoadMode model_load_mode = kModelLoadFile;
+
+  // onnxruntime 日志等级, 进程内共享的 Ort::Env 由第一个 engine 创建,
+  // 之后 engine 的 log_level 不生效
   int log_level = -1;
 
   // max batch size for inference, only used when model is dynamic
   int max_batch_size = 1;
 
+  // 动态 batch 模型的分桶, 例如 {1, 2, 4, 8}, 为空时使用动态 shape 推理;
+  // 每个桶通过固定 batch 维创建一个静态 shape 的 session,
+  // Run(batch_size) 使用能容纳 batch_size 的最小桶, 多余的位置补 0,
+  // max_batch_size 总是作为最大的桶; 每个桶是独立的 session, 各自持有一份
+  // 权重, 常驻的权重内存是桶数倍, 读取模型信息的动态 session 在 Init 后释放
+  std::vector<int> batch_buckets;
+
   // onnxruntime
   int intra_op_num_threads = 1;
   int inter_op_num_threads = 1;
   int graph_optimize_level = 0;
   int exe_mode = 0;
 
+  // 进程内所有 engine 共享同一个 Ort::Env, 开启后使用 Env 的全局线程池,
+  // 每个 session 不再创建自己的线程池, intra/inter_op_num_threads 不生效;
+  // 全局线程池和线程数由第一个创建 Env 的 engine 决定, 0 表示由 onnxruntime
+  // 决定; Env 存在期间开启全局线程池的 engine 与这些设置不一致时 Init 失败,
+  // 不开启的 engine 总是使用自己的线程池
+  bool use_global_thread_pool = false;
+  int global_intra_op_num_threads = 0;
+  int global_inter_op_num_threads = 0;
+
+  // intra op 线程绑定的 cpu, 为空时不绑定, 使用全局线程池时不生效;
+  // 调用 Run 的线程作为第一个 intra op 线程, 需要调用方自己绑定到 cpu_affinity[0]
+  std::vector<int> cpu_affinity;
+
+  // 优化后模型的缓存目录, 为空时不使用缓存;
+  // 第一次 Init 时把图优化后的模型写入缓存, 之后直接加载, 跳过图优化,
+  // 缓存文件以 模型和外部数据的内容 + onnxruntime 版本 + 优化等级 + 设备 +
+  // cpu 指令集 为 key, 与文件路径无关, 指令集相同的机器之间可以共享;
+  // 缓存文件加载失败时删除, 从原始模型重新生成
+  std::string optimized_model_cache_dir;
+
+  // 由 onnxruntime 分配内存的输出名称, 这些输出通过 Ort::IoBinding 推理,
+  // 用于 shape 依赖数据的输出(例如模型内 NMS), GetOutputTensors 返回真实 shape;
+  // 除 batch 维以外还有动态维度的输出会自动加入;
+  // 这些输出的 p 在下一次推理之前有效, 推理之前为空, 不填充 p_arr(每个 batch
+  // 的指针), 不能与 batch_buckets 同时使用
+  std::vector<std::string> ort_allocated_outputs;
+
+  // RunAsync 使用的工作线程数, 第一次调用 RunAsync 时创建
+  int async_thread_num = 1;
+
+  // 开启 onnxruntime 性能分析, 每个 session 输出一个
+  // {profile_prefix}_{时间}.json 文件, 调用 EndProfiling 结束并获取文件路径,
+  // 使用 ParseOnnxRuntimeProfile 按算子类型和节点汇总耗时
+  bool enable_profiling = false;
+  std::string profile_prefix = "onnxruntime_profile";
+
   std::unordered_map<std::string, std::string> ext_params;
 };
 
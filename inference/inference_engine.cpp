@@ -0,0 +1,14 @@
+#include "inference/inference_engine.h"
+
+namespace inference {
+
+std::ostream &operator<<(std::ostream &s, const InferenceStats &stats) {
+  return s << "InferenceStats(" << "run_count:" << stats.run_count
+           << ", failed_count:" << stats.failed_count
+           << ", setup:" << stats.setup << ", run:" << stats.run
+           << ", total:" << stats.total
+           << ", bound_bytes:" << stats.bound_bytes
+           << ", bound_bytes_per_run:" << stats.bound_bytes_per_run << ")";
+}
+
+} // namespace inference
@@ -1,9 +1,71 @@
 #pragma once
 
 #include "inference/inference.h"
+#include "inference/utils/latency_stats.h"
+
+#include <functional>
+#include <future>
+#include <memory>
 
 namespace inference {
 
+// 异步推理完成回调, 参数为 Run 的返回值
+using RunCallback = std::function<void(int ret)>;
+
+// engine 的推理统计, 包含所有上下文(同步和异步)的推理
+struct InferenceStats {
+  uint64_t run_count = 0;    // 成功的推理次数
+  uint64_t failed_count = 0; // 失败的推理次数
+  // 准备输入输出: 选择 session, 补 0, 创建和绑定 Ort::Value 等
+  LatencySummary setup;
+  // 推理框架执行模型
+  LatencySummary run;
+  // 整个 Run 调用
+  LatencySummary total;
+  // 每次推理绑定的输入输出字节数, 不包含推理框架分配的输出
+  uint64_t bound_bytes = 0;
+  double bound_bytes_per_run = 0;
+};
+
+std::ostream &operator<<(std::ostream &s, const InferenceStats &stats);
+
+// 推理执行上下文, 持有独立的输入输出 buffer,
+// 多个上下文共享同一个模型 session, 可以在不同线程中并发推理
+// 上下文必须在创建它的 engine Deinit 之前销毁, 销毁时等待它的异步推理完成
+class InferenceExecContext {
+public:
+  InferenceExecContext() {}
+  virtual ~InferenceExecContext() {}
+
+  virtual int Run(int batch_size = -1) = 0;
+
+  // 异步推理, 在完成之前不能读写该上下文的输入输出 buffer;
+  // 同时只能有一个未完成的异步推理, 否则返回 -1
+  virtual std::future<int> RunAsync(int batch_size = -1) = 0;
+  virtual void RunAsync(int batch_size, RunCallback callback) = 0;
+
+  virtual InputTensorPointers GetInputTensors() = 0;
+  virtual OutputTensorPointers GetOutputTensors() = 0;
+
+  // 按句柄获取输入输出, 不分配内存, 返回的引用在上下文销毁之前有效;
+  // onnxruntime 分配的输出在每次推理后更新
+  virtual const TensorDataPointer &GetInputTensor(TensorHandle handle) = 0;
+  virtual const TensorDataPointer &GetOutputTensor(TensorHandle handle) = 0;
+
+  // 绑定调用方持有的 cpu buffer 作为该上下文之后推理的输入输出, 不再拷贝,
+  // 数据类型, shape, 对齐需要与模型一致, 动态 batch 维需要等于推理的 batch;
+  // buffer 在 ClearBindings 或上下文销毁之前需要保持有效
+  virtual int BindInput(const std::string &name, void *data,
+                        const TensorShape &shape, TensorDataType data_type) = 0;
+  virtual int BindOutput(const std::string &name, void *data,
+                         const TensorShape &shape,
+                         TensorDataType data_type) = 0;
+  // 恢复使用内部 buffer
+  virtual void ClearBindings() = 0;
+};
+
+using InferenceExecContextUPtr = std::unique_ptr<InferenceExecContext>;
+
 class InferenceEngine {
 public:
   InferenceEngine() {}
@@ -16,6 +78,13 @@ public:
 
   virtual int Run(int batch_size = -1) = 0;
 
+  // 异步推理, 在完成之前不能读写默认上下文的输入输出 buffer
+  virtual std::future<int> RunAsync(int batch_size = -1) = 0;
+  virtual void RunAsync(int batch_size, RunCallback callback) = 0;
+
+  // 创建一个新的执行上下文, 与 engine 共享模型权重
+  virtual InferenceExecContextUPtr CreateExecContext() = 0;
+
   virtual bool IsReady() const = 0;
   virtual std::string DumpModelInfo() const = 0;
   virtual bool IsDynamicModel() const = 0;
@@ -30,6 +99,29 @@ public:
   virtual const OutputNodeNames &GetOutputNodeNames() const = 0;
   virtual const OutputTensorDescs &GetOutputTensorDescs() const = 0;
   virtual OutputTensorPointers GetOutputTensors() = 0;
+
+  // 名称对应的句柄, 所有上下文通用, 名称不存在返回 kInvalidTensorHandle
+  virtual TensorHandle GetInputHandle(const std::string &name) const = 0;
+  virtual TensorHandle GetOutputHandle(const std::string &name) const = 0;
+
+  // 默认上下文按句柄获取输入输出, 返回的引用在 Deinit 之前有效
+  virtual const TensorDataPointer &GetInputTensor(TensorHandle handle) = 0;
+  virtual const TensorDataPointer &GetOutputTensor(TensorHandle handle) = 0;
+
+  // 默认上下文绑定调用方持有的 buffer, 见 InferenceExecContext::BindInput
+  virtual int BindInput(const std::string &name, void *data,
+                        const TensorShape &shape, TensorDataType data_type) = 0;
+  virtual int BindOutput(const std::string &name, void *data,
+                         const TensorShape &shape,
+                         TensorDataType data_type) = 0;
+  virtual void ClearBindings() = 0;
+
+  // 推理统计, 统计始终开启, 开销是每次推理几次无锁原子操作
+  virtual InferenceStats GetStats() const = 0;
+  virtual void ResetStats() = 0;
+
+  // 结束性能分析, 返回输出的文件, 没有开启性能分析时返回空
+  virtual std::vector<std::string> EndProfiling() = 0;
 };
 
 } // namespace inference
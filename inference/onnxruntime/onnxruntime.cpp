@@ -1,17 +1,40 @@
 #include "onnxruntime.h"
 
 #include "inference/onnxruntime/onnxruntime_convert.h"
+#include "inference/onnxruntime/onnxruntime_shared.h"
 #include "inference/tensor/buffer.h"
+#include "inference/utils/cpu_affinity.h"
+#include "inference/utils/latency_stats.h"
+#include "inference/utils/mapped_file.h"
+#include "inference/utils/thread_pool.h"
 #include <cpptoolkit/exception/exception.h>
 #include <cpptoolkit/log/log.h>
 #include <cpptoolkit/strings/to_string.h>
 
 #include <onnxruntime_cxx_api.h>
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#elif defined(__aarch64__) && defined(__linux__)
+#include <sys/auxv.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <filesystem>
+#include <random>
+
+namespace fs = std::filesystem;
+
 namespace inference {
 
 namespace {
 
+// 无效句柄返回的空张量
+const TensorDataPointer kEmptyTensorPointer;
+
 bool IsDynamic(const std::vector<int64_t> &shape) {
   return std::any_of(shape.begin(), shape.end(),
                      [](int64_t dim) { return dim == -1; });
@@ -76,23 +99,479 @@ Ort::Value CreateOrtTensorCPU(TensorDataType data_type, void *p_data,
   }
 }
 
+struct SharedOrtEnv {
+  std::shared_ptr<Ort::Env> env = nullptr;
+  bool global_thread_pool = false;
+};
+
+// 进程内共享的 Ort::Env, 所有 engine 释放后才会销毁;
+// Env 已经存在时, 全局线程池的设置与创建 Env 时不一致返回空的 env
+SharedOrtEnv GetSharedOrtEnv(const InferenceParams &params,
+                             OrtLoggingLevel log_level) {
+  static std::mutex env_mutex;
+  static std::weak_ptr<Ort::Env> env_weak;
+  static bool env_global_thread_pool = false;
+  static int env_global_intra_threads = 0;
+  static int env_global_inter_threads = 0;
+
+  std::lock_guard<std::mutex> lock(env_mutex);
+  auto env = env_weak.lock();
+  if (env) {
+    if (params.use_global_thread_pool &&
+        (!env_global_thread_pool ||
+         params.global_intra_op_num_threads != env_global_intra_threads ||
+         params.global_inter_op_num_threads != env_global_inter_threads)) {
+      LOG_ERROR("shared Ort::Env global thread pool conflict, env: {} "
+                "(intra:{}, inter:{}), params: intra:{}, inter:{}",
+                env_global_thread_pool, env_global_intra_threads,
+                env_global_inter_threads, params.global_intra_op_num_threads,
+                params.global_inter_op_num_threads);
+      return {};
+    }
+    return {env, env_global_thread_pool};
+  }
+
+  if (params.use_global_thread_pool) {
+    LOG_INFO("create Ort::Env with global thread pool, intra:{}, inter:{}",
+             params.global_intra_op_num_threads,
+             params.global_inter_op_num_threads);
+    Ort::ThreadingOptions tp_options;
+    tp_options.SetGlobalIntraOpNumThreads(params.global_intra_op_num_threads);
+    tp_options.SetGlobalInterOpNumThreads(params.global_inter_op_num_threads);
+    env = std::make_shared<Ort::Env>(tp_options, log_level, "ort");
+  } else {
+    env = std::make_shared<Ort::Env>(log_level, "ort");
+  }
+  env_weak = env;
+  env_global_thread_pool = params.use_global_thread_pool;
+  env_global_intra_threads = params.global_intra_op_num_threads;
+  env_global_inter_threads = params.global_inter_op_num_threads;
+  return {env, env_global_thread_pool};
+}
+
+// 在共享的 Ort::Env 中注册 cpu arena, 每个 Env 只注册一次,
+// session 配置 session.use_env_allocators 后使用该 arena
+int RegisterEnvCpuAllocator(const std::shared_ptr<Ort::Env> &env) {
+  static std::mutex register_mutex;
+  static std::weak_ptr<Ort::Env> registered_env;
+
+  std::lock_guard<std::mutex> lock(register_mutex);
+  if (registered_env.lock() == env) {
+    return 0;
+  }
+  try {
+    auto memory_info = Ort::MemoryInfo::CreateCpu(
+        OrtAllocatorType::OrtArenaAllocator, OrtMemTypeDefault);
+    Ort::ArenaCfg arena_cfg(0, -1, -1, -1);
+    env->CreateAndRegisterAllocator(memory_info, arena_cfg);
+  } catch (const Ort::Exception &e) {
+    LOG_WARN("register env cpu allocator failed: {}", e.what());
+    return -1;
+  }
+  registered_env = env;
+  return 0;
+}
+
+uint64_t Fnv1aHash(const void *data, size_t size,
+                   uint64_t hash = 14695981039346656037ULL) {
+  auto *p = (const uint8_t *)data;
+  for (size_t i = 0; i < size; i++) {
+    hash ^= p[i];
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+// 按 8 字节处理的内容 hash, 用于整个模型文件
+uint64_t HashBytes(const void *data, size_t size, uint64_t hash) {
+  auto *p = (const uint8_t *)data;
+  size_t i = 0;
+  for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+    uint64_t word;
+    memcpy(&word, p + i, sizeof(word));
+    hash = (hash ^ word) * 0x9e3779b97f4a7c15ULL;
+    hash ^= hash >> 29;
+  }
+  hash = Fnv1aHash(p + i, size - i, hash);
+  return Fnv1aHash(&size, sizeof(size), hash);
+}
+
+// 已经映射的文件直接使用映射, 否则临时映射后按内容计算 hash;
+// 文件不存在返回 false
+bool HashFileContent(const std::string &path, const MappedFileSPtr &mapping,
+                     uint64_t *hash) {
+  auto file = mapping ? mapping : MappedFile::Open(path);
+  if (!file) {
+    return false;
+  }
+  *hash = HashBytes(file->Data(), file->Size(), *hash);
+  return true;
+}
+
+// 主机 cpu 的指令集特性位, ORT_ENABLE_ALL 优化后的模型包含与指令集相关的
+// 布局变换(例如 NCHWc), 指令集不同的机器不能共用缓存
+std::string GetCpuFeatureKey() {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+  unsigned int leaf1[2] = {0, 0};
+  unsigned int leaf7[3] = {0, 0, 0};
+  if (__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+    leaf1[0] = ecx;
+    leaf1[1] = edx;
+  }
+  if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+    leaf7[0] = ebx;
+    leaf7[1] = ecx;
+    leaf7[2] = edx;
+  }
+  return fmt::format("x86:{:08x}.{:08x}.{:08x}.{:08x}.{:08x}", leaf1[0],
+                     leaf1[1], leaf7[0], leaf7[1], leaf7[2]);
+#elif defined(__aarch64__) && defined(__linux__)
+  return fmt::format("arm64:{:x}.{:x}", getauxval(AT_HWCAP),
+                     getauxval(AT_HWCAP2));
+#else
+  return "unknown";
+#endif
+}
+
+// 缓存文件路径: <cache_dir>/<model_stem>_<key hash>.onnx, 模型文件不存在返回空;
+// 模型和外部数据按内容计算 key, 与文件路径无关
+std::string GetOptimizedModelCachePath(const InferenceParams &params,
+                                       const MappedFileSPtr &model_mapping,
+                                       const MappedFileSPtr &weight_mapping) {
+  uint64_t hash = Fnv1aHash(nullptr, 0);
+  if (params.model_data != nullptr) {
+    hash = HashBytes(params.model_data, params.model_data_size, hash);
+  } else if (!HashFileContent(params.model_path, model_mapping, &hash)) {
+    return "";
+  }
+  if (!params.weight_path.empty() &&
+      !HashFileContent(params.weight_path, weight_mapping, &hash)) {
+    return "";
+  }
+
+  std::string key = fmt::format(
+      "ort:{},opt:{},exe:{},device:{}:{},cpu:{}",
+      OrtGetApiBase()->GetVersionString(), params.graph_optimize_level,
+      params.exe_mode, (int)params.device_type, params.device_id,
+      GetCpuFeatureKey());
+  hash = Fnv1aHash(key.data(), key.size(), hash);
+
+  auto stem = params.model_path.empty()
+                  ? std::string("model")
+                  : fs::path(params.model_path).stem().string();
+  auto file_name = fmt::format("{}_{:016x}.onnx", stem, hash);
+  return (fs::path(params.optimized_model_cache_dir) / file_name).string();
+}
+
+MappedFileSPtr MapModelFile(const std::string &path, ModelLoadMode mode) {
+  if (mode == kModelLoadSharedMmap) {
+    return MappedFile::OpenShared(path);
+  }
+  return MappedFile::Open(path);
+}
+
+// model_data 为空时从 model_path 加载, prepacked_weights 为空时不共享
+// 预处理后的权重
+std::unique_ptr<Ort::Session>
+CreateOrtSession(const Ort::Env &env, const Ort::SessionOptions &options,
+                 const std::string &model_path, const void *model_data,
+                 size_t model_data_size,
+                 OrtPrepackedWeightsContainer *prepacked_weights) {
+  if (model_data != nullptr) {
+    return std::make_unique<Ort::Session>(env, model_data, model_data_size,
+                                          options, prepacked_weights);
+  }
+  return std::make_unique<Ort::Session>(env, model_path.c_str(), options,
+                                        prepacked_weights);
+}
+
+// 动态输入 batch 维的符号名称, 用于 AddFreeDimensionOverrideByName,
+// 存在没有名称的动态 batch 维时返回空
+std::vector<std::string> GetBatchDimNames(const Ort::Session &session) {
+  std::vector<std::string> dim_names;
+  for (size_t i = 0; i < session.GetInputCount(); i++) {
+    auto type_info = session.GetInputTypeInfo(i);
+    auto info = type_info.GetTensorTypeAndShapeInfo();
+    auto shape = info.GetShape();
+    if (shape.empty() || shape[0] != -1) {
+      continue;
+    }
+    auto symbolic_dims = info.GetSymbolicDimensions();
+    if (symbolic_dims.empty() || symbolic_dims[0] == nullptr ||
+        symbolic_dims[0][0] == '\0') {
+      return {};
+    }
+    if (std::find(dim_names.begin(), dim_names.end(), symbolic_dims[0]) ==
+        dim_names.end()) {
+      dim_names.push_back(symbolic_dims[0]);
+    }
+  }
+  return dim_names;
+}
+
+size_t GetTensorAllocMemSize(const TensorDesc &t_desc, int max_batch_size) {
+  if (t_desc.IsDynamic()) {
+    int64_t max_element_cnt = GetElemCntFromShape(t_desc.shape, max_batch_size);
+    return GetElemMemSize(t_desc.data_type, max_element_cnt);
+  }
+  return GetElemMemSize(t_desc.data_type, t_desc.element_size);
+}
+
+TensorDataPointer CreateTensorDataPointer(const TensorDesc &t_desc,
+                                          TensorBuffer *buffer,
+                                          int max_batch_size) {
+  TensorDataPointer tensor_pointer(buffer->host(), buffer->size(),
+                                   t_desc.element_size, t_desc.shape,
+                                   t_desc.data_type, kCPU);
+  if (t_desc.IsDynamic()) {
+    int64_t single_batch_elem_cnt = GetElemCntFromShape(t_desc.shape, 1);
+    int64_t single_batch_mem_size =
+        GetElemMemSize(t_desc.data_type, single_batch_elem_cnt);
+    tensor_pointer.shape[0] = 1;
+    tensor_pointer.elem_cnt = single_batch_elem_cnt;
+    tensor_pointer.mem_size = single_batch_mem_size;
+    for (int i = 0; i < max_batch_size; i++) {
+      tensor_pointer.p_arr.push_back((char *)tensor_pointer.p +
+                                     i * single_batch_mem_size);
+    }
+  }
+  return tensor_pointer;
+}
+
+// onnxruntime 分配的输出, 推理之前没有数据, 返回 desc 中的 shape
+TensorDataPointer CreateTensorDataPointer(const TensorDesc &t_desc,
+                                          Ort::Value &value) {
+  if (!value) {
+    return TensorDataPointer(nullptr, 0, 0, t_desc.shape, t_desc.data_type,
+                             kCPU);
+  }
+  auto info = value.GetTensorTypeAndShapeInfo();
+  auto data_type = OnnxTensorDataTypeToTensorDataType(info.GetElementType());
+  int64_t elem_cnt = info.GetElementCount();
+  return TensorDataPointer(value.GetTensorMutableRawData(),
+                           GetElemMemSize(data_type, elem_cnt), elem_cnt,
+                           info.GetShape(), data_type, kCPU);
+}
+
+// 校验调用方绑定的 buffer 与模型张量是否匹配: 数据类型, shape(动态 batch
+// 维为 1..max_batch_size), 地址按元素大小对齐
+int CheckBindTensor(const std::string &name, const TensorDesc &t_desc,
+                    const void *data, const TensorShape &shape,
+                    TensorDataType data_type, int max_batch_size) {
+  if (data == nullptr) {
+    LOG_ERROR("bind {}: data is null", name);
+    return -1;
+  }
+  if (data_type != t_desc.data_type) {
+    LOG_ERROR("bind {}: data type {} mismatch, need {}", name,
+              cpptoolkit::ToString(data_type),
+              cpptoolkit::ToString(t_desc.data_type));
+    return -1;
+  }
+  if ((uintptr_t)data % GetDataTypeSize(data_type) != 0) {
+    LOG_ERROR("bind {}: data {} is not aligned to {} bytes", name, data,
+              GetDataTypeSize(data_type));
+    return -1;
+  }
+  bool shape_match = shape.size() == t_desc.shape.size();
+  for (size_t i = 0; shape_match && i < shape.size(); i++) {
+    if (t_desc.shape[i] != -1) {
+      shape_match = shape[i] == t_desc.shape[i];
+    } else if (i == 0) {
+      shape_match = shape[i] >= 1 && shape[i] <= max_batch_size;
+    } else {
+      shape_match = false;
+    }
+  }
+  if (!shape_match) {
+    LOG_ERROR("bind {}: shape {} mismatch, need {}, max_batch_size {}", name,
+              cpptoolkit::ToString(shape), cpptoolkit::ToString(t_desc.shape),
+              max_batch_size);
+    return -1;
+  }
+  return 0;
+}
+
+// 绑定的 buffer 对应的 TensorDataPointer, 动态模型与引擎内部 buffer 一致,
+// p_arr 保存每个 batch 的指针, shape 和大小都是单个 batch 的
+TensorDataPointer CreateBoundTensorDataPointer(const TensorDesc &t_desc,
+                                               void *data,
+                                               const TensorShape &shape,
+                                               TensorDataType data_type) {
+  int64_t elem_cnt = GetElemCntFromShape(shape);
+  TensorDataPointer tensor_pointer(data, GetElemMemSize(data_type, elem_cnt),
+                                   elem_cnt, shape, data_type, kCPU);
+  if (t_desc.IsDynamic()) {
+    int64_t batch_size = shape[0];
+    tensor_pointer.shape[0] = 1;
+    tensor_pointer.elem_cnt = elem_cnt / batch_size;
+    tensor_pointer.mem_size = GetElemMemSize(data_type, elem_cnt / batch_size);
+    for (int64_t i = 0; i < batch_size; i++) {
+      tensor_pointer.p_arr.push_back((char *)data +
+                                     i * tensor_pointer.mem_size);
+    }
+  }
+  return tensor_pointer;
+}
+
+// 除 batch 维以外还有动态维度, 输出大小无法在 Init 时确定
+bool HasDynamicNonBatchDim(const std::vector<int64_t> &shape) {
+  return std::any_of(shape.begin() + std::min<size_t>(shape.size(), 1),
+                     shape.end(), [](int64_t dim) { return dim == -1; });
+}
+
+// batch_size 为 -1 时使用 desc 中的 shape, 否则替换动态张量的 batch 维度,
+// 没有 buffer 的张量(onnxruntime 分配)使用空的 Ort::Value 占位
+std::vector<Ort::Value>
+CreateOrtTensorsCPU(const std::vector<std::string> &names,
+                    const std::map<std::string, TensorDesc> &descs,
+                    const TensorBuffers &buffers, int batch_size) {
+  std::vector<Ort::Value> ort_tensors;
+  ort_tensors.reserve(names.size());
+  for (auto &name : names) {
+    auto buffer_iter = buffers.find(name);
+    if (buffer_iter == buffers.end()) {
+      ort_tensors.emplace_back(nullptr);
+      continue;
+    }
+
+    const auto &tensor_desc = descs.at(name);
+    auto shape = tensor_desc.shape;
+    if (tensor_desc.IsDynamic() && batch_size > 0) {
+      shape[0] = batch_size;
+    }
+    ort_tensors.push_back(CreateOrtTensorCPU(
+        tensor_desc.data_type, buffer_iter->second->host(),
+        GetElemCntFromShape(shape), shape.data(), shape.size()));
+  }
+  return ort_tensors;
+}
+
 } // namespace
 
+class OnnxRuntimeEngineImpl;
+
+// 执行上下文: 持有一份独立的输入输出 buffer 和 Ort::Value,
+// 同一个 session 的 Run 是线程安全的, 不同上下文可以并发调用
+class OnnxRuntimeExecContext : public InferenceExecContext {
+public:
+  explicit OnnxRuntimeExecContext(OnnxRuntimeEngineImpl *engine);
+  // 等待该上下文已经提交的异步推理完成
+  ~OnnxRuntimeExecContext() { WaitAsyncRun(); }
+
+  int Run(int batch_size = -1);
+  int RunStaticModel();
+  int RunDynamicModel(int batch_size);
+
+  std::future<int> RunAsync(int batch_size = -1);
+  void RunAsync(int batch_size, RunCallback callback);
+
+  InputTensorPointers GetInputTensors();
+  OutputTensorPointers GetOutputTensors();
+
+  const TensorDataPointer &GetInputTensor(TensorHandle handle);
+  const TensorDataPointer &GetOutputTensor(TensorHandle handle);
+
+  int BindInput(const std::string &name, void *data, const TensorShape &shape,
+                TensorDataType data_type);
+  int BindOutput(const std::string &name, void *data, const TensorShape &shape,
+                 TensorDataType data_type);
+  void ClearBindings();
+
+  // 提交异步推理之前调用, 已经有未完成的异步推理时返回 false
+  bool BeginAsyncRun();
+  // 异步推理执行完成后由工作线程调用
+  void EndAsyncRun();
+  void WaitAsyncRun();
+  // 在工作线程中执行已经 BeginAsyncRun 的推理, 无论是否抛出异常都会
+  // EndAsyncRun, 异常时返回 -1
+  int RunPending(int batch_size);
+
+private:
+  // 调用方绑定的 buffer, 推理时代替引擎内部 buffer 对应的 Ort::Value
+  struct BoundTensor {
+    Ort::Value value{nullptr};
+    int64_t batch_size = -1;
+  };
+
+  int Bind(const std::string &name, void *data, const TensorShape &shape,
+           TensorDataType data_type, bool is_input);
+  int CheckBoundBatchSize(int batch_size) const;
+
+  // 记录准备阶段的耗时, 返回 session Run 开始的时间
+  LatencyClock::time_point RecordSetupLatency();
+  // 记录 session Run 的耗时和绑定的字节数
+  void RecordRunStats(LatencyClock::time_point session_run_start,
+                      int batch_size);
+
+  void RunSession(Ort::Session *session,
+                  std::vector<Ort::Value> &input_ort_tensors,
+                  std::vector<Ort::Value> &output_ort_tensors, int batch_size);
+
+  OnnxRuntimeEngineImpl *engine_ = nullptr;
+
+  // 当前推理 Run 开始的时间
+  LatencyClock::time_point run_start_;
+
+  // 静态模型使用的 Ort::Value
+  std::vector<Ort::Value> input_ort_tensors_;
+  TensorBuffers input_tensor_buffers_;
+
+  std::vector<Ort::Value> output_ort_tensors_;
+  TensorBuffers output_tensor_buffers_;
+
+  // 动态模型按 batch size 缓存的 Ort::Value, 下标为 batch size,
+  // 第一次使用该 batch size 时创建, 之后推理不再分配
+  std::vector<std::vector<Ort::Value>> batch_input_ort_tensors_;
+  std::vector<std::vector<Ort::Value>> batch_output_ort_tensors_;
+
+  // 存在 onnxruntime 分配的输出时使用 IoBinding 推理,
+  // 输入和预分配的输出只在 batch size 变化时重新绑定
+  std::unique_ptr<Ort::IoBinding> io_binding_ = nullptr;
+  Ort::MemoryInfo output_memory_info_{nullptr};
+  int io_binding_batch_size_ = 0;
+  // 上一次推理的输出, onnxruntime 分配的输出在下一次推理之前有效
+  std::vector<Ort::Value> io_binding_outputs_;
+
+  // 按句柄访问的输入输出, 下标与 node names 对应, 创建上下文时生成,
+  // onnxruntime 分配的输出在每次推理后更新
+  std::vector<TensorDataPointer> input_tensor_pointers_;
+  std::vector<TensorDataPointer> output_tensor_pointers_;
+
+  // 绑定的输入输出, 下标与 node names 对应, 没有绑定时为空;
+  // run_*_values_ 是推理时实际使用的 OrtValue, 避免每次推理分配
+  std::vector<BoundTensor> bound_inputs_;
+  std::vector<BoundTensor> bound_outputs_;
+  int bound_cnt_ = 0;
+  std::vector<const OrtValue *> run_input_values_;
+  std::vector<OrtValue *> run_output_values_;
+
+  // 同一个上下文同时只允许一个异步推理, 避免并发读写同一份 buffer
+  std::mutex async_mutex_;
+  std::condition_variable async_cv_;
+  bool async_running_ = false;
+};
+
 class OnnxRuntimeEngineImpl {
 public:
   OnnxRuntimeEngineImpl() {}
   ~OnnxRuntimeEngineImpl() {}
 
-  int Init(const InferenceParams &params);
+  int Init(const InferenceParams &params,
+           OnnxRuntimeSharedResources *shared = nullptr);
   void Deinit();
 
   int Warmup();
 
   int Run(int batch_size);
-  int RunStaticModel();
-  int RunDynamicModel(int batch_size);
 
-  bool IsReady() const { return ready_; }
+  std::future<int> RunAsync(int batch_size);
+  void RunAsync(int batch_size, RunCallback callback);
+
+  InferenceExecContextUPtr CreateExecContext();
+
+  bool IsReady() const { return ready_.load(); }
   std::string DumpModelInfo() const;
   bool IsDynamicModel() const { return dynamic_model_; }
   int GetMaxBatchSize() const { return max_batch_size_; }
@@ -107,11 +586,42 @@ public:
   const OutputTensorDescs &GetOutputTensorDescs() const;
   OutputTensorPointers GetOutputTensors();
 
+  TensorHandle GetInputHandle(const std::string &name) const;
+  TensorHandle GetOutputHandle(const std::string &name) const;
+  const TensorDataPointer &GetInputTensor(TensorHandle handle);
+  const TensorDataPointer &GetOutputTensor(TensorHandle handle);
+
+  int BindInput(const std::string &name, void *data, const TensorShape &shape,
+                TensorDataType data_type);
+  int BindOutput(const std::string &name, void *data, const TensorShape &shape,
+                 TensorDataType data_type);
+  void ClearBindings();
+
+  InferenceStats GetStats() const;
+  void ResetStats();
+
+  std::vector<std::string> EndProfiling();
+
 private:
+  friend class OnnxRuntimeExecContext;
+
   void ParseSetParams(const InferenceParams &params);
-  void CreateTensorBuffer(const char *name, bool input, bool output);
 
-  bool ready_ = false;
+  void CreateBatchBuckets(const std::vector<int> &batch_buckets,
+                          const Ort::SessionOptions &options,
+                          const std::string &model_path,
+                          const void *model_data, size_t model_data_size);
+
+  // batch_size 对应的 session, 使用分桶时返回能容纳 batch_size 的最小桶
+  Ort::Session *GetSession(int batch_size, int *run_batch_size);
+
+  ThreadPool *GetAsyncPool();
+  std::future<int> SubmitRun(OnnxRuntimeExecContext *ctx, int batch_size);
+  void PostRun(OnnxRuntimeExecContext *ctx, int batch_size,
+               RunCallback callback);
+
+  // Init/Deinit 写入, 调用方线程读取
+  std::atomic<bool> ready_{false};
   bool dynamic_model_ = false;
   int max_batch_size_ = 1; // 如果为动态模型，最大batch size
 
@@ -119,28 +629,466 @@ private:
   Ort::RunOptions run_options_;
 
   Ort::AllocatorWithDefaultOptions allocator_;
-  std::unique_ptr<Ort::Env> env_ =
-      nullptr; // FIXME： Ort::Env 应该全局唯一，多次初始化可能出错
+  std::shared_ptr<Ort::Env> env_ = nullptr; // 进程内共享
   std::unique_ptr<Ort::Session> session_ = nullptr;
 
+  // 动态模型按 batch 分桶的固定 shape session, 与 bucket_sizes_ 一一对应,
+  // batch_bucket_index_ 下标为 batch size, 值为使用的桶
+  std::vector<int> bucket_sizes_;
+  std::vector<std::unique_ptr<Ort::Session>> bucket_sessions_;
+  std::vector<int> batch_bucket_index_;
+  // OnnxRuntimeEngineGroup 共享的预处理后的权重, 由 group 持有
+  OrtPrepackedWeightsContainer *prepacked_weights_ = nullptr;
+
+  // 从内存加载时模型和外部数据的映射, 需要和 session 保持相同的生命周期
+  MappedFileSPtr model_mapping_ = nullptr;
+  MappedFileSPtr weight_mapping_ = nullptr;
+
   DeviceType inference_device_type_ = kCPU;
   TensorDataType inference_tensor_type_ = kFP32;
 
   InputNodeNames input_node_names_;
   InputNodeNamePointers input_node_names_pointers_;
-  std::vector<Ort::Value> input_ort_tensors_;
-  // std::vector<Ort::Value *> input_ort_tensor_pointers_;
   InputTensorDescs input_tensor_descs_;
-  TensorBuffers input_tensor_buffers_;
 
   OutputNodeNames output_node_names_;
   OutputNodeNamePointers output_node_names_pointers_;
-  std::vector<Ort::Value> output_ort_tensors_;
-  // std::vector<Ort::Value *> output_ort_tensor_pointers_;
   OutputTensorDescs output_tensor_descs_;
-  TensorBuffers output_tensor_buffers_;
+  // 由 onnxruntime 分配内存的输出, 下标与 output_node_names_ 对应
+  std::vector<bool> output_ort_allocated_;
+  bool use_io_binding_ = false;
+
+  // 所有上下文共享的推理统计
+  LatencyHistogram setup_latency_;
+  LatencyHistogram run_latency_;
+  LatencyHistogram total_latency_;
+  std::atomic<uint64_t> failed_count_{0};
+  std::atomic<uint64_t> bound_bytes_{0};
+  // 每次推理绑定的输入输出字节数, 动态模型为单个 batch 的字节数
+  size_t run_bound_bytes_ = 0;
+
+  // 性能分析输出文件的前缀, 为空时没有开启性能分析
+  std::string profile_prefix_;
+
+  // Run/GetInputTensors/GetOutputTensors 使用的默认上下文
+  std::unique_ptr<OnnxRuntimeExecContext> default_ctx_ = nullptr;
+
+  // RunAsync 的工作线程, 第一次异步推理时创建
+  int async_thread_num_ = 1;
+  std::mutex async_pool_mutex_;
+  std::unique_ptr<ThreadPool> async_pool_ = nullptr;
 };
 
+OnnxRuntimeExecContext::OnnxRuntimeExecContext(OnnxRuntimeEngineImpl *engine)
+    : engine_(engine) {
+  int max_batch_size = engine_->max_batch_size_;
+
+  for (auto &name : engine_->input_node_names_) {
+    const auto &tensor_desc = engine_->input_tensor_descs_.at(name);
+    input_tensor_buffers_[name] = CreateTensorBufferCPU(
+        tensor_desc.data_type,
+        GetTensorAllocMemSize(tensor_desc, max_batch_size));
+  }
+
+  for (int i = 0; i < engine_->output_node_names_.size(); i++) {
+    if (engine_->output_ort_allocated_[i]) {
+      continue;
+    }
+    const auto &name = engine_->output_node_names_[i];
+    const auto &tensor_desc = engine_->output_tensor_descs_.at(name);
+    output_tensor_buffers_[name] = CreateTensorBufferCPU(
+        tensor_desc.data_type,
+        GetTensorAllocMemSize(tensor_desc, max_batch_size));
+  }
+
+  if (!engine_->dynamic_model_) {
+    input_ort_tensors_ = CreateOrtTensorsCPU(engine_->input_node_names_,
+                                             engine_->input_tensor_descs_,
+                                             input_tensor_buffers_, -1);
+    output_ort_tensors_ = CreateOrtTensorsCPU(engine_->output_node_names_,
+                                              engine_->output_tensor_descs_,
+                                              output_tensor_buffers_, -1);
+  } else {
+    batch_input_ort_tensors_.resize(max_batch_size + 1);
+    batch_output_ort_tensors_.resize(max_batch_size + 1);
+  }
+
+  if (engine_->use_io_binding_) {
+    io_binding_ = std::make_unique<Ort::IoBinding>(*engine_->session_);
+    output_memory_info_ = Ort::MemoryInfo::CreateCpu(
+        OrtAllocatorType::OrtArenaAllocator, OrtMemTypeDefault);
+  }
+
+  bound_inputs_.resize(engine_->input_node_names_.size());
+  bound_outputs_.resize(engine_->output_node_names_.size());
+  run_input_values_.resize(engine_->input_node_names_.size());
+  run_output_values_.resize(engine_->output_node_names_.size());
+
+  for (auto &name : engine_->input_node_names_) {
+    input_tensor_pointers_.push_back(CreateTensorDataPointer(
+        engine_->input_tensor_descs_.at(name),
+        input_tensor_buffers_.at(name).get(), max_batch_size));
+  }
+  for (int i = 0; i < engine_->output_node_names_.size(); i++) {
+    const auto &name = engine_->output_node_names_[i];
+    const auto &tensor_desc = engine_->output_tensor_descs_.at(name);
+    if (engine_->output_ort_allocated_[i]) {
+      Ort::Value empty_value{nullptr};
+      output_tensor_pointers_.push_back(
+          CreateTensorDataPointer(tensor_desc, empty_value));
+    } else {
+      output_tensor_pointers_.push_back(CreateTensorDataPointer(
+          tensor_desc, output_tensor_buffers_.at(name).get(),
+          max_batch_size));
+    }
+  }
+}
+
+LatencyClock::time_point OnnxRuntimeExecContext::RecordSetupLatency() {
+  auto session_run_start = LatencyClock::now();
+  engine_->setup_latency_.Record(ElapsedNs(run_start_, session_run_start));
+  return session_run_start;
+}
+
+void OnnxRuntimeExecContext::RecordRunStats(
+    LatencyClock::time_point session_run_start, int batch_size) {
+  engine_->run_latency_.Record(
+      ElapsedNs(session_run_start, LatencyClock::now()));
+  size_t bound_bytes = engine_->run_bound_bytes_;
+  if (batch_size > 0) {
+    bound_bytes *= batch_size;
+  }
+  engine_->bound_bytes_.fetch_add(bound_bytes, std::memory_order_relaxed);
+}
+
+void OnnxRuntimeExecContext::RunSession(
+    Ort::Session *session, std::vector<Ort::Value> &input_ort_tensors,
+    std::vector<Ort::Value> &output_ort_tensors, int batch_size) {
+  const auto &input_node_names = engine_->input_node_names_;
+  const auto &output_node_names = engine_->output_node_names_;
+
+  if (!io_binding_ && bound_cnt_ == 0) {
+    auto session_run_start = RecordSetupLatency();
+    session->Run(
+        engine_->run_options_, engine_->input_node_names_pointers_.data(),
+        input_ort_tensors.data(), input_node_names.size(),
+        engine_->output_node_names_pointers_.data(), output_ort_tensors.data(),
+        output_node_names.size());
+    RecordRunStats(session_run_start, batch_size);
+    return;
+  }
+
+  if (!io_binding_) {
+    // 存在绑定时混合使用绑定的 OrtValue 和内部 buffer 的 OrtValue
+    for (int i = 0; i < input_node_names.size(); i++) {
+      const auto &bound = bound_inputs_[i].value;
+      run_input_values_[i] = bound ? bound : input_ort_tensors[i];
+    }
+    for (int i = 0; i < output_node_names.size(); i++) {
+      auto &bound = bound_outputs_[i].value;
+      run_output_values_[i] = bound ? bound : output_ort_tensors[i];
+    }
+    auto session_run_start = RecordSetupLatency();
+    Ort::ThrowOnError(Ort::GetApi().Run(
+        *session, engine_->run_options_,
+        engine_->input_node_names_pointers_.data(), run_input_values_.data(),
+        input_node_names.size(), engine_->output_node_names_pointers_.data(),
+        output_node_names.size(), run_output_values_.data()));
+    RecordRunStats(session_run_start, batch_size);
+    return;
+  }
+
+  if (io_binding_batch_size_ != batch_size) {
+    io_binding_->ClearBoundInputs();
+    io_binding_->ClearBoundOutputs();
+    for (int i = 0; i < input_node_names.size(); i++) {
+      const auto &bound = bound_inputs_[i].value;
+      io_binding_->BindInput(input_node_names[i].c_str(),
+                             bound ? bound : input_ort_tensors[i]);
+    }
+    for (int i = 0; i < output_node_names.size(); i++) {
+      const auto &bound = bound_outputs_[i].value;
+      if (engine_->output_ort_allocated_[i]) {
+        io_binding_->BindOutput(output_node_names[i].c_str(),
+                                output_memory_info_);
+      } else {
+        io_binding_->BindOutput(output_node_names[i].c_str(),
+                                bound ? bound : output_ort_tensors[i]);
+      }
+    }
+    io_binding_batch_size_ = batch_size;
+  }
+
+  auto session_run_start = RecordSetupLatency();
+  session->Run(engine_->run_options_, *io_binding_);
+  RecordRunStats(session_run_start, batch_size);
+  io_binding_outputs_ = io_binding_->GetOutputValues();
+  for (int i = 0; i < output_node_names.size(); i++) {
+    if (engine_->output_ort_allocated_[i]) {
+      output_tensor_pointers_[i] = CreateTensorDataPointer(
+          engine_->output_tensor_descs_.at(output_node_names[i]),
+          io_binding_outputs_[i]);
+    }
+  }
+}
+
+int OnnxRuntimeExecContext::RunStaticModel() {
+  try {
+    RunSession(engine_->session_.get(), input_ort_tensors_,
+               output_ort_tensors_, -1);
+    return 0;
+  } catch (const Ort::Exception &e) {
+    LOG_ERROR("Ort::Session run failed: {}", e.what());
+    return -1;
+  }
+}
+
+int OnnxRuntimeExecContext::RunDynamicModel(int batch_size) {
+  try {
+    int max_batch_size = engine_->max_batch_size_;
+    if (batch_size < 1 || batch_size > max_batch_size) {
+      LOG_ERROR("batch_size:{} is invalid, max_batch_size:{}", batch_size,
+                max_batch_size);
+      return -1;
+    }
+
+    const auto &input_node_names = engine_->input_node_names_;
+    const auto &output_node_names = engine_->output_node_names_;
+
+    int run_batch_size = batch_size;
+    auto *session = engine_->GetSession(batch_size, &run_batch_size);
+    if (bound_cnt_ > 0 && CheckBoundBatchSize(run_batch_size) != 0) {
+      return -1;
+    }
+    if (run_batch_size > batch_size) {
+      // 桶中未使用的位置补 0, 输出只有前 batch_size 个有效
+      for (auto &name : input_node_names) {
+        const auto &tensor_desc = engine_->input_tensor_descs_.at(name);
+        size_t offset = GetTensorAllocMemSize(tensor_desc, batch_size);
+        size_t end = GetTensorAllocMemSize(tensor_desc, run_batch_size);
+        memset((char *)input_tensor_buffers_.at(name)->host() + offset, 0,
+               end - offset);
+      }
+    }
+
+    auto &input_ort_tensors = batch_input_ort_tensors_[run_batch_size];
+    auto &output_ort_tensors = batch_output_ort_tensors_[run_batch_size];
+    if (input_ort_tensors.size() != input_node_names.size()) {
+      input_ort_tensors =
+          CreateOrtTensorsCPU(input_node_names, engine_->input_tensor_descs_,
+                              input_tensor_buffers_, run_batch_size);
+    }
+    if (output_ort_tensors.size() != output_node_names.size()) {
+      output_ort_tensors =
+          CreateOrtTensorsCPU(output_node_names, engine_->output_tensor_descs_,
+                              output_tensor_buffers_, run_batch_size);
+    }
+
+    RunSession(session, input_ort_tensors, output_ort_tensors,
+               run_batch_size);
+    return 0;
+  } catch (const Ort::Exception &e) {
+    LOG_ERROR("Ort::Session run failed: {}", e.what());
+    return -1;
+  }
+}
+
+int OnnxRuntimeExecContext::Run(int batch_size) {
+  run_start_ = LatencyClock::now();
+  int ret = 0;
+  if (!engine_->dynamic_model_) {
+    ret = RunStaticModel();
+  } else {
+    ret = RunDynamicModel(batch_size);
+  }
+  if (ret == 0) {
+    engine_->total_latency_.Record(ElapsedNs(run_start_, LatencyClock::now()));
+  } else {
+    engine_->failed_count_.fetch_add(1, std::memory_order_relaxed);
+  }
+  return ret;
+}
+
+bool OnnxRuntimeExecContext::BeginAsyncRun() {
+  std::lock_guard<std::mutex> lock(async_mutex_);
+  if (async_running_) {
+    return false;
+  }
+  async_running_ = true;
+  return true;
+}
+
+void OnnxRuntimeExecContext::EndAsyncRun() {
+  std::lock_guard<std::mutex> lock(async_mutex_);
+  async_running_ = false;
+  async_cv_.notify_all();
+}
+
+void OnnxRuntimeExecContext::WaitAsyncRun() {
+  std::unique_lock<std::mutex> lock(async_mutex_);
+  async_cv_.wait(lock, [this]() { return !async_running_; });
+}
+
+int OnnxRuntimeExecContext::RunPending(int batch_size) {
+  struct EndAsyncGuard {
+    OnnxRuntimeExecContext *ctx;
+    ~EndAsyncGuard() { ctx->EndAsyncRun(); }
+  } guard{this};
+  try {
+    return Run(batch_size);
+  } catch (const std::exception &e) {
+    LOG_ERROR("OnnxRuntimeExecContext::RunAsync: run failed: {}", e.what());
+  } catch (...) {
+    LOG_ERROR("OnnxRuntimeExecContext::RunAsync: run failed");
+  }
+  return -1;
+}
+
+std::future<int> OnnxRuntimeExecContext::RunAsync(int batch_size) {
+  return engine_->SubmitRun(this, batch_size);
+}
+
+void OnnxRuntimeExecContext::RunAsync(int batch_size, RunCallback callback) {
+  engine_->PostRun(this, batch_size, std::move(callback));
+}
+
+InputTensorPointers OnnxRuntimeExecContext::GetInputTensors() {
+  InputTensorPointers input_tensors;
+  const auto &input_node_names = engine_->input_node_names_;
+  for (int i = 0; i < input_node_names.size(); i++) {
+    input_tensors[input_node_names[i]] = input_tensor_pointers_[i];
+  }
+  return input_tensors;
+}
+
+OutputTensorPointers OnnxRuntimeExecContext::GetOutputTensors() {
+  OutputTensorPointers output_tensors;
+  const auto &output_node_names = engine_->output_node_names_;
+  for (int i = 0; i < output_node_names.size(); i++) {
+    output_tensors[output_node_names[i]] = output_tensor_pointers_[i];
+  }
+  return output_tensors;
+}
+
+const TensorDataPointer &
+OnnxRuntimeExecContext::GetInputTensor(TensorHandle handle) {
+  if (handle < 0 || handle >= (int)input_tensor_pointers_.size()) {
+    LOG_ERROR("invalid input tensor handle: {}", handle);
+    return kEmptyTensorPointer;
+  }
+  return input_tensor_pointers_[handle];
+}
+
+const TensorDataPointer &
+OnnxRuntimeExecContext::GetOutputTensor(TensorHandle handle) {
+  if (handle < 0 || handle >= (int)output_tensor_pointers_.size()) {
+    LOG_ERROR("invalid output tensor handle: {}", handle);
+    return kEmptyTensorPointer;
+  }
+  return output_tensor_pointers_[handle];
+}
+
+int OnnxRuntimeExecContext::Bind(const std::string &name, void *data,
+                                 const TensorShape &shape,
+                                 TensorDataType data_type, bool is_input) {
+  const auto &names =
+      is_input ? engine_->input_node_names_ : engine_->output_node_names_;
+  auto iter = std::find(names.begin(), names.end(), name);
+  if (iter == names.end()) {
+    LOG_ERROR("bind {}: tensor not found", name);
+    return -1;
+  }
+  int index = iter - names.begin();
+  if (!is_input && engine_->output_ort_allocated_[index]) {
+    LOG_ERROR("bind {}: output is allocated by onnxruntime", name);
+    return -1;
+  }
+
+  const auto &t_desc = is_input ? engine_->input_tensor_descs_.at(name)
+                                : engine_->output_tensor_descs_.at(name);
+  int max_batch_size = engine_->dynamic_model_ ? engine_->max_batch_size_ : 1;
+  if (CheckBindTensor(name, t_desc, data, shape, data_type, max_batch_size) !=
+      0) {
+    return -1;
+  }
+
+  auto &bound = is_input ? bound_inputs_[index] : bound_outputs_[index];
+  if (!bound.value) {
+    bound_cnt_++;
+  }
+  bound.value = CreateOrtTensorCPU(data_type, data, GetElemCntFromShape(shape),
+                                   shape.data(), shape.size());
+  bound.batch_size = t_desc.IsDynamic() ? shape[0] : -1;
+
+  auto &tensor_pointers =
+      is_input ? input_tensor_pointers_ : output_tensor_pointers_;
+  tensor_pointers[index] =
+      CreateBoundTensorDataPointer(t_desc, data, shape, data_type);
+  // IoBinding 需要重新绑定
+  io_binding_batch_size_ = 0;
+  return 0;
+}
+
+int OnnxRuntimeExecContext::BindInput(const std::string &name, void *data,
+                                      const TensorShape &shape,
+                                      TensorDataType data_type) {
+  return Bind(name, data, shape, data_type, true);
+}
+
+int OnnxRuntimeExecContext::BindOutput(const std::string &name, void *data,
+                                       const TensorShape &shape,
+                                       TensorDataType data_type) {
+  return Bind(name, data, shape, data_type, false);
+}
+
+void OnnxRuntimeExecContext::ClearBindings() {
+  int max_batch_size = engine_->max_batch_size_;
+  for (int i = 0; i < bound_inputs_.size(); i++) {
+    if (!bound_inputs_[i].value) {
+      continue;
+    }
+    const auto &name = engine_->input_node_names_[i];
+    bound_inputs_[i] = BoundTensor();
+    input_tensor_pointers_[i] = CreateTensorDataPointer(
+        engine_->input_tensor_descs_.at(name),
+        input_tensor_buffers_.at(name).get(), max_batch_size);
+  }
+  for (int i = 0; i < bound_outputs_.size(); i++) {
+    if (!bound_outputs_[i].value) {
+      continue;
+    }
+    const auto &name = engine_->output_node_names_[i];
+    bound_outputs_[i] = BoundTensor();
+    output_tensor_pointers_[i] = CreateTensorDataPointer(
+        engine_->output_tensor_descs_.at(name),
+        output_tensor_buffers_.at(name).get(), max_batch_size);
+  }
+  bound_cnt_ = 0;
+  io_binding_batch_size_ = 0;
+}
+
+int OnnxRuntimeExecContext::CheckBoundBatchSize(int batch_size) const {
+  for (int i = 0; i < bound_inputs_.size(); i++) {
+    if (bound_inputs_[i].batch_size > 0 &&
+        bound_inputs_[i].batch_size != batch_size) {
+      LOG_ERROR("input:{} bound batch size {} mismatch, run batch size {}",
+                engine_->input_node_names_[i], bound_inputs_[i].batch_size,
+                batch_size);
+      return -1;
+    }
+  }
+  for (int i = 0; i < bound_outputs_.size(); i++) {
+    if (bound_outputs_[i].batch_size > 0 &&
+        bound_outputs_[i].batch_size != batch_size) {
+      LOG_ERROR("output:{} bound batch size {} mismatch, run batch size {}",
+                engine_->output_node_names_[i], bound_outputs_[i].batch_size,
+                batch_size);
+      return -1;
+    }
+  }
+  return 0;
+}
+
 void OnnxRuntimeEngineImpl::ParseSetParams(const InferenceParams &params) {
   inference_device_type_ = params.device_type;
   sess_options_.SetIntraOpNumThreads(params.intra_op_num_threads);
@@ -148,6 +1096,11 @@ void OnnxRuntimeEngineImpl::ParseSetParams(const InferenceParams &params) {
   sess_options_.SetGraphOptimizationLevel(
       (GraphOptimizationLevel)params.graph_optimize_level);
   sess_options_.SetExecutionMode((ExecutionMode)params.exe_mode);
+  if (params.enable_profiling) {
+    profile_prefix_ = params.profile_prefix;
+    sess_options_.EnableProfiling(fs::path(profile_prefix_).c_str());
+    LOG_INFO("enable profiling, prefix: {}", profile_prefix_);
+  }
 
   if (inference_device_type_ == kCPU) {
     LOG_INFO("use cpu inference");
@@ -164,50 +1117,80 @@ void OnnxRuntimeEngineImpl::ParseSetParams(const InferenceParams &params) {
   }
 
   max_batch_size_ = params.max_batch_size;
+  async_thread_num_ = params.async_thread_num;
 }
 
-void OnnxRuntimeEngineImpl::CreateTensorBuffer(const char *name, bool input,
-                                               bool output) {
-  auto memory_info = Ort::MemoryInfo::CreateCpu(
-      OrtAllocatorType::OrtArenaAllocator, OrtMemTypeDefault);
+void OnnxRuntimeEngineImpl::CreateBatchBuckets(
+    const std::vector<int> &batch_buckets, const Ort::SessionOptions &options,
+    const std::string &model_path, const void *model_data,
+    size_t model_data_size) {
+  for (auto &[name, t_desc] : input_tensor_descs_) {
+    if (HasDynamicNonBatchDim(t_desc.shape)) {
+      LOG_WARN("input:{} has dynamic non-batch dim, batch_buckets is ignored",
+               name);
+      return;
+    }
+  }
+  auto dim_names = GetBatchDimNames(*session_);
+  if (dim_names.empty()) {
+    LOG_WARN("dynamic batch dim has no symbolic name, batch_buckets is "
+             "ignored");
+    return;
+  }
 
-  TensorBuffers *tensor_buffers;
-  std::map<std::string, TensorDesc> *desc;
-  std::vector<Ort::Value> *dst;
-  if (input) {
-    dst = &input_ort_tensors_;
-    desc = &input_tensor_descs_;
-    tensor_buffers = &input_tensor_buffers_;
-  } else if (output) {
-    dst = &output_ort_tensors_;
-    desc = &output_tensor_descs_;
-    tensor_buffers = &output_tensor_buffers_;
-  } else {
-    THROW_RUNTIME_EXCEPTION(fmt::format(
-        "OnnxRuntimeEngineImpl::CreateTensorBuffer: unknown input/output {}",
-        name));
-  }
-
-  auto *t_desc = &(*desc)[name];
-  Ort::Value v;
-
-  if (t_desc->data_type == kFP32) {
-    v = Ort::Value::CreateTensor<float>(
-        memory_info, (float *)tensor_buffers->at(name)->host(),
-        t_desc->element_size, t_desc->shape.data(), t_desc->shape.size());
-  } else if (t_desc->data_type == kFP16) {
-    v = Ort::Value::CreateTensor(
-        memory_info, (Ort::Float16_t *)tensor_buffers->at(name)->host(),
-        t_desc->element_size, t_desc->shape.data(), t_desc->shape.size());
-  } else {
-    throw std::runtime_error(fmt::format(
-        "OnnxRuntimeEngineImpl::CreateTensorBuffer: unknown data type {}",
-        (int)t_desc->data_type));
+  // 桶的大小不超过 max_batch_size, 并且总是包含 max_batch_size
+  std::vector<int> bucket_sizes;
+  for (int size : batch_buckets) {
+    if (size >= 1 && size < max_batch_size_) {
+      bucket_sizes.push_back(size);
+    }
   }
-  dst->push_back(std::move(v));
+  bucket_sizes.push_back(max_batch_size_);
+  std::sort(bucket_sizes.begin(), bucket_sizes.end());
+  bucket_sizes.erase(std::unique(bucket_sizes.begin(), bucket_sizes.end()),
+                     bucket_sizes.end());
+
+  for (int size : bucket_sizes) {
+    auto bucket_options = options.Clone();
+    for (auto &dim_name : dim_names) {
+      bucket_options.AddFreeDimensionOverrideByName(dim_name.c_str(), size);
+    }
+    if (!profile_prefix_.empty()) {
+      // 同一秒内创建的 session 使用相同前缀时输出文件名会重复
+      auto bucket_prefix = fmt::format("{}_batch{}", profile_prefix_, size);
+      bucket_options.EnableProfiling(fs::path(bucket_prefix).c_str());
+    }
+    bucket_sessions_.push_back(
+        CreateOrtSession(*env_, bucket_options, model_path, model_data,
+                         model_data_size, prepacked_weights_));
+  }
+  bucket_sizes_ = std::move(bucket_sizes);
+
+  batch_bucket_index_.assign(max_batch_size_ + 1, 0);
+  for (int batch_size = 1, bucket = 0; batch_size <= max_batch_size_;
+       batch_size++) {
+    if (batch_size > bucket_sizes_[bucket]) {
+      bucket++;
+    }
+    batch_bucket_index_[batch_size] = bucket;
+  }
+  LOG_INFO("create batch bucket sessions: {}",
+           cpptoolkit::ToString(bucket_sizes_));
+}
+
+Ort::Session *OnnxRuntimeEngineImpl::GetSession(int batch_size,
+                                                int *run_batch_size) {
+  if (bucket_sessions_.empty()) {
+    *run_batch_size = batch_size;
+    return session_.get();
+  }
+  int bucket = batch_bucket_index_[batch_size];
+  *run_batch_size = bucket_sizes_[bucket];
+  return bucket_sessions_[bucket].get();
 }
 
-int OnnxRuntimeEngineImpl::Init(const InferenceParams &params) {
+int OnnxRuntimeEngineImpl::Init(const InferenceParams &params,
+                                OnnxRuntimeSharedResources *shared) {
   try {
     if (ready_) {
       LOG_WARN("OnnxRuntimeEngineImpl::Init: engine is ready, deinit first");
@@ -221,83 +1204,192 @@ int OnnxRuntimeEngineImpl::Init(const InferenceParams &params) {
       ort_log_level = (OrtLoggingLevel)params.log_level;
     }
 
-    env_ = std::make_unique<Ort::Env>(ort_log_level, "ort");
-    session_ = std::make_unique<Ort::Session>(*env_, params.model_path.c_str(),
-                                              sess_options_);
+    auto shared_env = GetSharedOrtEnv(params, ort_log_level);
+    if (!shared_env.env) {
+      Deinit();
+      return -1;
+    }
+    env_ = shared_env.env;
+    if (params.use_global_thread_pool) {
+      sess_options_.DisablePerSessionThreads();
+    } else if (!params.cpu_affinity.empty()) {
+      // 绑核需要明确的线程数, 未指定时每个 cpu 一个线程
+      int thread_num = params.intra_op_num_threads > 0
+                           ? params.intra_op_num_threads
+                           : (int)params.cpu_affinity.size();
+      sess_options_.SetIntraOpNumThreads(thread_num);
+      auto affinities =
+          GetIntraOpThreadAffinities(params.cpu_affinity, thread_num);
+      if (!affinities.empty()) {
+        LOG_INFO("intra op thread affinities: {}", affinities);
+        sess_options_.AddConfigEntry("session.intra_op_thread_affinities",
+                                     affinities.c_str());
+      }
+    }
+    if (shared && shared->use_env_allocators &&
+        inference_device_type_ == kCPU && RegisterEnvCpuAllocator(env_) == 0) {
+      sess_options_.AddConfigEntry("session.use_env_allocators", "1");
+    }
+    if (shared && inference_device_type_ == kCPU) {
+      // 所有 session 引用同一份 initializer, 并共享它们预处理后的权重
+      for (size_t i = 0; i < shared->initializers.size(); i++) {
+        sess_options_.AddInitializer(shared->initializer_names[i].c_str(),
+                                     shared->initializers[i]);
+      }
+      if (shared->prepacked_weights) {
+        prepacked_weights_ = *shared->prepacked_weights;
+      }
+    }
+
+    // 从内存加载时 model_data 不为空
+    const void *model_data = params.model_data;
+    size_t model_data_size = params.model_data_size;
+    if (model_data == nullptr) {
+      if (params.model_mapping) {
+        model_mapping_ = params.model_mapping;
+      } else if (params.model_load_mode != kModelLoadFile) {
+        model_mapping_ =
+            MapModelFile(params.model_path, params.model_load_mode);
+        if (!model_mapping_) {
+          Deinit();
+          LOG_ERROR("map model file: {} failed", params.model_path);
+          return -1;
+        }
+      }
+      if (model_mapping_) {
+        model_data = model_mapping_->Data();
+        model_data_size = model_mapping_->Size();
+      }
+    }
+
+    // 从内存加载的模型无法按相对路径找到外部数据, 同样映射到内存
+    if (model_data != nullptr && !params.weight_path.empty()) {
+      weight_mapping_ =
+          MapModelFile(params.weight_path, params.model_load_mode);
+      if (!weight_mapping_) {
+        Deinit();
+        LOG_ERROR("map weight file: {} failed", params.weight_path);
+        return -1;
+      }
+    }
+
+    std::string cache_path;
+    if (!params.optimized_model_cache_dir.empty()) {
+      cache_path =
+          GetOptimizedModelCachePath(params, model_mapping_, weight_mapping_);
+    }
+
+    if (model_data != nullptr) {
+      LOG_INFO("load model from memory, size: {}, mapped: {}", model_data_size,
+               model_mapping_ && model_mapping_->IsMapped());
+      if (weight_mapping_) {
+        // onnxruntime 直接引用这块内存中的外部数据, 不再拷贝权重,
+        // 文件名需要与模型中的外部数据路径一致
+        sess_options_.AddExternalInitializersFromFilesInMemory(
+            {fs::path(params.weight_path).filename().native()},
+            {(char *)weight_mapping_->Data()}, {weight_mapping_->Size()});
+      }
+      // 只对 ORT 格式模型生效: 模型结构和权重都直接引用这块内存, 不再
+      // 拷贝到 session 中, 映射和 model_data 在 session 释放之后才释放;
+      // .onnx 模型仍然解析出自己的一份 protobuf 拷贝, 映射只节省文件读取
+      sess_options_.AddConfigEntry("session.use_ort_model_bytes_directly",
+                                   "1");
+      sess_options_.AddConfigEntry(
+          "session.use_ort_model_bytes_for_initializers", "1");
+    }
+
+    // batch 分桶的 session 使用原始模型和优化等级, 不使用优化模型缓存
+    Ort::SessionOptions bucket_options{nullptr};
+    if (!params.batch_buckets.empty()) {
+      bucket_options = sess_options_.Clone();
+    }
+
+    if (!cache_path.empty() && fs::exists(cache_path)) {
+      // 缓存中的模型已经包含外部数据, 不再做图优化
+      LOG_INFO("load optimized model cache: {}", cache_path);
+      Ort::SessionOptions cache_options = sess_options_.Clone();
+      cache_options.SetGraphOptimizationLevel(ORT_DISABLE_ALL);
+      try {
+        session_ = CreateOrtSession(*env_, cache_options, cache_path, nullptr,
+                                    0, prepacked_weights_);
+      } catch (const Ort::Exception &e) {
+        // 缓存损坏时删除, 从原始模型重新生成
+        LOG_WARN("load optimized model cache: {} failed: {}, remove it",
+                 cache_path, e.what());
+        std::error_code ec;
+        fs::remove(cache_path, ec);
+      }
+    }
+
+    std::string cache_tmp_path;
+    if (!session_) {
+      Ort::SessionOptions options = sess_options_.Clone();
+      if (!cache_path.empty()) {
+        // 先写临时文件再重命名, 避免其他进程读到写了一半的缓存
+        std::error_code ec;
+        fs::create_directories(params.optimized_model_cache_dir, ec);
+        cache_tmp_path = fmt::format("{}.{:08x}.tmp", cache_path,
+                                     std::random_device{}());
+        options.SetOptimizedModelFilePath(cache_tmp_path.c_str());
+      }
+      session_ = CreateOrtSession(*env_, options, params.model_path,
+                                  model_data, model_data_size,
+                                  prepacked_weights_);
+    }
+
+    if (!cache_tmp_path.empty()) {
+      std::error_code ec;
+      fs::rename(cache_tmp_path, cache_path, ec);
+      if (ec) {
+        LOG_WARN("write optimized model cache: {} failed: {}", cache_path,
+                 ec.message());
+        fs::remove(cache_tmp_path, ec);
+      } else {
+        LOG_INFO("write optimized model cache: {}", cache_path);
+      }
+    }
 
     auto input_nums = session_->GetInputCount();
     input_node_names_.reserve(input_nums);
     input_node_names_pointers_.reserve(input_nums);
-    input_ort_tensors_.reserve(input_nums);
 
     for (int i = 0; i < input_nums; ++i) {
       auto input_name = session_->GetInputNameAllocated(i, allocator_);
       auto input_type_info = session_->GetInputTypeInfo(i);
 
-      size_t mem_alloc_size = 0;
       auto tensor_desc = OrtTypeInfoToTensorDesc(input_type_info);
       if (tensor_desc.IsDynamic()) {
         dynamic_model_ = true;
-        int64_t max_element_cnt =
-            GetElemCntFromShape(tensor_desc.shape, max_batch_size_);
-        mem_alloc_size = GetElemMemSize(tensor_desc.data_type, max_element_cnt);
-      } else {
-        mem_alloc_size =
-            GetElemMemSize(tensor_desc.data_type, tensor_desc.element_size);
-      }
-      auto tensor_buffer =
-          CreateTensorBufferCPU(tensor_desc.data_type, mem_alloc_size);
-
-      Ort::Value ort_tensor;
-      if (!tensor_desc.IsDynamic()) {
-        ort_tensor = CreateOrtTensorCPU(
-            tensor_desc.data_type, tensor_buffer->host(),
-            tensor_desc.element_size, tensor_desc.shape.data(),
-            tensor_desc.shape.size());
       }
 
       input_node_names_.push_back(input_name.get());
       input_tensor_descs_[input_name.get()] = std::move(tensor_desc);
-      input_tensor_buffers_[input_name.get()] = std::move(tensor_buffer);
-      input_ort_tensors_.push_back(std::move(ort_tensor));
     }
 
     auto output_nums = session_->GetOutputCount();
     output_node_names_.reserve(output_nums);
     output_node_names_pointers_.reserve(output_nums);
-    output_ort_tensors_.reserve(output_nums);
 
     for (int i = 0; i < output_nums; ++i) {
       auto output_name = session_->GetOutputNameAllocated(i, allocator_);
       auto output_type_info = session_->GetOutputTypeInfo(i);
 
       auto tensor_desc = OrtTypeInfoToTensorDesc(output_type_info);
-
-      size_t mem_alloc_size = 0;
-      if (tensor_desc.IsDynamic()) {
+      bool ort_allocated =
+          HasDynamicNonBatchDim(tensor_desc.shape) ||
+          std::find(params.ort_allocated_outputs.begin(),
+                    params.ort_allocated_outputs.end(),
+                    output_name.get()) != params.ort_allocated_outputs.end();
+      if (ort_allocated) {
+        LOG_INFO("output:{} is allocated by onnxruntime", output_name.get());
+        use_io_binding_ = true;
+      } else if (tensor_desc.IsDynamic()) {
         dynamic_model_ = true;
-        int64_t max_element_cnt =
-            GetElemCntFromShape(tensor_desc.shape, max_batch_size_);
-        mem_alloc_size = GetElemMemSize(tensor_desc.data_type, max_element_cnt);
-      } else {
-        mem_alloc_size =
-            GetElemMemSize(tensor_desc.data_type, tensor_desc.element_size);
-      }
-      auto tensor_buffer =
-          CreateTensorBufferCPU(tensor_desc.data_type, mem_alloc_size);
-
-      Ort::Value ort_tensor;
-      if (!tensor_desc.IsDynamic()) {
-        ort_tensor = CreateOrtTensorCPU(
-            tensor_desc.data_type, tensor_buffer->host(),
-            tensor_desc.element_size, tensor_desc.shape.data(),
-            tensor_desc.shape.size());
       }
 
+      output_ort_allocated_.push_back(ort_allocated);
       output_node_names_.push_back(output_name.get());
       output_tensor_descs_[output_name.get()] = std::move(tensor_desc);
-      output_tensor_buffers_[output_name.get()] = std::move(tensor_buffer);
-      output_ort_tensors_.push_back(std::move(ort_tensor));
     }
 
     for (auto &name : input_node_names_) {
@@ -307,16 +1399,50 @@ int OnnxRuntimeEngineImpl::Init(const InferenceParams &params) {
       output_node_names_pointers_.push_back(name.data());
     }
 
-    if (inference_device_type_ == kCPU && dynamic_model_) {
-      LOG_WARN(
-          "cpu inference use dynamic!!!!, It is recommended to use GPU for "
-          "inference.");
+    // 动态模型按单个 batch 统计, 推理时乘以 batch size
+    int stats_batch_size = dynamic_model_ ? 1 : -1;
+    run_bound_bytes_ = 0;
+    for (auto &name : input_node_names_) {
+      run_bound_bytes_ +=
+          GetTensorAllocMemSize(input_tensor_descs_.at(name), stats_batch_size);
+    }
+    for (int i = 0; i < output_node_names_.size(); i++) {
+      if (!output_ort_allocated_[i]) {
+        run_bound_bytes_ += GetTensorAllocMemSize(
+            output_tensor_descs_.at(output_node_names_[i]), stats_batch_size);
+      }
+    }
+
+    // IoBinding 绑定在动态 session 上, 不能与 batch 分桶同时使用
+    if (use_io_binding_ && dynamic_model_ && !params.batch_buckets.empty()) {
+      Deinit();
+      LOG_ERROR("batch_buckets is not supported with onnxruntime allocated "
+                "outputs");
+      return -1;
     }
 
     if (!dynamic_model_) {
       max_batch_size_ = -1;
+    } else if (!params.batch_buckets.empty()) {
+      CreateBatchBuckets(params.batch_buckets, bucket_options,
+                         params.model_path, model_data, model_data_size);
+      if (!bucket_sessions_.empty()) {
+        // 推理只使用分桶的 session, 动态 session 只用于读取输入输出信息,
+        // 释放它的权重
+        session_.reset();
+      }
     }
 
+    if (inference_device_type_ == kCPU && dynamic_model_ &&
+        bucket_sessions_.empty()) {
+      LOG_WARN(
+          "cpu inference use dynamic!!!!, It is recommended to use GPU for "
+          "inference or set batch_buckets.");
+    }
+
+    default_ctx_ = std::make_unique<OnnxRuntimeExecContext>(this);
+    ResetStats();
+
     ready_ = true;
     return 0;
   } catch (const Ort::Exception &e) {
@@ -327,106 +1453,187 @@ int OnnxRuntimeEngineImpl::Init(const InferenceParams &params) {
 }
 
 void OnnxRuntimeEngineImpl::Deinit() {
+  ready_ = false;
+  {
+    // 等待已经提交的异步推理执行完成
+    std::lock_guard<std::mutex> lock(async_pool_mutex_);
+    async_pool_.reset();
+  }
+  default_ctx_.reset();
+
   dynamic_model_ = false;
   max_batch_size_ = -1;
 
   input_node_names_.clear();
   input_node_names_pointers_.clear();
-  input_ort_tensors_.clear();
-  input_tensor_buffers_.clear();
   input_tensor_descs_.clear();
 
   output_node_names_.clear();
   output_node_names_pointers_.clear();
-  output_ort_tensors_.clear();
-  output_tensor_buffers_.clear();
   output_tensor_descs_.clear();
+  output_ort_allocated_.clear();
+  use_io_binding_ = false;
+  run_bound_bytes_ = 0;
+  profile_prefix_.clear();
+
+  bucket_sizes_.clear();
+  bucket_sessions_.clear();
+  batch_bucket_index_.clear();
+  prepacked_weights_ = nullptr;
 
   session_.reset();
   env_.reset();
-  ready_ = false;
+  sess_options_ = Ort::SessionOptions();
+  // session 释放后才能解除映射
+  model_mapping_.reset();
+  weight_mapping_.reset();
 }
 
-int OnnxRuntimeEngineImpl::RunStaticModel() {
-  try {
-    Ort::RunOptions ops;
-    session_->Run(ops, input_node_names_pointers_.data(),
-                  input_ort_tensors_.data(), input_node_names_.size(),
-                  output_node_names_pointers_.data(),
-                  output_ort_tensors_.data(), output_node_names_.size());
-    return 0;
-  } catch (const Ort::Exception &e) {
-    LOG_ERROR("Ort::Session run failed: {}", e.what());
+int OnnxRuntimeEngineImpl::Warmup() {
+  if (!default_ctx_) {
+    LOG_ERROR("OnnxRuntimeEngineImpl::Warmup: engine is not ready");
     return -1;
   }
-}
-
-int OnnxRuntimeEngineImpl::RunDynamicModel(int batch_size) {
-  try {
-    if (batch_size < 1 || batch_size > max_batch_size_) {
-      LOG_ERROR("batch_size:{} is invalid, max_batch_size:{}", batch_size,
-                max_batch_size_);
-      return -1;
-    }
-
-    for (int i = 0; i < input_node_names_.size(); i++) {
-      const auto &name = input_node_names_.at(i);
-      const auto &tensor_desc = input_tensor_descs_.at(name);
-      const auto &tensor_buffer = input_tensor_buffers_.at(name);
-      auto shape = tensor_desc.shape;
-      if (tensor_desc.IsDynamic()) {
-        shape[0] = batch_size;
+  int ret = 0;
+  if (!dynamic_model_) {
+    ret = default_ctx_->Run(-1);
+  } else if (!bucket_sizes_.empty()) {
+    // 每个桶的 session 都需要预热, max_batch_size 是最大的桶
+    for (int bucket_size : bucket_sizes_) {
+      if (default_ctx_->Run(bucket_size) != 0) {
+        return -1;
       }
-
-      auto ort_tensor = CreateOrtTensorCPU(
-          tensor_desc.data_type, tensor_buffer->host(),
-          tensor_desc.element_size, shape.data(), shape.size());
-      input_ort_tensors_[i] = std::move(ort_tensor);
     }
+  } else {
+    ret = default_ctx_->Run(max_batch_size_);
+  }
+  // 预热的推理不计入统计
+  ResetStats();
+  return ret;
+}
 
-    for (int i = 0; i < output_node_names_.size(); i++) {
-      const auto &name = output_node_names_.at(i);
-      const auto &tensor_desc = output_tensor_descs_.at(name);
-      const auto &tensor_buffer = output_tensor_buffers_.at(name);
+int OnnxRuntimeEngineImpl::Run(int batch_size) {
+  if (!default_ctx_) {
+    LOG_ERROR("OnnxRuntimeEngineImpl::Run: engine is not ready");
+    return -1;
+  }
+  return default_ctx_->Run(batch_size);
+}
 
-      auto shape = tensor_desc.shape;
-      if (tensor_desc.IsDynamic()) {
-        shape[0] = batch_size;
-      }
+ThreadPool *OnnxRuntimeEngineImpl::GetAsyncPool() {
+  std::lock_guard<std::mutex> lock(async_pool_mutex_);
+  if (!async_pool_) {
+    async_pool_ = std::make_unique<ThreadPool>(async_thread_num_);
+  }
+  return async_pool_.get();
+}
 
-      auto ort_tensor = CreateOrtTensorCPU(
-          tensor_desc.data_type, tensor_buffer->host(),
-          tensor_desc.element_size, shape.data(), shape.size());
-      output_ort_tensors_[i] = std::move(ort_tensor);
+std::future<int> OnnxRuntimeEngineImpl::SubmitRun(OnnxRuntimeExecContext *ctx,
+                                                  int batch_size) {
+  if (!ready_) {
+    LOG_ERROR("OnnxRuntimeEngineImpl::RunAsync: engine is not ready");
+    std::promise<int> promise;
+    promise.set_value(-1);
+    return promise.get_future();
+  }
+  if (!ctx->BeginAsyncRun()) {
+    LOG_ERROR("OnnxRuntimeEngineImpl::RunAsync: context has a pending run");
+    std::promise<int> promise;
+    promise.set_value(-1);
+    return promise.get_future();
+  }
+  return GetAsyncPool()->Submit(
+      [ctx, batch_size]() { return ctx->RunPending(batch_size); });
+}
+
+void OnnxRuntimeEngineImpl::PostRun(OnnxRuntimeExecContext *ctx,
+                                    int batch_size, RunCallback callback) {
+  if (!ready_) {
+    LOG_ERROR("OnnxRuntimeEngineImpl::RunAsync: engine is not ready");
+    if (callback) {
+      callback(-1);
     }
+    return;
+  }
+  if (!ctx->BeginAsyncRun()) {
+    LOG_ERROR("OnnxRuntimeEngineImpl::RunAsync: context has a pending run");
+    if (callback) {
+      callback(-1);
+    }
+    return;
+  }
+  GetAsyncPool()->Post([ctx, batch_size, callback = std::move(callback)]() {
+    // 先结束再回调, 回调中可以继续提交该上下文的下一次推理
+    int ret = ctx->RunPending(batch_size);
+    if (callback) {
+      callback(ret);
+    }
+  });
+}
 
-    Ort::RunOptions ops;
-    session_->Run(ops, input_node_names_pointers_.data(),
-                  input_ort_tensors_.data(), input_node_names_.size(),
-                  output_node_names_pointers_.data(),
-                  output_ort_tensors_.data(), output_node_names_.size());
+std::future<int> OnnxRuntimeEngineImpl::RunAsync(int batch_size) {
+  return SubmitRun(default_ctx_.get(), batch_size);
+}
 
-    return 0;
-  } catch (const Ort::Exception &e) {
-    LOG_ERROR("Ort::Session run failed: {}", e.what());
-    return -1;
+void OnnxRuntimeEngineImpl::RunAsync(int batch_size, RunCallback callback) {
+  PostRun(default_ctx_.get(), batch_size, std::move(callback));
+}
+
+InferenceExecContextUPtr OnnxRuntimeEngineImpl::CreateExecContext() {
+  if (!ready_) {
+    LOG_ERROR("OnnxRuntimeEngineImpl::CreateExecContext: engine is not ready");
+    return nullptr;
   }
+  return std::make_unique<OnnxRuntimeExecContext>(this);
 }
 
-int OnnxRuntimeEngineImpl::Warmup() {
-  if (!dynamic_model_) {
-    return RunStaticModel();
-  } else {
-    return RunDynamicModel(max_batch_size_);
+InferenceStats OnnxRuntimeEngineImpl::GetStats() const {
+  InferenceStats stats;
+  stats.setup = setup_latency_.Summary();
+  stats.run = run_latency_.Summary();
+  stats.total = total_latency_.Summary();
+  stats.run_count = stats.total.count;
+  stats.failed_count = failed_count_.load(std::memory_order_relaxed);
+  stats.bound_bytes = bound_bytes_.load(std::memory_order_relaxed);
+  if (stats.run.count > 0) {
+    stats.bound_bytes_per_run = (double)stats.bound_bytes / stats.run.count;
   }
+  return stats;
 }
 
-int OnnxRuntimeEngineImpl::Run(int batch_size) {
-  if (!dynamic_model_) {
-    return RunStaticModel();
-  } else {
-    return RunDynamicModel(batch_size);
+void OnnxRuntimeEngineImpl::ResetStats() {
+  setup_latency_.Reset();
+  run_latency_.Reset();
+  total_latency_.Reset();
+  failed_count_.store(0, std::memory_order_relaxed);
+  bound_bytes_.store(0, std::memory_order_relaxed);
+}
+
+std::vector<std::string> OnnxRuntimeEngineImpl::EndProfiling() {
+  std::vector<std::string> profile_files;
+  if (!ready_ || profile_prefix_.empty()) {
+    LOG_WARN("OnnxRuntimeEngineImpl::EndProfiling: profiling is not enabled");
+    return profile_files;
+  }
+  try {
+    auto end_profiling = [&](Ort::Session *session) {
+      auto path = session->EndProfilingAllocated(allocator_);
+      if (path && path.get()[0] != '\0') {
+        profile_files.push_back(path.get());
+      }
+    };
+    if (session_) {
+      end_profiling(session_.get());
+    }
+    for (auto &session : bucket_sessions_) {
+      end_profiling(session.get());
+    }
+  } catch (const Ort::Exception &e) {
+    LOG_ERROR("Ort::Session end profiling failed: {}", e.what());
   }
+  profile_prefix_.clear();
+  LOG_INFO("profile files: {}", cpptoolkit::ToString(profile_files));
+  return profile_files;
 }
 
 std::string OnnxRuntimeEngineImpl::DumpModelInfo() const {
@@ -437,6 +1644,10 @@ std::string OnnxRuntimeEngineImpl::DumpModelInfo() const {
 
   std::string model_info = fmt::format("model info:\n");
   model_info += fmt::format("dynamic model: {}\n", dynamic_model_);
+  if (!bucket_sizes_.empty()) {
+    model_info += fmt::format("batch buckets: {}\n",
+                              cpptoolkit::ToString(bucket_sizes_));
+  }
   model_info += fmt::format("input nums: {}\n", input_node_names_.size());
   for (auto &i_names : input_node_names_) {
     model_info +=
@@ -449,6 +1660,10 @@ std::string OnnxRuntimeEngineImpl::DumpModelInfo() const {
         fmt::format("output: {}\n{}\n", o_names,
                     cpptoolkit::ToString(output_tensor_descs_.at(o_names)));
   }
+  auto stats = GetStats();
+  if (stats.run_count > 0 || stats.failed_count > 0) {
+    model_info += fmt::format("stats:\n{}\n", cpptoolkit::ToString(stats));
+  }
   return model_info;
 }
 
@@ -465,30 +1680,11 @@ const InputTensorDescs &OnnxRuntimeEngineImpl::GetInputTensorDescs() const {
 }
 
 InputTensorPointers OnnxRuntimeEngineImpl::GetInputTensors() {
-  InputTensorPointers input_tensors;
-  for (auto &[k, t_desc] : input_tensor_descs_) {
-    TensorDataPointer tensor_pointer(input_tensor_buffers_.at(k)->host(),
-                                     input_tensor_buffers_.at(k)->size(),
-                                     t_desc.element_size, t_desc.shape,
-                                     t_desc.data_type, kCPU);
-
-    // auto single_batch_elem_cnt =
-    // GetSingleBatchElemCntFromShape(t_desc.shape);
-    if (t_desc.IsDynamic()) {
-      int64_t single_batch_elem_cnt = GetElemCntFromShape(t_desc.shape, 1);
-      int64_t single_batch_mem_size =
-          GetElemMemSize(t_desc.data_type, single_batch_elem_cnt);
-      tensor_pointer.shape[0] = 1;
-      tensor_pointer.elem_cnt = single_batch_elem_cnt;
-      tensor_pointer.mem_size = single_batch_mem_size;
-      for (int i = 0; i < max_batch_size_; i++) {
-        tensor_pointer.p_arr.push_back((char *)tensor_pointer.p +
-                                       i * single_batch_mem_size);
-      }
-    }
-    input_tensors[k] = std::move(tensor_pointer);
+  if (!default_ctx_) {
+    LOG_ERROR("OnnxRuntimeEngineImpl::GetInputTensors: engine is not ready");
+    return {};
   }
-  return input_tensors;
+  return default_ctx_->GetInputTensors();
 }
 
 int OnnxRuntimeEngineImpl::OutputsNums() const {
@@ -504,30 +1700,77 @@ const OutputTensorDescs &OnnxRuntimeEngineImpl::GetOutputTensorDescs() const {
 }
 
 OutputTensorPointers OnnxRuntimeEngineImpl::GetOutputTensors() {
-  OutputTensorPointers output_tensors;
-  for (auto &[k, t_desc] : output_tensor_descs_) {
-    TensorDataPointer tensor_pointer(output_tensor_buffers_.at(k)->host(),
-                                     output_tensor_buffers_.at(k)->size(),
-                                     t_desc.element_size, t_desc.shape,
-                                     t_desc.data_type, kCPU);
-
-    // auto single_batch_elem_cnt =
-    // GetSingleBatchElemCntFromShape(t_desc.shape);
-    if (t_desc.IsDynamic()) {
-      int64_t single_batch_elem_cnt = GetElemCntFromShape(t_desc.shape, 1);
-      int64_t single_batch_mem_size =
-          GetElemMemSize(t_desc.data_type, single_batch_elem_cnt);
-      tensor_pointer.shape[0] = 1;
-      tensor_pointer.elem_cnt = single_batch_elem_cnt;
-      tensor_pointer.mem_size = single_batch_mem_size;
-      for (int i = 0; i < max_batch_size_; i++) {
-        tensor_pointer.p_arr.push_back((char *)tensor_pointer.p +
-                                       i * single_batch_mem_size);
-      }
-    }
-    output_tensors[k] = std::move(tensor_pointer);
+  if (!default_ctx_) {
+    LOG_ERROR("OnnxRuntimeEngineImpl::GetOutputTensors: engine is not ready");
+    return {};
+  }
+  return default_ctx_->GetOutputTensors();
+}
+
+TensorHandle
+OnnxRuntimeEngineImpl::GetInputHandle(const std::string &name) const {
+  auto iter =
+      std::find(input_node_names_.begin(), input_node_names_.end(), name);
+  if (iter == input_node_names_.end()) {
+    LOG_ERROR("input:{} not found", name);
+    return kInvalidTensorHandle;
+  }
+  return (TensorHandle)(iter - input_node_names_.begin());
+}
+
+TensorHandle
+OnnxRuntimeEngineImpl::GetOutputHandle(const std::string &name) const {
+  auto iter =
+      std::find(output_node_names_.begin(), output_node_names_.end(), name);
+  if (iter == output_node_names_.end()) {
+    LOG_ERROR("output:{} not found", name);
+    return kInvalidTensorHandle;
+  }
+  return (TensorHandle)(iter - output_node_names_.begin());
+}
+
+const TensorDataPointer &
+OnnxRuntimeEngineImpl::GetInputTensor(TensorHandle handle) {
+  if (!default_ctx_) {
+    LOG_ERROR("OnnxRuntimeEngineImpl::GetInputTensor: engine is not ready");
+    return kEmptyTensorPointer;
+  }
+  return default_ctx_->GetInputTensor(handle);
+}
+
+const TensorDataPointer &
+OnnxRuntimeEngineImpl::GetOutputTensor(TensorHandle handle) {
+  if (!default_ctx_) {
+    LOG_ERROR("OnnxRuntimeEngineImpl::GetOutputTensor: engine is not ready");
+    return kEmptyTensorPointer;
+  }
+  return default_ctx_->GetOutputTensor(handle);
+}
+
+int OnnxRuntimeEngineImpl::BindInput(const std::string &name, void *data,
+                                     const TensorShape &shape,
+                                     TensorDataType data_type) {
+  if (!default_ctx_) {
+    LOG_ERROR("OnnxRuntimeEngineImpl::BindInput: engine is not ready");
+    return -1;
+  }
+  return default_ctx_->BindInput(name, data, shape, data_type);
+}
+
+int OnnxRuntimeEngineImpl::BindOutput(const std::string &name, void *data,
+                                      const TensorShape &shape,
+                                      TensorDataType data_type) {
+  if (!default_ctx_) {
+    LOG_ERROR("OnnxRuntimeEngineImpl::BindOutput: engine is not ready");
+    return -1;
+  }
+  return default_ctx_->BindOutput(name, data, shape, data_type);
+}
+
+void OnnxRuntimeEngineImpl::ClearBindings() {
+  if (default_ctx_) {
+    default_ctx_->ClearBindings();
   }
-  return output_tensors;
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -539,6 +1782,11 @@ int OnnxRuntimeEngine::Init(const InferenceParams &params) {
   return impl_->Init(params);
 }
 
+int OnnxRuntimeEngine::InitShared(const InferenceParams &params,
+                                  OnnxRuntimeSharedResources *shared) {
+  return impl_->Init(params, shared);
+}
+
 void OnnxRuntimeEngine::Deinit() { impl_->Deinit(); }
 
 int OnnxRuntimeEngine::Warmup() { return impl_->Warmup(); }
@@ -571,8 +1819,63 @@ OutputTensorPointers OnnxRuntimeEngine::GetOutputTensors() {
   return impl_->GetOutputTensors();
 }
 
+TensorHandle OnnxRuntimeEngine::GetInputHandle(const std::string &name) const {
+  return impl_->GetInputHandle(name);
+}
+
+TensorHandle
+OnnxRuntimeEngine::GetOutputHandle(const std::string &name) const {
+  return impl_->GetOutputHandle(name);
+}
+
+const TensorDataPointer &
+OnnxRuntimeEngine::GetInputTensor(TensorHandle handle) {
+  return impl_->GetInputTensor(handle);
+}
+
+const TensorDataPointer &
+OnnxRuntimeEngine::GetOutputTensor(TensorHandle handle) {
+  return impl_->GetOutputTensor(handle);
+}
+
+int OnnxRuntimeEngine::BindInput(const std::string &name, void *data,
+                                 const TensorShape &shape,
+                                 TensorDataType data_type) {
+  return impl_->BindInput(name, data, shape, data_type);
+}
+
+int OnnxRuntimeEngine::BindOutput(const std::string &name, void *data,
+                                  const TensorShape &shape,
+                                  TensorDataType data_type) {
+  return impl_->BindOutput(name, data, shape, data_type);
+}
+
+void OnnxRuntimeEngine::ClearBindings() { impl_->ClearBindings(); }
+
+InferenceStats OnnxRuntimeEngine::GetStats() const {
+  return impl_->GetStats();
+}
+
+void OnnxRuntimeEngine::ResetStats() { impl_->ResetStats(); }
+
+std::vector<std::string> OnnxRuntimeEngine::EndProfiling() {
+  return impl_->EndProfiling();
+}
+
 int OnnxRuntimeEngine::Run(int batch_size) { return impl_->Run(batch_size); }
 
+std::future<int> OnnxRuntimeEngine::RunAsync(int batch_size) {
+  return impl_->RunAsync(batch_size);
+}
+
+void OnnxRuntimeEngine::RunAsync(int batch_size, RunCallback callback) {
+  impl_->RunAsync(batch_size, std::move(callback));
+}
+
+InferenceExecContextUPtr OnnxRuntimeEngine::CreateExecContext() {
+  return impl_->CreateExecContext();
+}
+
 bool OnnxRuntimeEngine::IsReady() const { return impl_->IsReady(); }
 
 std::string OnnxRuntimeEngine::DumpModelInfo() const {
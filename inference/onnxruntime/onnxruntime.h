@@ -14,6 +14,8 @@
 namespace inference {
 
 class OnnxRuntimeEngineImpl;
+class OnnxRuntimeEngineGroup;
+struct OnnxRuntimeSharedResources;
 
 class OnnxRuntimeEngine : public InferenceEngine {
 public:
@@ -34,6 +36,17 @@ public:
   batch_size 为其他值时，在动态张量模型使用指定batch_size推理*/
   int Run(int batch_size = -1);
 
+  /*异步推理, 由内部工作线程执行 Run, 返回 future 或者在工作线程中调用 callback,
+  完成之前不能读写默认上下文的输入输出 buffer;
+  同一个上下文已经有未完成的异步推理时直接返回 -1, 不会并发执行;
+  需要流水线(预处理下一帧的同时推理当前帧)时, 使用多个 ExecContext 交替 RunAsync*/
+  std::future<int> RunAsync(int batch_size = -1);
+  void RunAsync(int batch_size, RunCallback callback);
+
+  /*每个上下文拥有独立的输入输出 buffer, 线程之间各自使用自己的上下文即可并发推理,
+  Run/GetInputTensors/GetOutputTensors 使用 engine 内部的默认上下文*/
+  InferenceExecContextUPtr CreateExecContext();
+
   bool IsReady() const;
   std::string DumpModelInfo() const;
   bool IsDynamicModel() const;
@@ -49,7 +62,40 @@ public:
   const OutputTensorDescs &GetOutputTensorDescs() const;
   OutputTensorPointers GetOutputTensors();
 
+  /*按句柄访问输入输出, Init 之后通过名称获取一次句柄,
+  每帧推理时不再构造 map 和查找名称, 返回的引用在 Deinit 之前有效*/
+  TensorHandle GetInputHandle(const std::string &name) const;
+  TensorHandle GetOutputHandle(const std::string &name) const;
+  const TensorDataPointer &GetInputTensor(TensorHandle handle);
+  const TensorDataPointer &GetOutputTensor(TensorHandle handle);
+
+  /*绑定调用方持有的 cpu buffer(例如 cv::Mat 的数据)作为默认上下文的输入输出,
+  推理时直接使用, 不再拷贝到内部 buffer; 会校验数据类型, shape 和对齐,
+  绑定之后 GetInputTensor/GetOutputTensor 返回绑定的 buffer,
+  buffer 在 ClearBindings 或 Deinit 之前需要保持有效*/
+  int BindInput(const std::string &name, void *data, const TensorShape &shape,
+                TensorDataType data_type);
+  int BindOutput(const std::string &name, void *data, const TensorShape &shape,
+                 TensorDataType data_type);
+  void ClearBindings();
+
+  /*推理统计: 成功和失败次数, 准备/推理/整体耗时的 p50/p90/p99/max,
+  每次推理绑定的字节数; 包含所有上下文的推理, 预热不计入*/
+  InferenceStats GetStats() const;
+  void ResetStats();
+
+  /*params.enable_profiling 开启时结束性能分析, 返回每个 session
+  (包括 batch 分桶的 session)输出的 json 文件, 之后的推理不再记录;
+  文件可以用 onnxruntime_profile.h 中的 ParseOnnxRuntimeProfile 汇总*/
+  std::vector<std::string> EndProfiling();
+
 private:
+  friend class OnnxRuntimeEngineGroup;
+
+  // 使用 engine 之间共享的资源初始化, 由 OnnxRuntimeEngineGroup 调用
+  int InitShared(const InferenceParams &params,
+                 OnnxRuntimeSharedResources *shared);
+
   OnnxRuntimeEngineImpl *impl_ = nullptr;
 };
 
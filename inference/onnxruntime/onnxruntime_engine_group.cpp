@@ -0,0 +1,107 @@
+#include "inference/onnxruntime/onnxruntime_engine_group.h"
+
+#include "inference/onnxruntime/onnxruntime_shared.h"
+#include "inference/utils/mapped_file.h"
+#include <cpptoolkit/log/log.h>
+
+#include <filesystem>
+
+namespace inference {
+
+namespace fs = std::filesystem;
+
+OnnxRuntimeEngineGroup::OnnxRuntimeEngineGroup() {}
+
+OnnxRuntimeEngineGroup::~OnnxRuntimeEngineGroup() { Deinit(); }
+
+int OnnxRuntimeEngineGroup::Init(const InferenceParams &params,
+                                 int engine_num) {
+  if (IsReady()) {
+    LOG_WARN("OnnxRuntimeEngineGroup::Init: group is ready, deinit first");
+    Deinit();
+  }
+  if (engine_num < 1) {
+    LOG_ERROR("OnnxRuntimeEngineGroup::Init: invalid engine num {}",
+              engine_num);
+    return -1;
+  }
+
+  InferenceParams group_params = params;
+  // 外部数据映射到内存后 onnxruntime 直接引用, 不再为每个 session 拷贝
+  if (group_params.model_data == nullptr && !group_params.model_mapping &&
+      group_params.model_load_mode == kModelLoadFile &&
+      !group_params.weight_path.empty()) {
+    group_params.model_load_mode = kModelLoadSharedMmap;
+  }
+
+  shared_ = std::make_unique<OnnxRuntimeSharedResources>();
+  if (group_params.device_type == kCPU && LoadInitializers(group_params) == 0 &&
+      !shared_->initializers.empty()) {
+    shared_->prepacked_weights =
+        std::make_unique<Ort::PrepackedWeightsContainer>();
+    // 优化模型缓存与 AddInitializer 注册的 initializer 不兼容
+    if (!group_params.optimized_model_cache_dir.empty()) {
+      LOG_INFO("engine group shares initializers, optimized model cache is "
+               "disabled");
+      group_params.optimized_model_cache_dir.clear();
+    }
+  }
+
+  engines_.reserve(engine_num);
+  for (int i = 0; i < engine_num; i++) {
+    auto engine = std::make_unique<OnnxRuntimeEngine>();
+    int ret = engine->InitShared(group_params, shared_.get());
+    if (ret != 0) {
+      LOG_ERROR("init engine {} of group failed: {}", i, ret);
+      Deinit();
+      return -1;
+    }
+    engines_.push_back(std::move(engine));
+  }
+  LOG_INFO("init engine group, model: {}, engine num: {}", params.model_path,
+           engine_num);
+  return 0;
+}
+
+int OnnxRuntimeEngineGroup::LoadInitializers(const InferenceParams &params) {
+  // .ort 模型的权重已经可以直接引用模型的内存
+  if (fs::path(params.model_path).extension() == ".ort") {
+    return -1;
+  }
+  const void *model_data = params.model_data;
+  size_t model_data_size = params.model_data_size;
+  auto mapping = params.model_mapping;
+  if (model_data == nullptr) {
+    if (!mapping) {
+      // 只在读取 initializer 时临时映射
+      mapping = MappedFile::Open(params.model_path);
+    }
+    if (!mapping) {
+      LOG_WARN("map model file: {} failed, initializers are not shared",
+               params.model_path);
+      return -1;
+    }
+    model_data = mapping->Data();
+    model_data_size = mapping->Size();
+  }
+  int ret = LoadSharedInitializers(model_data, model_data_size, shared_.get());
+  if (ret != 0) {
+    LOG_WARN("load initializers of {} failed, initializers are not shared",
+             params.model_path);
+  }
+  return ret;
+}
+
+void OnnxRuntimeEngineGroup::Deinit() {
+  engines_.clear();
+  shared_.reset();
+}
+
+OnnxRuntimeEngine *OnnxRuntimeEngineGroup::GetEngine(int index) const {
+  if (index < 0 || index >= (int)engines_.size()) {
+    return nullptr;
+  }
+  return engines_[index].get();
+}
+
+} // namespace inference
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "inference/onnxruntime/onnxruntime.h"
+
+#include <cpptoolkit/construct/construct.h>
+
+namespace inference {
+
+/**
+ * @brief 同一个模型的多个 OnnxRuntimeEngine
+ *
+ * cpu 推理时所有 session 共享 Ort::Env 中注册的 arena; 内嵌在 .onnx 中的
+ * initializer 只读取一份, 通过 AddInitializer 注册到每个 session, 并通过
+ * 同一个 Ort::PrepackedWeightsContainer 共享预处理(prepack)后的权重,
+ * 增加 engine 不再增加一份权重内存(图优化生成的新 initializer 除外).
+ * 共享 initializer 时不使用优化模型缓存.
+ * 设置了 weight_path(外部数据)时模型按 kModelLoadSharedMmap 加载,
+ * 所有 session 的外部数据 initializer 直接引用同一份只读映射
+ */
+class OnnxRuntimeEngineGroup {
+public:
+  OnnxRuntimeEngineGroup();
+  ~OnnxRuntimeEngineGroup();
+
+  CPP_TK_NON_COPY_CONSTRUCT(OnnxRuntimeEngineGroup);
+  CPP_TK_NON_MOVE_CONSTRUCT(OnnxRuntimeEngineGroup);
+
+  /**
+   * @brief 使用相同的参数创建 engine_num 个 engine, 任意一个失败返回 -1
+   */
+  int Init(const InferenceParams &params, int engine_num);
+  void Deinit();
+
+  bool IsReady() const { return !engines_.empty(); }
+  int Size() const { return (int)engines_.size(); }
+
+  /**
+   * @brief 获取第 index 个 engine, 越界返回 nullptr
+   */
+  OnnxRuntimeEngine *GetEngine(int index) const;
+
+private:
+  // 从模型中读取共享的 initializer, 失败时不共享, 返回 -1
+  int LoadInitializers(const InferenceParams &params);
+
+  // 需要在所有 engine 释放之后再释放
+  std::unique_ptr<OnnxRuntimeSharedResources> shared_;
+  std::vector<std::unique_ptr<OnnxRuntimeEngine>> engines_;
+};
+
+} // namespace inference
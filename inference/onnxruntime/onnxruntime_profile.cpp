@@ -0,0 +1,447 @@
+#include "inference/onnxruntime/onnxruntime_profile.h"
+
+#include <cpptoolkit/log/log.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <sstream>
+#include <utility>
+
+namespace inference {
+
+namespace {
+
+// 性能分析文件只需要的最小 json 解析
+struct JsonValue {
+  enum Type { kNull, kBool, kNumber, kString, kArray, kObject };
+
+  Type type = kNull;
+  bool boolean = false;
+  double number = 0;
+  std::string str;
+  std::vector<JsonValue> array;
+  std::vector<std::pair<std::string, JsonValue>> object;
+
+  const JsonValue *Find(const std::string &key) const {
+    for (auto &[k, v] : object) {
+      if (k == key) {
+        return &v;
+      }
+    }
+    return nullptr;
+  }
+
+  std::string GetString(const std::string &key) const {
+    auto *v = Find(key);
+    return v && v->type == kString ? v->str : "";
+  }
+
+  double GetNumber(const std::string &key) const {
+    auto *v = Find(key);
+    return v && v->type == kNumber ? v->number : 0;
+  }
+};
+
+class JsonReader {
+public:
+  JsonReader(const char *begin, const char *end) : p_(begin), end_(end) {}
+
+  // 逐个解析顶层数组的元素, 不需要把整个文件保存为 json 树;
+  // 同时支持 {"traceEvents": [...]} 格式
+  bool ForEachEvent(const std::function<void(const JsonValue &)> &callback) {
+    SkipSpace();
+    if (p_ < end_ && *p_ == '{') {
+      JsonValue root;
+      if (!ParseValue(&root, 0)) {
+        return false;
+      }
+      auto *events = root.Find("traceEvents");
+      if (!events || events->type != JsonValue::kArray) {
+        return false;
+      }
+      for (auto &event : events->array) {
+        callback(event);
+      }
+      return true;
+    }
+
+    if (!Consume('[')) {
+      return false;
+    }
+    if (Consume(']')) {
+      return true;
+    }
+    while (true) {
+      JsonValue event;
+      if (!ParseValue(&event, 0)) {
+        return false;
+      }
+      callback(event);
+      if (Consume(',')) {
+        continue;
+      }
+      return Consume(']');
+    }
+  }
+
+private:
+  static constexpr int kMaxDepth = 64;
+
+  void SkipSpace() {
+    while (p_ < end_ &&
+           (*p_ == ' ' || *p_ == '\n' || *p_ == '\r' || *p_ == '\t')) {
+      p_++;
+    }
+  }
+
+  bool Consume(char c) {
+    SkipSpace();
+    if (p_ < end_ && *p_ == c) {
+      p_++;
+      return true;
+    }
+    return false;
+  }
+
+  bool ConsumeLiteral(const char *literal) {
+    size_t len = strlen(literal);
+    if ((size_t)(end_ - p_) < len || strncmp(p_, literal, len) != 0) {
+      return false;
+    }
+    p_ += len;
+    return true;
+  }
+
+  static void AppendUtf8(uint32_t code, std::string *out) {
+    if (code < 0x80) {
+      out->push_back((char)code);
+    } else if (code < 0x800) {
+      out->push_back((char)(0xC0 | (code >> 6)));
+      out->push_back((char)(0x80 | (code & 0x3F)));
+    } else {
+      out->push_back((char)(0xE0 | (code >> 12)));
+      out->push_back((char)(0x80 | ((code >> 6) & 0x3F)));
+      out->push_back((char)(0x80 | (code & 0x3F)));
+    }
+  }
+
+  bool ParseString(std::string *out) {
+    if (!Consume('"')) {
+      return false;
+    }
+    while (p_ < end_) {
+      char c = *p_++;
+      if (c == '"') {
+        return true;
+      }
+      if (c != '\\') {
+        out->push_back(c);
+        continue;
+      }
+      if (p_ >= end_) {
+        return false;
+      }
+      char e = *p_++;
+      switch (e) {
+      case 'b':
+        out->push_back('\b');
+        break;
+      case 'f':
+        out->push_back('\f');
+        break;
+      case 'n':
+        out->push_back('\n');
+        break;
+      case 'r':
+        out->push_back('\r');
+        break;
+      case 't':
+        out->push_back('\t');
+        break;
+      case 'u': {
+        if (end_ - p_ < 4) {
+          return false;
+        }
+        std::string hex(p_, 4);
+        p_ += 4;
+        AppendUtf8((uint32_t)strtoul(hex.c_str(), nullptr, 16), out);
+        break;
+      }
+      default:
+        out->push_back(e);
+        break;
+      }
+    }
+    return false;
+  }
+
+  bool ParseValue(JsonValue *value, int depth) {
+    if (depth > kMaxDepth) {
+      return false;
+    }
+    SkipSpace();
+    if (p_ >= end_) {
+      return false;
+    }
+
+    char c = *p_;
+    if (c == '"') {
+      value->type = JsonValue::kString;
+      return ParseString(&value->str);
+    }
+    if (c == '{') {
+      p_++;
+      value->type = JsonValue::kObject;
+      if (Consume('}')) {
+        return true;
+      }
+      do {
+        std::pair<std::string, JsonValue> member;
+        if (!ParseString(&member.first) || !Consume(':') ||
+            !ParseValue(&member.second, depth + 1)) {
+          return false;
+        }
+        value->object.push_back(std::move(member));
+      } while (Consume(','));
+      return Consume('}');
+    }
+    if (c == '[') {
+      p_++;
+      value->type = JsonValue::kArray;
+      if (Consume(']')) {
+        return true;
+      }
+      do {
+        value->array.emplace_back();
+        if (!ParseValue(&value->array.back(), depth + 1)) {
+          return false;
+        }
+      } while (Consume(','));
+      return Consume(']');
+    }
+    if (c == 't' || c == 'f') {
+      value->type = JsonValue::kBool;
+      value->boolean = c == 't';
+      return ConsumeLiteral(c == 't' ? "true" : "false");
+    }
+    if (c == 'n') {
+      value->type = JsonValue::kNull;
+      return ConsumeLiteral("null");
+    }
+
+    char *num_end = nullptr;
+    value->type = JsonValue::kNumber;
+    value->number = strtod(p_, &num_end);
+    if (num_end == p_) {
+      return false;
+    }
+    p_ = num_end;
+    return true;
+  }
+
+  const char *p_;
+  const char *end_;
+};
+
+const std::string kKernelTimeSuffix = "_kernel_time";
+
+void AddItem(const std::string &name, const std::string &op_type,
+             const std::string &provider, int64_t dur,
+             std::map<std::string, ProfileItem> *items) {
+  auto &item = (*items)[name];
+  if (item.count == 0) {
+    item.name = name;
+    item.op_type = op_type;
+    item.provider = provider;
+  }
+  item.count++;
+  item.total_us += dur;
+}
+
+std::vector<ProfileItem>
+SortItems(const std::map<std::string, ProfileItem> &items, int64_t base_us) {
+  std::vector<ProfileItem> result;
+  result.reserve(items.size());
+  for (auto &[name, item] : items) {
+    result.push_back(item);
+    auto &back = result.back();
+    back.avg_us = (double)back.total_us / back.count;
+    back.ratio = base_us > 0 ? (double)back.total_us / base_us : 0;
+  }
+  std::sort(result.begin(), result.end(),
+            [](const ProfileItem &a, const ProfileItem &b) {
+              return a.total_us > b.total_us;
+            });
+  return result;
+}
+
+std::string DumpItems(const std::vector<ProfileItem> &items, int top_n,
+                      bool show_node) {
+  std::string out;
+  if (show_node) {
+    out += fmt::format(
+        "| {:<48} | {:<16} | {:>8} | {:>12} | {:>10} | {:>7} |\n", "node",
+        "op type", "count", "total (us)", "avg (us)", "ratio");
+  } else {
+    out += fmt::format("| {:<16} | {:>8} | {:>12} | {:>10} | {:>7} |\n",
+                       "op type", "count", "total (us)", "avg (us)", "ratio");
+  }
+  int n = top_n > 0 ? std::min<int>(top_n, items.size()) : items.size();
+  for (int i = 0; i < n; i++) {
+    auto &item = items[i];
+    if (show_node) {
+      out += fmt::format(
+          "| {:<48} | {:<16} | {:>8} | {:>12} | {:>10.2f} | {:>6.2f}% |\n",
+          item.name, item.op_type, item.count, item.total_us, item.avg_us,
+          item.ratio * 100);
+    } else {
+      out += fmt::format(
+          "| {:<16} | {:>8} | {:>12} | {:>10.2f} | {:>6.2f}% |\n",
+          item.op_type, item.count, item.total_us, item.avg_us,
+          item.ratio * 100);
+    }
+  }
+  return out;
+}
+
+// 每次推理中该节点的平均耗时
+double PerRunUs(const ProfileItem &item, int64_t run_count) {
+  return (double)item.total_us / std::max<int64_t>(run_count, 1);
+}
+
+} // namespace
+
+int ParseOnnxRuntimeProfile(const std::vector<std::string> &profile_files,
+                            ProfileSummary *summary) {
+  std::map<std::string, ProfileItem> op_types;
+  std::map<std::string, ProfileItem> nodes;
+  *summary = ProfileSummary();
+
+  for (auto &path : profile_files) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+      LOG_ERROR("open profile file: {} failed", path);
+      return -1;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    std::string content = buffer.str();
+
+    JsonReader reader(content.data(), content.data() + content.size());
+    bool ok = reader.ForEachEvent([&](const JsonValue &event) {
+      if (event.type != JsonValue::kObject) {
+        return;
+      }
+      auto cat = event.GetString("cat");
+      auto name = event.GetString("name");
+      auto dur = (int64_t)event.GetNumber("dur");
+      if (cat == "Session" && name == "model_run") {
+        summary->run_count++;
+        summary->run_total_us += dur;
+        return;
+      }
+      // 每个节点有 fence_before, kernel_time, fence_after 三个事件,
+      // 只有 kernel_time 是算子执行的耗时
+      if (cat != "Node" || name.size() <= kKernelTimeSuffix.size() ||
+          name.compare(name.size() - kKernelTimeSuffix.size(),
+                       kKernelTimeSuffix.size(), kKernelTimeSuffix) != 0) {
+        return;
+      }
+      std::string node_name =
+          name.substr(0, name.size() - kKernelTimeSuffix.size());
+      std::string op_type, provider;
+      if (auto *args = event.Find("args")) {
+        op_type = args->GetString("op_name");
+        provider = args->GetString("provider");
+      }
+      summary->kernel_total_us += dur;
+      AddItem(node_name, op_type, provider, dur, &nodes);
+      AddItem(op_type, op_type, provider, dur, &op_types);
+    });
+    if (!ok) {
+      LOG_ERROR("parse profile file: {} failed", path);
+      return -1;
+    }
+  }
+
+  // 没有 model_run 事件时以 kernel 总耗时为基准
+  int64_t base_us = summary->run_total_us > 0 ? summary->run_total_us
+                                              : summary->kernel_total_us;
+  summary->op_types = SortItems(op_types, base_us);
+  summary->nodes = SortItems(nodes, base_us);
+  return 0;
+}
+
+std::string DumpProfileSummary(const ProfileSummary &summary, int top_n) {
+  std::string out = fmt::format(
+      "runs: {}, run total: {} us, avg run: {:.2f} us, kernel total: {} us\n",
+      summary.run_count, summary.run_total_us,
+      (double)summary.run_total_us / std::max<int64_t>(summary.run_count, 1),
+      summary.kernel_total_us);
+  out += "op types:\n";
+  out += DumpItems(summary.op_types, top_n, false);
+  out += "nodes:\n";
+  out += DumpItems(summary.nodes, top_n, true);
+  return out;
+}
+
+std::string DumpProfileDiff(const ProfileSummary &base,
+                            const ProfileSummary &target, int top_n) {
+  struct DiffItem {
+    std::string name;
+    std::string op_type;
+    double base_us = 0;
+    double target_us = 0;
+  };
+
+  std::map<std::string, DiffItem> diff_items;
+  for (auto &item : base.nodes) {
+    auto &diff = diff_items[item.name];
+    diff.name = item.name;
+    diff.op_type = item.op_type;
+    diff.base_us = PerRunUs(item, base.run_count);
+  }
+  for (auto &item : target.nodes) {
+    auto &diff = diff_items[item.name];
+    diff.name = item.name;
+    diff.op_type = item.op_type;
+    diff.target_us = PerRunUs(item, target.run_count);
+  }
+
+  std::vector<DiffItem> diffs;
+  for (auto &[name, diff] : diff_items) {
+    diffs.push_back(diff);
+  }
+  std::sort(diffs.begin(), diffs.end(),
+            [](const DiffItem &a, const DiffItem &b) {
+              return std::abs(a.target_us - a.base_us) >
+                     std::abs(b.target_us - b.base_us);
+            });
+
+  double base_run_us =
+      (double)base.run_total_us / std::max<int64_t>(base.run_count, 1);
+  double target_run_us =
+      (double)target.run_total_us / std::max<int64_t>(target.run_count, 1);
+  std::string out =
+      fmt::format("avg run: {:.2f} us -> {:.2f} us ({:+.2f} us)\n",
+                  base_run_us, target_run_us, target_run_us - base_run_us);
+  out += fmt::format("| {:<48} | {:<16} | {:>11} | {:>11} | {:>11} |\n",
+                     "node", "op type", "base (us)", "target (us)",
+                     "diff (us)");
+  int n = top_n > 0 ? std::min<int>(top_n, diffs.size()) : diffs.size();
+  for (int i = 0; i < n; i++) {
+    auto &diff = diffs[i];
+    out += fmt::format(
+        "| {:<48} | {:<16} | {:>11.2f} | {:>11.2f} | {:>+11.2f} |\n",
+        diff.name, diff.op_type, diff.base_us, diff.target_us,
+        diff.target_us - diff.base_us);
+  }
+  return out;
+}
+
+} // namespace inference
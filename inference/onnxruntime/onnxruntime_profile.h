@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace inference {
+
+// 一个算子类型或一个节点的耗时统计
+struct ProfileItem {
+  std::string name;     // 节点名称, 按算子类型统计时等于 op_type
+  std::string op_type;  // 例如 Conv, Concat
+  std::string provider; // 例如 CPUExecutionProvider
+  int64_t count = 0;    // 执行次数
+  int64_t total_us = 0; // 总耗时
+  double avg_us = 0;    // 每次执行的平均耗时
+  double ratio = 0;     // 占整个推理耗时的比例
+};
+
+struct ProfileSummary {
+  int64_t run_count = 0;       // model_run 次数
+  int64_t run_total_us = 0;    // model_run 总耗时
+  int64_t kernel_total_us = 0; // 所有节点 kernel 耗时之和
+  // 按 total_us 降序排列
+  std::vector<ProfileItem> op_types;
+  std::vector<ProfileItem> nodes;
+};
+
+/**
+ * @brief 解析 onnxruntime 性能分析输出的 json 文件(chrome trace 格式),
+ * 按算子类型和节点汇总 kernel 耗时
+ *
+ * 多个文件(例如 batch 分桶的多个 session)合并到同一个结果中
+ */
+int ParseOnnxRuntimeProfile(const std::vector<std::string> &profile_files,
+                            ProfileSummary *summary);
+
+/**
+ * @brief 输出耗时最多的 top_n 个算子类型和节点, top_n <= 0 时输出全部
+ */
+std::string DumpProfileSummary(const ProfileSummary &summary, int top_n = 20);
+
+/**
+ * @brief 按节点名称对比两次结果每次推理的平均耗时, 输出变化最大的 top_n 个节点,
+ * 用于模型重新导出后定位变慢的节点
+ */
+std::string DumpProfileDiff(const ProfileSummary &base,
+                            const ProfileSummary &target, int top_n = 20);
+
+} // namespace inference
@@ -0,0 +1,297 @@
+#include "inference/onnxruntime/onnxruntime_shared.h"
+
+#include <cpptoolkit/log/log.h>
+
+#include <cstdint>
+#include <cstring>
+
+namespace inference {
+
+namespace {
+
+// protobuf 线格式中用到的字段编号, 见 onnx.proto
+constexpr uint32_t kModelGraph = 7;
+constexpr uint32_t kGraphInitializer = 5;
+constexpr uint32_t kTensorDims = 1;
+constexpr uint32_t kTensorDataType = 2;
+constexpr uint32_t kTensorName = 8;
+constexpr uint32_t kTensorRawData = 9;
+constexpr uint32_t kTensorDataLocation = 14;
+
+constexpr int kWireVarint = 0;
+constexpr int kWireFixed64 = 1;
+constexpr int kWireLength = 2;
+constexpr int kWireFixed32 = 5;
+
+constexpr size_t kInitializerAlignment = 64;
+
+// 只读的 protobuf 消息, 只支持本文件用到的线格式
+class ProtoReader {
+public:
+  ProtoReader(const uint8_t *data, size_t size)
+      : p_(data), end_(data + size) {}
+
+  bool Done() const { return p_ >= end_; }
+
+  bool ReadVarint(uint64_t *value) {
+    *value = 0;
+    for (int shift = 0; shift < 64 && p_ < end_; shift += 7) {
+      uint8_t byte = *p_++;
+      *value |= (uint64_t)(byte & 0x7f) << shift;
+      if ((byte & 0x80) == 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool ReadTag(uint32_t *field, int *wire_type) {
+    uint64_t tag = 0;
+    if (!ReadVarint(&tag)) {
+      return false;
+    }
+    *field = (uint32_t)(tag >> 3);
+    *wire_type = (int)(tag & 0x7);
+    return true;
+  }
+
+  bool ReadLength(const uint8_t **data, size_t *size) {
+    uint64_t len = 0;
+    if (!ReadVarint(&len) || len > (uint64_t)(end_ - p_)) {
+      return false;
+    }
+    *data = p_;
+    *size = (size_t)len;
+    p_ += len;
+    return true;
+  }
+
+  bool Skip(int wire_type) {
+    uint64_t value = 0;
+    const uint8_t *data = nullptr;
+    size_t size = 0;
+    switch (wire_type) {
+    case kWireVarint:
+      return ReadVarint(&value);
+    case kWireFixed64:
+      return Advance(8);
+    case kWireLength:
+      return ReadLength(&data, &size);
+    case kWireFixed32:
+      return Advance(4);
+    default:
+      return false;
+    }
+  }
+
+private:
+  bool Advance(size_t n) {
+    if (n > (size_t)(end_ - p_)) {
+      return false;
+    }
+    p_ += n;
+    return true;
+  }
+
+  const uint8_t *p_;
+  const uint8_t *end_;
+};
+
+struct RawInitializer {
+  std::string name;
+  int data_type = 0;
+  std::vector<int64_t> dims;
+  const uint8_t *data = nullptr;
+  size_t size = 0;
+  bool external = false;
+};
+
+size_t ElementSize(int data_type) {
+  switch (data_type) {
+  case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8:
+  case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8:
+  case ONNX_TENSOR_ELEMENT_DATA_TYPE_BOOL:
+    return 1;
+  case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT16:
+  case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT16:
+  case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16:
+  case ONNX_TENSOR_ELEMENT_DATA_TYPE_BFLOAT16:
+    return 2;
+  case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT:
+  case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT32:
+  case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT32:
+    return 4;
+  case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64:
+  case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT64:
+  case ONNX_TENSOR_ELEMENT_DATA_TYPE_DOUBLE:
+    return 8;
+  default:
+    return 0;
+  }
+}
+
+bool ParseTensor(const uint8_t *data, size_t size, RawInitializer *tensor) {
+  ProtoReader reader(data, size);
+  while (!reader.Done()) {
+    uint32_t field = 0;
+    int wire_type = 0;
+    if (!reader.ReadTag(&field, &wire_type)) {
+      return false;
+    }
+    uint64_t value = 0;
+    const uint8_t *bytes = nullptr;
+    size_t len = 0;
+    if (field == kTensorDims && wire_type == kWireVarint) {
+      if (!reader.ReadVarint(&value)) {
+        return false;
+      }
+      tensor->dims.push_back((int64_t)value);
+    } else if (field == kTensorDims && wire_type == kWireLength) {
+      // packed
+      if (!reader.ReadLength(&bytes, &len)) {
+        return false;
+      }
+      ProtoReader packed(bytes, len);
+      while (!packed.Done()) {
+        if (!packed.ReadVarint(&value)) {
+          return false;
+        }
+        tensor->dims.push_back((int64_t)value);
+      }
+    } else if (field == kTensorDataType && wire_type == kWireVarint) {
+      if (!reader.ReadVarint(&value)) {
+        return false;
+      }
+      tensor->data_type = (int)value;
+    } else if (field == kTensorName && wire_type == kWireLength) {
+      if (!reader.ReadLength(&bytes, &len)) {
+        return false;
+      }
+      tensor->name.assign((const char *)bytes, len);
+    } else if (field == kTensorRawData && wire_type == kWireLength) {
+      if (!reader.ReadLength(&tensor->data, &tensor->size)) {
+        return false;
+      }
+    } else if (field == kTensorDataLocation && wire_type == kWireVarint) {
+      if (!reader.ReadVarint(&value)) {
+        return false;
+      }
+      tensor->external = value != 0;
+    } else if (!reader.Skip(wire_type)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// 主图中的 initializer, 按在模型中出现的顺序
+bool ParseInitializers(const uint8_t *data, size_t size,
+                       std::vector<RawInitializer> *initializers) {
+  ProtoReader model(data, size);
+  while (!model.Done()) {
+    uint32_t field = 0;
+    int wire_type = 0;
+    if (!model.ReadTag(&field, &wire_type)) {
+      return false;
+    }
+    if (field != kModelGraph || wire_type != kWireLength) {
+      if (!model.Skip(wire_type)) {
+        return false;
+      }
+      continue;
+    }
+    const uint8_t *graph_data = nullptr;
+    size_t graph_size = 0;
+    if (!model.ReadLength(&graph_data, &graph_size)) {
+      return false;
+    }
+    ProtoReader graph(graph_data, graph_size);
+    while (!graph.Done()) {
+      if (!graph.ReadTag(&field, &wire_type)) {
+        return false;
+      }
+      if (field != kGraphInitializer || wire_type != kWireLength) {
+        if (!graph.Skip(wire_type)) {
+          return false;
+        }
+        continue;
+      }
+      const uint8_t *tensor_data = nullptr;
+      size_t tensor_size = 0;
+      RawInitializer tensor;
+      if (!graph.ReadLength(&tensor_data, &tensor_size) ||
+          !ParseTensor(tensor_data, tensor_size, &tensor)) {
+        return false;
+      }
+      initializers->push_back(std::move(tensor));
+    }
+  }
+  return true;
+}
+
+size_t AlignUp(size_t size) {
+  return (size + kInitializerAlignment - 1) / kInitializerAlignment *
+         kInitializerAlignment;
+}
+
+} // namespace
+
+int LoadSharedInitializers(const void *model_data, size_t model_data_size,
+                           OnnxRuntimeSharedResources *shared) {
+  std::vector<RawInitializer> parsed;
+  if (!ParseInitializers((const uint8_t *)model_data, model_data_size,
+                         &parsed)) {
+    LOG_ERROR("parse onnx model initializers failed");
+    return -1;
+  }
+
+  // 只共享 raw_data 完整的数值 tensor
+  std::vector<RawInitializer> initializers;
+  size_t total_size = 0;
+  for (auto &tensor : parsed) {
+    size_t element_size = ElementSize(tensor.data_type);
+    if (tensor.name.empty() || tensor.external || tensor.data == nullptr ||
+        element_size == 0) {
+      continue;
+    }
+    size_t element_count = 1;
+    for (auto dim : tensor.dims) {
+      element_count *= (size_t)dim;
+    }
+    if (tensor.size != element_count * element_size || tensor.size == 0) {
+      continue;
+    }
+    total_size += AlignUp(tensor.size);
+    initializers.push_back(std::move(tensor));
+  }
+
+  shared->initializer_names.clear();
+  shared->initializers.clear();
+  shared->initializer_data.reset();
+  if (initializers.empty()) {
+    return 0;
+  }
+
+  // new char[] 只保证 alignof(max_align_t), 多申请一段用于对齐
+  shared->initializer_data =
+      std::make_unique<char[]>(total_size + kInitializerAlignment);
+  auto base = (uintptr_t)shared->initializer_data.get();
+  char *dst = shared->initializer_data.get() + (AlignUp(base) - base);
+  auto memory_info =
+      Ort::MemoryInfo::CreateCpu(OrtDeviceAllocator, OrtMemTypeDefault);
+  shared->initializer_names.reserve(initializers.size());
+  shared->initializers.reserve(initializers.size());
+  for (const auto &tensor : initializers) {
+    memcpy(dst, tensor.data, tensor.size);
+    shared->initializers.push_back(Ort::Value::CreateTensor(
+        memory_info, dst, tensor.size, tensor.dims.data(), tensor.dims.size(),
+        (ONNXTensorElementDataType)tensor.data_type));
+    shared->initializer_names.push_back(tensor.name);
+    dst += AlignUp(tensor.size);
+  }
+  LOG_INFO("load shared initializers, count: {}, size: {}",
+           shared->initializers.size(), total_size);
+  return 0;
+}
+
+} // namespace inference
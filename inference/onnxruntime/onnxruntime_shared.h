@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <onnxruntime_cxx_api.h>
+
+namespace inference {
+
+// 同一个模型的多个 session 之间共享的资源, 由 OnnxRuntimeEngineGroup 持有,
+// 生命周期需要长于使用它的所有 engine
+struct OnnxRuntimeSharedResources {
+  // cpu 推理时使用 Ort::Env 中注册的共享 arena, 而不是每个 session 一个
+  bool use_env_allocators = true;
+
+  // 从模型中只读取一次的 initializer, 通过 AddInitializer 注册到每个
+  // session, 所有 session 引用同一份权重
+  std::vector<std::string> initializer_names;
+  std::vector<Ort::Value> initializers;
+  // initializers 引用的数据, 按 64 字节对齐存放
+  std::unique_ptr<char[]> initializer_data;
+
+  // 共享 initializer 预处理(prepack)后的权重, 只对 AddInitializer 注册的
+  // initializer 生效, 为空时不共享
+  std::unique_ptr<Ort::PrepackedWeightsContainer> prepacked_weights;
+};
+
+/**
+ * @brief 从 .onnx 模型的主图中读取 raw_data 形式保存的 initializer,
+ * 拷贝一份后创建 cpu 上的 Ort::Value 存入 shared
+ *
+ * 外部数据, string 和按类型字段保存的 initializer 不读取, 仍然由每个
+ * session 自己加载; 模型格式错误返回 -1
+ */
+int LoadSharedInitializers(const void *model_data, size_t model_data_size,
+                           OnnxRuntimeSharedResources *shared);
+
+} // namespace inference
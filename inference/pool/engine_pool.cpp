@@ -0,0 +1,156 @@
+#include "inference/pool/engine_pool.h"
+
+#include "inference/onnxruntime/onnxruntime.h"
+#include <cpptoolkit/log/log.h>
+#include <cpptoolkit/strings/to_string.h>
+
+#include <climits>
+#include <cstring>
+
+namespace inference {
+
+namespace {
+
+void TouchTensor(const TensorDataPointer &tensor) {
+  if (tensor.p == nullptr) {
+    return;
+  }
+  size_t batch_num = tensor.p_arr.empty() ? 1 : tensor.p_arr.size();
+  memset(tensor.p, 0, tensor.mem_size * batch_num);
+}
+
+// 在当前线程首次写入输入输出 buffer, 物理内存分配在当前线程所在的 numa node
+void FirstTouchTensors(InferenceEngine *engine) {
+  for (auto &[name, tensor] : engine->GetInputTensors()) {
+    TouchTensor(tensor);
+  }
+  for (auto &[name, tensor] : engine->GetOutputTensors()) {
+    TouchTensor(tensor);
+  }
+}
+
+} // namespace
+
+int EnginePool::Init(const InferenceParams &params,
+                     const EnginePoolParams &pool_params,
+                     EngineCreator creator) {
+  if (IsReady()) {
+    LOG_WARN("EnginePool::Init: pool is ready, deinit first");
+    Deinit();
+  }
+  if (pool_params.instance_num < 1) {
+    LOG_ERROR("EnginePool::Init: invalid instance num {}",
+              pool_params.instance_num);
+    return -1;
+  }
+  if (!creator) {
+    creator = []() { return std::make_unique<OnnxRuntimeEngine>(); };
+  }
+
+  int instance_num = pool_params.instance_num;
+  std::vector<CpuSet> cpu_sets;
+  if (pool_params.pin_cpu) {
+    if (params.use_global_thread_pool) {
+      LOG_WARN("EnginePool::Init: global thread pool is not pinned");
+    }
+    cpu_sets = SplitCpuSets(instance_num, pool_params.numa_aware);
+  }
+
+  // 各个实例在自己的工作线程中并行初始化
+  std::vector<InferenceParams> instance_params(instance_num, params);
+  std::vector<std::future<int>> init_futures;
+  for (int i = 0; i < instance_num; i++) {
+    auto instance = std::make_unique<Instance>();
+    instance->engine = creator();
+    instance->worker = std::make_unique<ThreadPool>(1);
+    if (!cpu_sets.empty()) {
+      instance->cpus = cpu_sets[i];
+      instance_params[i].cpu_affinity = instance->cpus;
+      if (instance_params[i].intra_op_num_threads <= 0) {
+        instance_params[i].intra_op_num_threads = instance->cpus.size();
+      }
+      LOG_INFO("engine instance {}, numa node {}, cpus {}", i,
+               GetCpuNumaNode(instance->cpus[0]),
+               cpptoolkit::ToString(instance->cpus));
+    }
+
+    auto *inst = instance.get();
+    const auto &inst_params = instance_params[i];
+    init_futures.push_back(inst->worker->Submit([inst, &inst_params]() {
+      if (!inst->cpus.empty()) {
+        SetCurrentThreadAffinity(inst->cpus);
+      }
+      int ret = inst->engine->Init(inst_params);
+      if (ret == 0) {
+        FirstTouchTensors(inst->engine.get());
+      }
+      return ret;
+    }));
+    instances_.push_back(std::move(instance));
+  }
+
+  int ret = 0;
+  for (int i = 0; i < instance_num; i++) {
+    if (init_futures[i].get() != 0) {
+      LOG_ERROR("EnginePool::Init: init engine instance {} failed", i);
+      ret = -1;
+    }
+  }
+  if (ret != 0) {
+    Deinit();
+    return -1;
+  }
+  return 0;
+}
+
+void EnginePool::Deinit() {
+  // 先等待每个实例的任务执行完成, 再释放 engine
+  instances_.clear();
+  next_instance_ = 0;
+}
+
+const CpuSet &EnginePool::GetInstanceCpus(int index) const {
+  static const CpuSet empty_cpus;
+  if (index < 0 || index >= (int)instances_.size()) {
+    return empty_cpus;
+  }
+  return instances_[index]->cpus;
+}
+
+std::future<int> EnginePool::Submit(EngineTask task) {
+  if (instances_.empty()) {
+    LOG_ERROR("EnginePool::Submit: pool is not ready");
+    std::promise<int> promise;
+    promise.set_value(-1);
+    return promise.get_future();
+  }
+
+  // 从轮询的起点开始找排队最少的实例, 排队数相同时轮流使用
+  int instance_num = instances_.size();
+  int start = next_instance_.fetch_add(1) % instance_num;
+  Instance *best = nullptr;
+  int best_pending = INT_MAX;
+  for (int i = 0; i < instance_num; i++) {
+    auto *instance = instances_[(start + i) % instance_num].get();
+    int pending = instance->pending.load(std::memory_order_relaxed);
+    if (pending < best_pending) {
+      best = instance;
+      best_pending = pending;
+    }
+  }
+
+  best->pending++;
+  return best->worker->Submit([best, task = std::move(task)]() {
+    int ret = -1;
+    try {
+      ret = task(best->engine.get());
+    } catch (...) {
+      best->pending--;
+      throw;
+    }
+    best->pending--;
+    return ret;
+  });
+}
+
+} // namespace inference
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <future>
+#include <memory>
+#include <vector>
+
+#include "inference/inference_engine.h"
+#include "inference/utils/cpu_affinity.h"
+#include "inference/utils/thread_pool.h"
+#include <cpptoolkit/construct/construct.h>
+
+namespace inference {
+
+struct EnginePoolParams {
+  int instance_num = 1;
+  // 每个实例分配互不重叠的 cpu 集合, 实例的工作线程和 intra op 线程绑定在上面
+  bool pin_cpu = true;
+  // 每个实例的 cpu 集合只包含同一个 numa node 的 cpu
+  bool numa_aware = true;
+};
+
+// 在实例的工作线程中执行, 填充输入, Run, 读取输出, 返回 0 表示成功
+using EngineTask = std::function<int(InferenceEngine *engine)>;
+using EngineCreator = std::function<std::unique_ptr<InferenceEngine>()>;
+
+/**
+ * @brief 同一个模型的多个 engine 实例, 请求派发到排队最少的实例
+ *
+ * 每个实例有一个绑定到自己 cpu 集合的工作线程, engine 的 Init 也在该线程中
+ * 执行, session 和输入输出 buffer 首次写入(first touch)都发生在本地 numa node
+ * intra_op_num_threads <= 0 时每个实例使用自己 cpu 集合中的全部 cpu
+ */
+class EnginePool {
+public:
+  EnginePool() {}
+  ~EnginePool() { Deinit(); }
+
+  CPP_TK_NON_COPY_CONSTRUCT(EnginePool);
+  CPP_TK_NON_MOVE_CONSTRUCT(EnginePool);
+
+  /**
+   * @brief 创建 instance_num 个实例, creator 为空时创建 OnnxRuntimeEngine
+   */
+  int Init(const InferenceParams &params, const EnginePoolParams &pool_params,
+           EngineCreator creator = nullptr);
+  void Deinit();
+
+  bool IsReady() const { return !instances_.empty(); }
+  int InstanceNum() const { return (int)instances_.size(); }
+
+  // 实例绑定的 cpu, 不绑核时为空
+  const CpuSet &GetInstanceCpus(int index) const;
+
+  /**
+   * @brief 提交任务到排队最少的实例
+   */
+  std::future<int> Submit(EngineTask task);
+
+private:
+  struct Instance {
+    std::unique_ptr<InferenceEngine> engine;
+    CpuSet cpus;
+    // 已提交未完成的任务数
+    std::atomic<int> pending{0};
+    // 析构时先等待队列中的任务完成, 需要在 engine 之前释放
+    std::unique_ptr<ThreadPool> worker;
+  };
+
+  std::vector<std::unique_ptr<Instance>> instances_;
+  std::atomic<unsigned> next_instance_{0};
+};
+
+} // namespace inference
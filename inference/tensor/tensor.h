@@ -68,6 +68,11 @@ using OutputNodeNamePointers = std::vector<char *>;
 using OutputTensorDescs = std::map<std::string, TensorDesc>;
 using OutputTensorPointers = std::map<std::string, TensorDataPointer>;
 
+// 输入输出张量的句柄, 即名称在 InputNodeNames/OutputNodeNames 中的下标,
+// Init 之后通过名称获取一次, 推理时按句柄访问, 不需要查找名称
+using TensorHandle = int;
+constexpr TensorHandle kInvalidTensorHandle = -1;
+
 size_t GetDataTypeSize(TensorDataType data_type);
 
 size_t GetElemMemSize(TensorDataType data_type, size_t element_size);
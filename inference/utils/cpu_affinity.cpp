@@ -0,0 +1,183 @@
+#include "inference/utils/cpu_affinity.h"
+
+#include <cpptoolkit/log/log.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <map>
+#include <thread>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace inference {
+
+namespace fs = std::filesystem;
+
+CpuSet GetAllowedCpus() {
+  CpuSet cpus;
+#ifdef __linux__
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  if (sched_getaffinity(0, sizeof(cpu_set), &cpu_set) == 0) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+      if (CPU_ISSET(cpu, &cpu_set)) {
+        cpus.push_back(cpu);
+      }
+    }
+  }
+#endif
+  if (cpus.empty()) {
+    int cpu_num = std::max(1u, std::thread::hardware_concurrency());
+    for (int cpu = 0; cpu < cpu_num; cpu++) {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+
+int GetCpuNumaNode(int cpu) {
+  std::error_code ec;
+  fs::path cpu_dir = fmt::format("/sys/devices/system/cpu/cpu{}", cpu);
+  for (const auto &entry : fs::directory_iterator(cpu_dir, ec)) {
+    auto name = entry.path().filename().string();
+    if (name.size() > 4 && name.compare(0, 4, "node") == 0) {
+      return atoi(name.c_str() + 4);
+    }
+  }
+  return 0;
+}
+
+std::vector<CpuSet> GetNumaNodeCpus() {
+  std::map<int, CpuSet> node_cpus;
+  for (int cpu : GetAllowedCpus()) {
+    node_cpus[GetCpuNumaNode(cpu)].push_back(cpu);
+  }
+  std::vector<CpuSet> result;
+  for (auto &[node, cpus] : node_cpus) {
+    result.push_back(std::move(cpus));
+  }
+  return result;
+}
+
+namespace {
+
+// 把 cpus 连续地平均切分成 set_num 份, cpu 不够时循环使用
+void SplitCpus(const CpuSet &cpus, int set_num, std::vector<CpuSet> *sets) {
+  int cpu_num = cpus.size();
+  if (cpu_num < set_num) {
+    for (int i = 0; i < set_num; i++) {
+      sets->push_back({cpus[i % cpu_num]});
+    }
+    return;
+  }
+  for (int i = 0; i < set_num; i++) {
+    int begin = i * cpu_num / set_num;
+    int end = (i + 1) * cpu_num / set_num;
+    sets->emplace_back(cpus.begin() + begin, cpus.begin() + end);
+  }
+}
+
+} // namespace
+
+std::vector<CpuSet> SplitCpuSets(int set_num, bool numa_aware) {
+  std::vector<CpuSet> sets;
+  if (set_num < 1) {
+    return sets;
+  }
+
+  auto node_cpus = GetNumaNodeCpus();
+  int cpu_num = 0;
+  for (auto &cpus : node_cpus) {
+    cpu_num += cpus.size();
+  }
+  if (cpu_num < set_num) {
+    LOG_WARN("cpu num {} is less than instance num {}, cpu sets overlap",
+             cpu_num, set_num);
+  }
+
+  if (!numa_aware || node_cpus.size() <= 1 || cpu_num < set_num) {
+    CpuSet all_cpus;
+    for (auto &cpus : node_cpus) {
+      all_cpus.insert(all_cpus.end(), cpus.begin(), cpus.end());
+    }
+    SplitCpus(all_cpus, set_num, &sets);
+    return sets;
+  }
+
+  // 按 cpu 数量把实例分配到各个 node, 余数分给剩余 cpu 最多的 node
+  int node_num = node_cpus.size();
+  std::vector<int> node_sets(node_num, 0);
+  int assigned = 0;
+  for (int i = 0; i < node_num; i++) {
+    node_sets[i] = set_num * (int)node_cpus[i].size() / cpu_num;
+    assigned += node_sets[i];
+  }
+  while (assigned < set_num) {
+    int best = 0;
+    double best_cpus = -1;
+    for (int i = 0; i < node_num; i++) {
+      double cpus_per_set =
+          (double)node_cpus[i].size() / (node_sets[i] + 1);
+      if (cpus_per_set > best_cpus) {
+        best_cpus = cpus_per_set;
+        best = i;
+      }
+    }
+    node_sets[best]++;
+    assigned++;
+  }
+
+  // 实例按 node 交替排列, 前几个实例分散在不同的 node 上
+  std::vector<std::vector<CpuSet>> per_node(node_num);
+  for (int i = 0; i < node_num; i++) {
+    if (node_sets[i] > 0) {
+      SplitCpus(node_cpus[i], node_sets[i], &per_node[i]);
+    }
+  }
+  for (int round = 0; (int)sets.size() < set_num; round++) {
+    for (int i = 0; i < node_num; i++) {
+      if (round < (int)per_node[i].size()) {
+        sets.push_back(std::move(per_node[i][round]));
+      }
+    }
+  }
+  return sets;
+}
+
+int SetCurrentThreadAffinity(const CpuSet &cpus) {
+#ifdef __linux__
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  for (int cpu : cpus) {
+    if (cpu >= 0 && cpu < CPU_SETSIZE) {
+      CPU_SET(cpu, &cpu_set);
+    }
+  }
+  int ret = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+  if (ret != 0) {
+    LOG_WARN("set thread affinity failed: {}", ret);
+    return -1;
+  }
+  return 0;
+#else
+  LOG_WARN("set thread affinity is not supported");
+  return -1;
+#endif
+}
+
+std::string GetIntraOpThreadAffinities(const CpuSet &cpus, int thread_num) {
+  // onnxruntime 中 cpu 编号从 1 开始, 调用线程使用 cpus[0]
+  std::string affinities;
+  for (int i = 1; i < thread_num && !cpus.empty(); i++) {
+    if (!affinities.empty()) {
+      affinities += ";";
+    }
+    affinities += std::to_string(cpus[i % cpus.size()] + 1);
+  }
+  return affinities;
+}
+
+} // namespace inference
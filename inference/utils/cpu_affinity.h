@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace inference {
+
+using CpuSet = std::vector<int>;
+
+/**
+ * @brief 当前进程允许使用的 cpu, 获取失败时返回 [0, hardware_concurrency)
+ */
+CpuSet GetAllowedCpus();
+
+/**
+ * @brief cpu 所在的 numa node, 从 /sys/devices/system/cpu/cpuN/nodeK 读取,
+ * 没有 numa 信息时返回 0
+ */
+int GetCpuNumaNode(int cpu);
+
+/**
+ * @brief 按 numa node 分组的可用 cpu, 下标为分组顺序, 不一定等于 node id
+ */
+std::vector<CpuSet> GetNumaNodeCpus();
+
+/**
+ * @brief 把可用 cpu 切分成 set_num 个互不重叠的集合
+ *
+ * numa_aware 为 true 时按各个 node 的 cpu 数量分配实例, 每个集合只包含
+ * 同一个 node 的 cpu; cpu 数量少于 set_num 时集合之间会重叠
+ */
+std::vector<CpuSet> SplitCpuSets(int set_num, bool numa_aware = true);
+
+/**
+ * @brief 绑定当前线程到 cpus, 不支持的平台返回 -1
+ */
+int SetCurrentThreadAffinity(const CpuSet &cpus);
+
+/**
+ * @brief onnxruntime session.intra_op_thread_affinities 配置,
+ * 为除调用线程以外的 thread_num - 1 个 intra op 线程依次分配 cpus 中的 cpu
+ */
+std::string GetIntraOpThreadAffinities(const CpuSet &cpus, int thread_num);
+
+} // namespace inference
@@ -0,0 +1,98 @@
+#include "inference/utils/latency_stats.h"
+
+#include <algorithm>
+
+namespace inference {
+
+std::ostream &operator<<(std::ostream &s, const LatencySummary &summary) {
+  return s << "LatencySummary(" << "count:" << summary.count
+           << ", mean_us:" << summary.mean_us << ", p50_us:" << summary.p50_us
+           << ", p90_us:" << summary.p90_us << ", p99_us:" << summary.p99_us
+           << ", max_us:" << summary.max_us << ")";
+}
+
+int LatencyHistogram::BucketIndex(uint64_t latency_ns) {
+  if (latency_ns < kLinearBucketNum) {
+    return (int)latency_ns;
+  }
+  // 最高位决定所在的 2 的幂区间, 接下来的 kSubBucketBits 位决定子桶
+  int msb = 63 - __builtin_clzll(latency_ns);
+  int sub = (latency_ns >> (msb - kSubBucketBits)) &
+            ((1 << kSubBucketBits) - 1);
+  return kLinearBucketNum + ((msb - 4) << kSubBucketBits) + sub;
+}
+
+uint64_t LatencyHistogram::BucketLower(int index) {
+  if (index < kLinearBucketNum) {
+    return index;
+  }
+  int msb = ((index - kLinearBucketNum) >> kSubBucketBits) + 4;
+  uint64_t sub = (index - kLinearBucketNum) & ((1 << kSubBucketBits) - 1);
+  return ((1ull << kSubBucketBits) + sub) << (msb - kSubBucketBits);
+}
+
+uint64_t LatencyHistogram::BucketUpper(int index) {
+  if (index + 1 >= kBucketNum) {
+    return UINT64_MAX;
+  }
+  return BucketLower(index + 1);
+}
+
+void LatencyHistogram::Record(uint64_t latency_ns) {
+  buckets_[BucketIndex(latency_ns)].fetch_add(1, std::memory_order_relaxed);
+  count_.fetch_add(1, std::memory_order_relaxed);
+  sum_ns_.fetch_add(latency_ns, std::memory_order_relaxed);
+  uint64_t max_ns = max_ns_.load(std::memory_order_relaxed);
+  while (latency_ns > max_ns &&
+         !max_ns_.compare_exchange_weak(max_ns, latency_ns,
+                                        std::memory_order_relaxed)) {
+  }
+}
+
+void LatencyHistogram::Reset() {
+  for (auto &bucket : buckets_) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+  count_.store(0, std::memory_order_relaxed);
+  sum_ns_.store(0, std::memory_order_relaxed);
+  max_ns_.store(0, std::memory_order_relaxed);
+}
+
+LatencySummary LatencyHistogram::Summary() const {
+  LatencySummary summary;
+  std::array<uint64_t, kBucketNum> buckets;
+  uint64_t count = 0;
+  for (int i = 0; i < kBucketNum; i++) {
+    buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+    count += buckets[i];
+  }
+  if (count == 0) {
+    return summary;
+  }
+
+  uint64_t max_ns = max_ns_.load(std::memory_order_relaxed);
+  summary.count = count;
+  summary.mean_us = sum_ns_.load(std::memory_order_relaxed) / 1e3 / count;
+  summary.max_us = max_ns / 1e3;
+
+  // 分位数取所在桶的中点, 不超过最大值
+  auto percentile = [&](double q) {
+    uint64_t rank = std::max<uint64_t>(1, (uint64_t)(q * count + 0.5));
+    uint64_t seen = 0;
+    for (int i = 0; i < kBucketNum; i++) {
+      seen += buckets[i];
+      if (seen >= rank) {
+        double lower = BucketLower(i);
+        double upper = std::min<double>(BucketUpper(i), max_ns + 1.0);
+        return std::min<double>((lower + upper) / 2, max_ns) / 1e3;
+      }
+    }
+    return max_ns / 1e3;
+  };
+  summary.p50_us = percentile(0.50);
+  summary.p90_us = percentile(0.90);
+  summary.p99_us = percentile(0.99);
+  return summary;
+}
+
+} // namespace inference
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+#include <cpptoolkit/construct/construct.h>
+
+namespace inference {
+
+// 延迟统计结果, 单位 us
+struct LatencySummary {
+  uint64_t count = 0;
+  double mean_us = 0;
+  double p50_us = 0;
+  double p90_us = 0;
+  double p99_us = 0;
+  double max_us = 0;
+};
+
+std::ostream &operator<<(std::ostream &s, const LatencySummary &summary);
+
+/**
+ * @brief 对数分桶的延迟直方图, 记录只有几次 relaxed 原子操作, 无锁
+ *
+ * 16ns 以下每 1ns 一个桶, 之后每个 2 的幂区间分成 8 个桶, 相对误差不超过
+ * 12.5%, 分位数取桶的中点; 多线程并发 Record 时 Summary 得到的是近似快照
+ */
+class LatencyHistogram {
+public:
+  LatencyHistogram() { Reset(); }
+
+  CPP_TK_NON_COPY_CONSTRUCT(LatencyHistogram);
+  CPP_TK_NON_MOVE_CONSTRUCT(LatencyHistogram);
+
+  void Record(uint64_t latency_ns);
+  void Reset();
+
+  LatencySummary Summary() const;
+
+  static constexpr int kLinearBucketNum = 16;
+  static constexpr int kSubBucketBits = 3;
+  static constexpr int kBucketNum =
+      kLinearBucketNum + (64 - 4) * (1 << kSubBucketBits);
+
+  static int BucketIndex(uint64_t latency_ns);
+  // 桶的范围 [lower, upper)
+  static uint64_t BucketLower(int index);
+  static uint64_t BucketUpper(int index);
+
+private:
+  std::array<std::atomic<uint64_t>, kBucketNum> buckets_;
+  std::atomic<uint64_t> count_{0};
+  std::atomic<uint64_t> sum_ns_{0};
+  std::atomic<uint64_t> max_ns_{0};
+};
+
+using LatencyClock = std::chrono::steady_clock;
+
+inline uint64_t ElapsedNs(LatencyClock::time_point start,
+                          LatencyClock::time_point end) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)
+      .count();
+}
+
+} // namespace inference
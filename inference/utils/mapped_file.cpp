@@ -0,0 +1,120 @@
+#include "inference/utils/mapped_file.h"
+
+#include <cpptoolkit/log/log.h>
+
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define INFERENCE_USE_MMAP 1
+#endif
+
+namespace inference {
+
+namespace fs = std::filesystem;
+
+MappedFile::~MappedFile() {
+#ifdef INFERENCE_USE_MMAP
+  if (mapped_) {
+    munmap((void *)data_, size_);
+  }
+#endif
+}
+
+int MappedFile::Load(const std::string &path) {
+  path_ = path;
+
+#ifdef INFERENCE_USE_MMAP
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    LOG_ERROR("open file: {} failed", path);
+    return -1;
+  }
+  struct stat st;
+  if (fstat(fd, &st) == 0 && st.st_size > 0) {
+    void *addr =
+        mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (addr != MAP_FAILED) {
+      data_ = addr;
+      size_ = (size_t)st.st_size;
+      mapped_ = true;
+    } else {
+      LOG_WARN("mmap file: {} failed, fallback to read", path);
+    }
+  }
+  // 映射建立后关闭 fd 不影响映射
+  close(fd);
+  if (mapped_) {
+    return 0;
+  }
+#endif
+
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  if (!file.is_open()) {
+    LOG_ERROR("open file: {} failed", path);
+    return -1;
+  }
+  buffer_.resize((size_t)file.tellg());
+  file.seekg(0);
+  if (!file.read(buffer_.data(), buffer_.size())) {
+    LOG_ERROR("read file: {} failed", path);
+    return -1;
+  }
+  data_ = buffer_.data();
+  size_ = buffer_.size();
+  return 0;
+}
+
+std::shared_ptr<const MappedFile> MappedFile::Open(const std::string &path) {
+  std::shared_ptr<MappedFile> file(new MappedFile());
+  if (file->Load(path) != 0) {
+    return nullptr;
+  }
+  return file;
+}
+
+std::shared_ptr<const MappedFile>
+MappedFile::OpenShared(const std::string &path) {
+  static std::mutex registry_mutex;
+  static std::unordered_map<std::string, std::weak_ptr<const MappedFile>>
+      registry;
+
+  // 同一个文件的不同写法(相对路径, 符号链接)映射为同一个 key
+  std::error_code ec;
+  auto key = fs::weakly_canonical(path, ec).string();
+  if (ec) {
+    key = path;
+  }
+
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  auto iter = registry.find(key);
+  if (iter != registry.end()) {
+    if (auto file = iter->second.lock()) {
+      return file;
+    }
+  }
+
+  auto file = Open(path);
+  if (!file) {
+    return nullptr;
+  }
+  registry[key] = file;
+
+  // 清理已经释放的映射
+  for (auto it = registry.begin(); it != registry.end();) {
+    if (it->second.expired()) {
+      it = registry.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  return file;
+}
+
+} // namespace inference
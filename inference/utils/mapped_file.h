@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <cpptoolkit/construct/construct.h>
+
+namespace inference {
+
+/**
+ * @brief 只读映射到内存的文件
+ *
+ * 优先使用 mmap, 不支持 mmap 的平台或映射失败时退化为读取到内存
+ */
+class MappedFile {
+public:
+  ~MappedFile();
+
+  CPP_TK_NON_COPY_CONSTRUCT(MappedFile);
+  CPP_TK_NON_MOVE_CONSTRUCT(MappedFile);
+
+  /**
+   * @brief 映射文件, 失败返回 nullptr
+   */
+  static std::shared_ptr<const MappedFile> Open(const std::string &path);
+
+  /**
+   * @brief 进程内共享的映射, 同一个文件只映射一次,
+   * 所有引用释放后解除映射, 失败返回 nullptr
+   */
+  static std::shared_ptr<const MappedFile> OpenShared(const std::string &path);
+
+  const void *Data() const { return data_; }
+  size_t Size() const { return size_; }
+  const std::string &Path() const { return path_; }
+  // 是否是 mmap 映射, false 表示文件内容读取到了内存中
+  bool IsMapped() const { return mapped_; }
+
+private:
+  MappedFile() = default;
+
+  int Load(const std::string &path);
+
+  std::string path_;
+  const void *data_ = nullptr;
+  size_t size_ = 0;
+  bool mapped_ = false;
+  // 不使用 mmap 时的文件内容
+  std::vector<char> buffer_;
+};
+
+using MappedFileSPtr = std::shared_ptr<const MappedFile>;
+
+} // namespace inference
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <cpptoolkit/construct/construct.h>
+
+namespace inference {
+
+/**
+ * @brief 固定线程数的任务队列线程池
+ *
+ * 析构时会先执行完队列中剩余的任务再退出
+ */
+class ThreadPool {
+public:
+  explicit ThreadPool(int thread_num);
+  ~ThreadPool();
+
+  CPP_TK_NON_COPY_CONSTRUCT(ThreadPool);
+  CPP_TK_NON_MOVE_CONSTRUCT(ThreadPool);
+
+  /**
+   * @brief 投递任务, 不关心返回值
+   */
+  void Post(std::function<void()> task);
+
+  /**
+   * @brief 投递任务, 通过 future 获取返回值
+   */
+  template <typename F>
+  auto Submit(F &&f) -> std::future<std::invoke_result_t<F>> {
+    using R = std::invoke_result_t<F>;
+    auto task =
+        std::make_shared<std::packaged_task<R()>>(std::forward<F>(f));
+    auto future = task->get_future();
+    Post([task]() { (*task)(); });
+    return future;
+  }
+
+  int ThreadNum() const { return (int)workers_.size(); }
+
+private:
+  void WorkerLoop();
+
+  std::vector<std::thread> workers_;
+  std::deque<std::function<void()>> tasks_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool stop_ = false;
+};
+
+} // namespace inference
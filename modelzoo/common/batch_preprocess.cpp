@@ -0,0 +1,82 @@
+#include "batch_preprocess.h"
+
+#include "img_common.hpp"
+
+#include <cpptoolkit/log/log.h>
+
+#include <algorithm>
+
+namespace imgutils {
+
+namespace {
+
+// 处理 [begin, end) 范围的样本, 遇到失败立即返回
+int RunSamples(const inference::TensorDataPointer &tensor, int begin, int end,
+               const SampleFunc &func) {
+  for (int i = begin; i < end; i++) {
+    int ret = 0;
+    try {
+      ret = func(i, tensor.p_arr[i]);
+    } catch (const std::exception &e) {
+      LOG_ERROR("preprocess sample:{} failed: {}", i, e.what());
+      return -1;
+    }
+    if (ret != 0) {
+      LOG_ERROR("preprocess sample:{} failed, ret:{}", i, ret);
+      return -1;
+    }
+  }
+  return 0;
+}
+
+} // namespace
+
+int PreprocessBatch(inference::ThreadPool *pool,
+                    const inference::TensorDataPointer &tensor, int batch_size,
+                    const SampleFunc &func) {
+  if (batch_size <= 0 || batch_size > (int)tensor.p_arr.size()) {
+    LOG_ERROR("batch_size:{} out of range, max_batch_size:{}", batch_size,
+              tensor.p_arr.size());
+    return -1;
+  }
+
+  int chunk_num = 1;
+  if (pool != nullptr && tensor.mem_size >= kMinParallelSampleBytes) {
+    chunk_num = std::min(batch_size, pool->ThreadNum() + 1);
+  }
+  auto chunk_begin = [&](int chunk) {
+    return (int)((int64_t)batch_size * chunk / chunk_num);
+  };
+
+  std::vector<std::future<int>> futures;
+  futures.reserve(chunk_num - 1);
+  for (int chunk = 1; chunk < chunk_num; chunk++) {
+    int begin = chunk_begin(chunk);
+    int end = chunk_begin(chunk + 1);
+    futures.push_back(pool->Submit([&tensor, &func, begin, end]() {
+      return RunSamples(tensor, begin, end, func);
+    }));
+  }
+
+  // 调用线程处理第一份, 然后等待其余的完成, 保证返回前不再访问 tensor
+  int ret = RunSamples(tensor, 0, chunk_begin(1), func);
+  for (auto &future : futures) {
+    if (future.get() != 0) {
+      ret = -1;
+    }
+  }
+  return ret;
+}
+
+int BlobNormalizeBatch(inference::ThreadPool *pool,
+                       const std::vector<cv::Mat> &imgs,
+                       const inference::TensorDataPointer &tensor) {
+  return PreprocessBatch(pool, tensor, (int)imgs.size(),
+                         [&](int index, void *dst) {
+                           BlobNormalizeFromImage(imgs[index], dst,
+                                                  tensor.data_type);
+                           return 0;
+                         });
+}
+
+} // namespace imgutils
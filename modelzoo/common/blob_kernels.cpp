@@ -0,0 +1,364 @@
+#include "blob_kernels.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BLOB_KERNELS_X86 1
+#include <immintrin.h>
+// 只对单个函数打开指令集, 其余代码仍按默认的编译选项生成
+#define KERNEL_TARGET(isa) __attribute__((target(isa)))
+#else
+#define BLOB_KERNELS_X86 0
+#endif
+
+namespace imgutils {
+
+namespace {
+
+// 像素数超过该值时才按行并行, 小图的线程调度开销大于收益
+constexpr int kParallelMinPixels = 512 * 512;
+constexpr int kParallelRowsPerStripe = 32;
+
+template <typename T>
+using RowKernel = void (*)(const uint8_t *src, int width, int channels,
+                           const ChannelAffine &affine, T *const *dst);
+
+// 处理一行中 [begin, end) 范围的像素, 也用于 SIMD 实现的尾部
+template <typename T>
+inline void HwcToChwRowScalar(const uint8_t *src, int begin, int end,
+                              int channels, const ChannelAffine &affine,
+                              T *const *dst) {
+  for (int x = begin; x < end; x++) {
+    for (int c = 0; c < channels; c++) {
+      dst[c][x] =
+          T(src[x * channels + c] * affine.scale[c] + affine.bias[c]);
+    }
+  }
+}
+
+template <typename T>
+void HwcToChwRowScalar(const uint8_t *src, int width, int channels,
+                       const ChannelAffine &affine, T *const *dst) {
+  HwcToChwRowScalar(src, 0, width, channels, affine, dst);
+}
+
+#if BLOB_KERNELS_X86
+
+// 把 16 个 BGR 交错像素(48 字节)拆分为 3 个通道, 每个通道 16 字节
+KERNEL_TARGET("sse4.1")
+inline void Deinterleave3(const uint8_t *src, __m128i &c0, __m128i &c1,
+                          __m128i &c2) {
+  __m128i a = _mm_loadu_si128((const __m128i *)src);
+  __m128i b = _mm_loadu_si128((const __m128i *)(src + 16));
+  __m128i c = _mm_loadu_si128((const __m128i *)(src + 32));
+  // 通道 k 的字节位于 3i + k, 分别从 a, b, c 中取出后合并, -1 的位置置 0
+  c0 = _mm_or_si128(
+      _mm_or_si128(_mm_shuffle_epi8(a, _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1,
+                                                     -1, -1, -1, -1, -1, -1,
+                                                     -1, -1, -1)),
+                   _mm_shuffle_epi8(b, _mm_setr_epi8(-1, -1, -1, -1, -1, -1,
+                                                     2, 5, 8, 11, 14, -1, -1,
+                                                     -1, -1, -1))),
+      _mm_shuffle_epi8(c, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                        -1, -1, 1, 4, 7, 10, 13)));
+  c1 = _mm_or_si128(
+      _mm_or_si128(_mm_shuffle_epi8(a, _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1,
+                                                     -1, -1, -1, -1, -1, -1,
+                                                     -1, -1, -1)),
+                   _mm_shuffle_epi8(b, _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3,
+                                                     6, 9, 12, 15, -1, -1, -1,
+                                                     -1, -1))),
+      _mm_shuffle_epi8(c, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                        -1, -1, 2, 5, 8, 11, 14)));
+  c2 = _mm_or_si128(
+      _mm_or_si128(_mm_shuffle_epi8(a, _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1,
+                                                     -1, -1, -1, -1, -1, -1,
+                                                     -1, -1, -1)),
+                   _mm_shuffle_epi8(b, _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4,
+                                                     7, 10, 13, -1, -1, -1, -1,
+                                                     -1, -1))),
+      _mm_shuffle_epi8(c, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                        -1, 0, 3, 6, 9, 12, 15)));
+}
+
+// 16 个 uint8 转换为 float, 乘以 scale 加上 bias 后写入 dst
+KERNEL_TARGET("sse4.1")
+inline __m128 ConvertSse41(__m128i v, __m128 scale, __m128 bias) {
+  return _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepu8_epi32(v)), scale),
+                    bias);
+}
+
+KERNEL_TARGET("sse4.1")
+inline void StoreSse41(__m128i v, __m128 scale, __m128 bias, float *dst) {
+  _mm_storeu_ps(dst, ConvertSse41(v, scale, bias));
+  _mm_storeu_ps(dst + 4, ConvertSse41(_mm_srli_si128(v, 4), scale, bias));
+  _mm_storeu_ps(dst + 8, ConvertSse41(_mm_srli_si128(v, 8), scale, bias));
+  _mm_storeu_ps(dst + 12, ConvertSse41(_mm_srli_si128(v, 12), scale, bias));
+}
+
+KERNEL_TARGET("avx2,f16c")
+inline __m256 ConvertAvx2(__m128i v, __m256 scale, __m256 bias) {
+  return _mm256_add_ps(
+      _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(v)), scale), bias);
+}
+
+KERNEL_TARGET("avx2,f16c")
+inline void StoreAvx2(__m128i v, __m256 scale, __m256 bias, float *dst) {
+  _mm256_storeu_ps(dst, ConvertAvx2(v, scale, bias));
+  _mm256_storeu_ps(dst + 8, ConvertAvx2(_mm_srli_si128(v, 8), scale, bias));
+}
+
+KERNEL_TARGET("avx2,f16c")
+inline void StoreAvx2(__m128i v, __m256 scale, __m256 bias,
+                      half_float::half *dst) {
+  _mm_storeu_si128((__m128i *)dst,
+                   _mm256_cvtps_ph(ConvertAvx2(v, scale, bias),
+                                   _MM_FROUND_TO_NEAREST_INT));
+  _mm_storeu_si128(
+      (__m128i *)(dst + 8),
+      _mm256_cvtps_ph(ConvertAvx2(_mm_srli_si128(v, 8), scale, bias),
+                      _MM_FROUND_TO_NEAREST_INT));
+}
+
+KERNEL_TARGET("avx512f")
+inline __m512 ConvertAvx512(__m128i v, __m512 scale, __m512 bias) {
+  return _mm512_add_ps(
+      _mm512_mul_ps(_mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(v)), scale), bias);
+}
+
+KERNEL_TARGET("avx512f")
+inline void StoreAvx512(__m128i v, __m512 scale, __m512 bias, float *dst) {
+  _mm512_storeu_ps(dst, ConvertAvx512(v, scale, bias));
+}
+
+KERNEL_TARGET("avx512f")
+inline void StoreAvx512(__m128i v, __m512 scale, __m512 bias,
+                        half_float::half *dst) {
+  _mm256_storeu_si256((__m256i *)dst,
+                      _mm512_cvtps_ph(ConvertAvx512(v, scale, bias),
+                                      _MM_FROUND_TO_NEAREST_INT));
+}
+
+// 每次处理 16 个像素, 剩余不足 16 个的像素由标量实现处理
+KERNEL_TARGET("sse4.1")
+void HwcToChwRowSse41(const uint8_t *src, int width, int channels,
+                      const ChannelAffine &affine, float *const *dst) {
+  const __m128 scale[3] = {_mm_set1_ps(affine.scale[0]),
+                           _mm_set1_ps(affine.scale[1]),
+                           _mm_set1_ps(affine.scale[2])};
+  const __m128 bias[3] = {_mm_set1_ps(affine.bias[0]),
+                          _mm_set1_ps(affine.bias[1]),
+                          _mm_set1_ps(affine.bias[2])};
+  int x = 0;
+  if (channels == 3) {
+    for (; x + 16 <= width; x += 16) {
+      __m128i c0, c1, c2;
+      Deinterleave3(src + 3 * x, c0, c1, c2);
+      StoreSse41(c0, scale[0], bias[0], dst[0] + x);
+      StoreSse41(c1, scale[1], bias[1], dst[1] + x);
+      StoreSse41(c2, scale[2], bias[2], dst[2] + x);
+    }
+  } else {
+    for (; x + 16 <= width; x += 16) {
+      StoreSse41(_mm_loadu_si128((const __m128i *)(src + x)), scale[0],
+                 bias[0], dst[0] + x);
+    }
+  }
+  HwcToChwRowScalar(src, x, width, channels, affine, dst);
+}
+
+template <typename T>
+KERNEL_TARGET("avx2,f16c")
+void HwcToChwRowAvx2(const uint8_t *src, int width, int channels,
+                     const ChannelAffine &affine, T *const *dst) {
+  const __m256 scale[3] = {_mm256_set1_ps(affine.scale[0]),
+                           _mm256_set1_ps(affine.scale[1]),
+                           _mm256_set1_ps(affine.scale[2])};
+  const __m256 bias[3] = {_mm256_set1_ps(affine.bias[0]),
+                          _mm256_set1_ps(affine.bias[1]),
+                          _mm256_set1_ps(affine.bias[2])};
+  int x = 0;
+  if (channels == 3) {
+    for (; x + 16 <= width; x += 16) {
+      __m128i c0, c1, c2;
+      Deinterleave3(src + 3 * x, c0, c1, c2);
+      StoreAvx2(c0, scale[0], bias[0], dst[0] + x);
+      StoreAvx2(c1, scale[1], bias[1], dst[1] + x);
+      StoreAvx2(c2, scale[2], bias[2], dst[2] + x);
+    }
+  } else {
+    for (; x + 16 <= width; x += 16) {
+      StoreAvx2(_mm_loadu_si128((const __m128i *)(src + x)), scale[0],
+                bias[0], dst[0] + x);
+    }
+  }
+  HwcToChwRowScalar(src, x, width, channels, affine, dst);
+}
+
+template <typename T>
+KERNEL_TARGET("avx512f")
+void HwcToChwRowAvx512(const uint8_t *src, int width, int channels,
+                       const ChannelAffine &affine, T *const *dst) {
+  const __m512 scale[3] = {_mm512_set1_ps(affine.scale[0]),
+                           _mm512_set1_ps(affine.scale[1]),
+                           _mm512_set1_ps(affine.scale[2])};
+  const __m512 bias[3] = {_mm512_set1_ps(affine.bias[0]),
+                          _mm512_set1_ps(affine.bias[1]),
+                          _mm512_set1_ps(affine.bias[2])};
+  int x = 0;
+  if (channels == 3) {
+    for (; x + 16 <= width; x += 16) {
+      __m128i c0, c1, c2;
+      Deinterleave3(src + 3 * x, c0, c1, c2);
+      StoreAvx512(c0, scale[0], bias[0], dst[0] + x);
+      StoreAvx512(c1, scale[1], bias[1], dst[1] + x);
+      StoreAvx512(c2, scale[2], bias[2], dst[2] + x);
+    }
+  } else {
+    for (; x + 16 <= width; x += 16) {
+      StoreAvx512(_mm_loadu_si128((const __m128i *)(src + x)), scale[0],
+                  bias[0], dst[0] + x);
+    }
+  }
+  HwcToChwRowScalar(src, x, width, channels, affine, dst);
+}
+
+SimdLevel DetectSimdLevel() {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    return SimdLevel::kAVX512;
+  }
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("f16c")) {
+    return SimdLevel::kAVX2;
+  }
+  if (__builtin_cpu_supports("sse4.1")) {
+    return SimdLevel::kSSE41;
+  }
+  return SimdLevel::kScalar;
+}
+
+#else
+
+SimdLevel DetectSimdLevel() { return SimdLevel::kScalar; }
+
+#endif // BLOB_KERNELS_X86
+
+template <typename T> RowKernel<T> GetRowKernel(SimdLevel level) {
+#if BLOB_KERNELS_X86
+  switch (level) {
+  case SimdLevel::kAVX512:
+    return HwcToChwRowAvx512<T>;
+  case SimdLevel::kAVX2:
+    return HwcToChwRowAvx2<T>;
+  case SimdLevel::kSSE41:
+    // SSE4.1 没有 F16C, FP16 输出使用标量实现
+    if constexpr (std::is_same_v<T, float>) {
+      return HwcToChwRowSse41;
+    }
+    break;
+  default:
+    break;
+  }
+#endif
+  return HwcToChwRowScalar<T>;
+}
+
+template <typename T>
+void HwcToPlanesImpl(const cv::Mat &img, T *const *planes, size_t plane_step,
+                     const ChannelAffine &affine, SimdLevel level,
+                     bool parallel) {
+  if (img.type() != CV_8UC3 && img.type() != CV_8UC1) {
+    throw std::runtime_error("img type must be CV_8UC1 or CV_8UC3");
+  }
+  if (level > GetSimdLevel()) {
+    throw std::runtime_error(std::string("simd level not supported: ") +
+                             SimdLevelName(level));
+  }
+
+  RowKernel<T> kernel = GetRowKernel<T>(level);
+  int channels = img.channels();
+  int rows = img.rows;
+  int cols = img.cols;
+  auto convert_rows = [&](const cv::Range &range) {
+    T *dst[3];
+    for (int h = range.start; h < range.end; h++) {
+      for (int c = 0; c < channels; c++) {
+        dst[c] = planes[c] + (size_t)h * plane_step;
+      }
+      kernel(img.ptr<uint8_t>(h), cols, channels, affine, dst);
+    }
+  };
+
+  if (parallel && (size_t)rows * cols >= kParallelMinPixels) {
+    cv::parallel_for_(cv::Range(0, rows), convert_rows,
+                      (double)rows / kParallelRowsPerStripe);
+  } else {
+    convert_rows(cv::Range(0, rows));
+  }
+}
+
+template <typename T>
+void HwcToChwImpl(const cv::Mat &img, T *blob, float scale, SimdLevel level,
+                  bool parallel) {
+  size_t plane = img.total();
+  T *planes[3] = {blob, blob + plane, blob + 2 * plane};
+  ChannelAffine affine;
+  std::fill_n(affine.scale, 3, scale);
+  HwcToPlanesImpl(img, planes, img.cols, affine, level, parallel);
+}
+
+} // namespace
+
+SimdLevel GetSimdLevel() {
+  static const SimdLevel level = DetectSimdLevel();
+  return level;
+}
+
+const char *SimdLevelName(SimdLevel level) {
+  switch (level) {
+  case SimdLevel::kScalar:
+    return "scalar";
+  case SimdLevel::kSSE41:
+    return "sse4.1";
+  case SimdLevel::kAVX2:
+    return "avx2";
+  case SimdLevel::kAVX512:
+    return "avx512";
+  }
+  return "unknown";
+}
+
+void HwcToChw(const cv::Mat &img, float *blob, float scale, bool parallel) {
+  HwcToChwImpl(img, blob, scale, GetSimdLevel(), parallel);
+}
+
+void HwcToChw(const cv::Mat &img, half_float::half *blob, float scale,
+              bool parallel) {
+  HwcToChwImpl(img, blob, scale, GetSimdLevel(), parallel);
+}
+
+void HwcToChw(const cv::Mat &img, float *blob, float scale, SimdLevel level,
+              bool parallel) {
+  HwcToChwImpl(img, blob, scale, level, parallel);
+}
+
+void HwcToChw(const cv::Mat &img, half_float::half *blob, float scale,
+              SimdLevel level, bool parallel) {
+  HwcToChwImpl(img, blob, scale, level, parallel);
+}
+
+void HwcToPlanes(const cv::Mat &img, float *const *planes, size_t plane_step,
+                 const ChannelAffine &affine, bool parallel) {
+  HwcToPlanesImpl(img, planes, plane_step, affine, GetSimdLevel(), parallel);
+}
+
+void HwcToPlanes(const cv::Mat &img, half_float::half *const *planes,
+                 size_t plane_step, const ChannelAffine &affine,
+                 bool parallel) {
+  HwcToPlanesImpl(img, planes, plane_step, affine, GetSimdLevel(), parallel);
+}
+
+} // namespace imgutils
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cpptoolkit/fp16/half.hpp>
+#include <opencv2/core.hpp>
+
+namespace imgutils {
+
+// HWC 转 CHW 内核使用的指令集, 数值越大指令集越新
+enum class SimdLevel {
+  kScalar = 0,
+  kSSE41 = 1,
+  kAVX2 = 2,   // AVX2 + F16C
+  kAVX512 = 3, // AVX-512F
+};
+
+// 每个通道的线性变换 dst = src * scale[c] + bias[c], c 为输入图像中的通道
+struct ChannelAffine {
+  float scale[3] = {1.0f, 1.0f, 1.0f};
+  float bias[3] = {0.0f, 0.0f, 0.0f};
+};
+
+/**
+ * @brief 当前 CPU 支持的最高指令集, 只在第一次调用时检测
+ */
+SimdLevel GetSimdLevel();
+
+const char *SimdLevelName(SimdLevel level);
+
+/**
+ * @brief 把 CV_8UC1/CV_8UC3 图像从 HWC 排列转换为 CHW 排列的 blob,
+ * blob[c][h][w] = img[h][w][c] * scale, 不改变通道顺序
+ *
+ * 按运行时检测到的指令集选择 AVX-512/AVX2/SSE4.1 实现, FP16 输出由 F16C
+ * 直接转换(SSE4.1 下使用标量实现); 支持非连续的 ROI 图像
+ * parallel 为 true 且图像较大时按行切分到 cv::parallel_for_ 的线程中,
+ * 已经在多线程中调用时不要打开
+ */
+void HwcToChw(const cv::Mat &img, float *blob, float scale,
+              bool parallel = false);
+void HwcToChw(const cv::Mat &img, half_float::half *blob, float scale,
+              bool parallel = false);
+
+/**
+ * @brief 指定指令集的版本, 用于测试和基准测试, level 超过当前 CPU 支持的
+ * 指令集时抛出异常
+ */
+void HwcToChw(const cv::Mat &img, float *blob, float scale, SimdLevel level,
+              bool parallel = false);
+void HwcToChw(const cv::Mat &img, half_float::half *blob, float scale,
+              SimdLevel level, bool parallel = false);
+
+/**
+ * @brief 与 HwcToChw 相同, 但通道 c 按 affine 变换后写入 planes[c] 指向的平面,
+ * 平面中相邻两行相隔 plane_step 个元素; 用于直接写入更大的 blob 中的一块区域,
+ * 交换 planes 的顺序即可同时完成 BGR 到 RGB 的转换
+ */
+void HwcToPlanes(const cv::Mat &img, float *const *planes, size_t plane_step,
+                 const ChannelAffine &affine, bool parallel = false);
+void HwcToPlanes(const cv::Mat &img, half_float::half *const *planes,
+                 size_t plane_step, const ChannelAffine &affine,
+                 bool parallel = false);
+
+} // namespace imgutils
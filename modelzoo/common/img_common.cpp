@@ -32,11 +32,12 @@ int GetMaxFromSoftmax(const void *input, int len,
 }
 
 void BlobNormalizeFromImage(const cv::Mat &img, void *blob,
-                            inference::TensorDataType data_type) {
+                            inference::TensorDataType data_type,
+                            bool parallel) {
   if (data_type == inference::TensorDataType::kFP32) {
-    BlobNormalizeFromImage(img, (float *)blob);
+    HwcToChw(img, (float *)blob, 1.0f / 255.0f, parallel);
   } else if (data_type == inference::TensorDataType::kFP16) {
-    BlobNormalizeFromImage(img, (half_float::half *)blob);
+    HwcToChw(img, (half_float::half *)blob, 1.0f / 255.0f, parallel);
   } else {
     throw std::runtime_error("data type not supported");
   }
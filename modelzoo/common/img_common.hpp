@@ -4,32 +4,13 @@
 #include <opencv2/opencv.hpp>
 
 #include "inference/tensor/tensor.h"
+#include "modelzoo/common/blob_kernels.h"
 
 namespace imgutils {
 
+// 像素值归一化到 [0, 1] 并转换为 CHW 排列, T 为 float 或 half_float::half
 template <typename T> int BlobNormalizeFromImage(const cv::Mat &img, T *blob) {
-  int channels = img.channels();
-  int imgHeight = img.rows;
-  int imgWidth = img.cols;
-
-  if (img.type() == CV_8UC3) {
-    for (int c = 0; c < channels; c++) {
-      for (int h = 0; h < imgHeight; h++) {
-        for (int w = 0; w < imgWidth; w++) {
-          blob[c * imgWidth * imgHeight + h * imgWidth + w] =
-              img.at<cv::Vec3b>(h, w)[c] / 255.0f;
-        }
-      }
-    }
-  } else if (img.type() == CV_8UC1) {
-    for (int h = 0; h < imgHeight; h++) {
-      for (int w = 0; w < imgWidth; w++) {
-        blob[h * imgWidth + w] = img.at<uchar>(h, w) / 255.0f;
-      }
-    }
-  } else {
-    throw std::runtime_error("img type must be CV_8UC1 or CV_8UC3");
-  }
+  HwcToChw(img, blob, 1.0f / 255.0f);
   return 0;
 }
 
@@ -78,7 +59,8 @@ int GetMaxFromSoftmax(const void *input, int len,
                       inference::TensorDataType data_type);
 
 void BlobNormalizeFromImage(const cv::Mat &img, void *blob,
-                            inference::TensorDataType data_type);
+                            inference::TensorDataType data_type,
+                            bool parallel = false);
 
 std::tuple<cv::Mat, float> LetterBoxPadImage(const cv::Mat &image,
                                              const cv::Size &new_shape);
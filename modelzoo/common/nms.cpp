@@ -0,0 +1,371 @@
+#include "nms.h"
+
+#include <cpptoolkit/log/log.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <future>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define NMS_X86 1
+#include <immintrin.h>
+#define KERNEL_TARGET(isa) __attribute__((target(isa)))
+#else
+#define NMS_X86 0
+#endif
+
+namespace imgutils {
+
+namespace {
+
+// 按分数降序排列并加上类别偏移后的候选框
+struct SortedBoxes {
+  std::vector<float> x1;
+  std::vector<float> y1;
+  std::vector<float> x2;
+  std::vector<float> y2;
+  std::vector<float> area;
+  std::vector<float> scores;
+  std::vector<int> index; // 在输入中的下标
+
+  int size() const { return (int)index.size(); }
+};
+
+// 把 [begin, end) 中与第 i 个框的 IoU 超过阈值的框标记为已抑制(-1)
+using SuppressKernel = void (*)(const SortedBoxes &boxes, int i, int begin,
+                                int end, float iou_threshold,
+                                int32_t *suppressed);
+
+inline float IoU(const SortedBoxes &b, int i, int j) {
+  float w = std::min(b.x2[i], b.x2[j]) - std::max(b.x1[i], b.x1[j]);
+  float h = std::min(b.y2[i], b.y2[j]) - std::max(b.y1[i], b.y1[j]);
+  float inter = std::max(w, 0.0f) * std::max(h, 0.0f);
+  float uni = b.area[i] + b.area[j] - inter;
+  return uni > 0.0f ? inter / uni : 0.0f;
+}
+
+void SuppressScalar(const SortedBoxes &b, int i, int begin, int end,
+                    float iou_threshold, int32_t *suppressed) {
+  const float x1 = b.x1[i], y1 = b.y1[i], x2 = b.x2[i], y2 = b.y2[i];
+  const float area = b.area[i];
+  for (int j = begin; j < end; j++) {
+    float w = std::min(x2, b.x2[j]) - std::max(x1, b.x1[j]);
+    float h = std::min(y2, b.y2[j]) - std::max(y1, b.y1[j]);
+    float inter = std::max(w, 0.0f) * std::max(h, 0.0f);
+    // IoU > t 等价于 inter * (1 + t) > t * (area_i + area_j), 不需要除法
+    bool over = inter * (1.0f + iou_threshold) >
+                iou_threshold * (area + b.area[j]);
+    suppressed[j] |= -(int32_t)over;
+  }
+}
+
+#if NMS_X86
+
+KERNEL_TARGET("avx2")
+void SuppressAVX2(const SortedBoxes &b, int i, int begin, int end,
+                  float iou_threshold, int32_t *suppressed) {
+  const __m256 x1 = _mm256_set1_ps(b.x1[i]);
+  const __m256 y1 = _mm256_set1_ps(b.y1[i]);
+  const __m256 x2 = _mm256_set1_ps(b.x2[i]);
+  const __m256 y2 = _mm256_set1_ps(b.y2[i]);
+  const __m256 area = _mm256_set1_ps(b.area[i]);
+  const __m256 t = _mm256_set1_ps(iou_threshold);
+  const __m256 t1 = _mm256_set1_ps(1.0f + iou_threshold);
+  const __m256 zero = _mm256_setzero_ps();
+  int j = begin;
+  for (; j + 8 <= end; j += 8) {
+    __m256 w = _mm256_sub_ps(_mm256_min_ps(x2, _mm256_loadu_ps(&b.x2[j])),
+                             _mm256_max_ps(x1, _mm256_loadu_ps(&b.x1[j])));
+    __m256 h = _mm256_sub_ps(_mm256_min_ps(y2, _mm256_loadu_ps(&b.y2[j])),
+                             _mm256_max_ps(y1, _mm256_loadu_ps(&b.y1[j])));
+    __m256 inter =
+        _mm256_mul_ps(_mm256_max_ps(w, zero), _mm256_max_ps(h, zero));
+    __m256 over = _mm256_cmp_ps(
+        _mm256_mul_ps(inter, t1),
+        _mm256_mul_ps(t, _mm256_add_ps(area, _mm256_loadu_ps(&b.area[j]))),
+        _CMP_GT_OQ);
+    __m256i *dst = (__m256i *)(suppressed + j);
+    _mm256_storeu_si256(dst, _mm256_or_si256(_mm256_loadu_si256(dst),
+                                             _mm256_castps_si256(over)));
+  }
+  SuppressScalar(b, i, j, end, iou_threshold, suppressed);
+}
+
+#endif
+
+// SSE4.1 及以下使用标量实现
+SuppressKernel GetSuppressKernel(SimdLevel level) {
+#if NMS_X86
+  if (level >= SimdLevel::kAVX2) {
+    return SuppressAVX2;
+  }
+#endif
+  return SuppressScalar;
+}
+
+int Prepare(const NmsBoxes &boxes, const NmsParams &params,
+            SortedBoxes *sorted) {
+  size_t n = boxes.size();
+  if (boxes.x1.size() != n || boxes.y1.size() != n || boxes.x2.size() != n ||
+      boxes.y2.size() != n || boxes.class_ids.size() != n) {
+    LOG_ERROR("nms boxes size mismatch, scores:{}, x1:{}, class_ids:{}", n,
+              boxes.x1.size(), boxes.class_ids.size());
+    return -1;
+  }
+
+  auto &index = sorted->index;
+  index.clear();
+  index.reserve(n);
+  for (size_t i = 0; i < n; i++) {
+    if (boxes.scores[i] > params.score_threshold) {
+      index.push_back((int)i);
+    }
+  }
+  auto by_score = [&](int a, int b) {
+    return boxes.scores[a] > boxes.scores[b] ||
+           (boxes.scores[a] == boxes.scores[b] && a < b);
+  };
+  if (params.top_k > 0 && (int)index.size() > params.top_k) {
+    std::partial_sort(index.begin(), index.begin() + params.top_k,
+                      index.end(), by_score);
+    index.resize(params.top_k);
+  } else {
+    std::sort(index.begin(), index.end(), by_score);
+  }
+
+  // 类别感知时第 c 类的坐标平移 c * span, 不同类别的框互不相交
+  float min_coord = 0.0f;
+  float span = 0.0f;
+  if (params.class_aware && !index.empty()) {
+    min_coord = boxes.x1[index[0]];
+    float max_coord = min_coord;
+    for (int i : index) {
+      min_coord = std::min({min_coord, boxes.x1[i], boxes.y1[i]});
+      max_coord = std::max({max_coord, boxes.x2[i], boxes.y2[i]});
+    }
+    span = max_coord - min_coord + 1.0f;
+  }
+
+  int m = (int)index.size();
+  sorted->x1.resize(m);
+  sorted->y1.resize(m);
+  sorted->x2.resize(m);
+  sorted->y2.resize(m);
+  sorted->area.resize(m);
+  sorted->scores.resize(m);
+  for (int k = 0; k < m; k++) {
+    int i = index[k];
+    float offset =
+        params.class_aware ? boxes.class_ids[i] * span - min_coord : 0.0f;
+    sorted->x1[k] = boxes.x1[i] + offset;
+    sorted->y1[k] = boxes.y1[i] + offset;
+    sorted->x2[k] = boxes.x2[i] + offset;
+    sorted->y2[k] = boxes.y2[i] + offset;
+    sorted->area[k] = std::max(boxes.x2[i] - boxes.x1[i], 0.0f) *
+                      std::max(boxes.y2[i] - boxes.y1[i], 0.0f);
+    sorted->scores[k] = boxes.scores[i];
+  }
+  return 0;
+}
+
+// 把 [begin, end) 中未被抑制的框移到前面, 保持顺序, 返回新的 end
+int Compact(SortedBoxes *b, std::vector<int32_t> *suppressed, int begin,
+            int end) {
+  int dst = begin;
+  for (int src = begin; src < end; src++) {
+    if ((*suppressed)[src] != 0) {
+      continue;
+    }
+    if (dst != src) {
+      b->x1[dst] = b->x1[src];
+      b->y1[dst] = b->y1[src];
+      b->x2[dst] = b->x2[src];
+      b->y2[dst] = b->y2[src];
+      b->area[dst] = b->area[src];
+      b->scores[dst] = b->scores[src];
+      b->index[dst] = b->index[src];
+      (*suppressed)[dst] = 0;
+    }
+    dst++;
+  }
+  return dst;
+}
+
+void HardNms(SortedBoxes *sorted, const NmsParams &params,
+             SuppressKernel kernel, std::vector<int> *keep,
+             std::vector<float> *keep_scores) {
+  // 每保留这么多个框就去掉已抑制的框, 后面的 IoU 只对剩下的框计算
+  constexpr int kCompactInterval = 16;
+  int n = sorted->size();
+  std::vector<int32_t> suppressed(n, 0);
+  int kept_since_compact = 0;
+  for (int i = 0; i < n; i++) {
+    if (suppressed[i] != 0) {
+      continue;
+    }
+    keep->push_back(sorted->index[i]);
+    if (keep_scores != nullptr) {
+      keep_scores->push_back(sorted->scores[i]);
+    }
+    if (params.max_output > 0 && (int)keep->size() >= params.max_output) {
+      break;
+    }
+    kernel(*sorted, i, i + 1, n, params.iou_threshold, suppressed.data());
+    if (++kept_since_compact == kCompactInterval) {
+      n = Compact(sorted, &suppressed, i + 1, n);
+      kept_since_compact = 0;
+    }
+  }
+}
+
+void SoftNms(const SortedBoxes &sorted, const NmsParams &params,
+             std::vector<int> *keep, std::vector<float> *keep_scores) {
+  std::vector<float> scores = sorted.scores;
+  // 剩余的框按排序后的位置升序, 分数相同时取位置小的
+  std::vector<int> alive(sorted.size());
+  for (int k = 0; k < sorted.size(); k++) {
+    alive[k] = k;
+  }
+  while (!alive.empty()) {
+    auto best = alive.begin();
+    for (auto it = alive.begin(); it != alive.end(); ++it) {
+      if (scores[*it] > scores[*best]) {
+        best = it;
+      }
+    }
+    int i = *best;
+    alive.erase(best);
+    keep->push_back(sorted.index[i]);
+    if (keep_scores != nullptr) {
+      keep_scores->push_back(scores[i]);
+    }
+    if (params.max_output > 0 && (int)keep->size() >= params.max_output) {
+      break;
+    }
+
+    for (int j : alive) {
+      float iou = IoU(sorted, i, j);
+      if (params.method == NmsMethod::kSoftLinear) {
+        scores[j] *= iou > params.iou_threshold ? 1.0f - iou : 1.0f;
+      } else {
+        scores[j] *= std::exp(-iou * iou / params.soft_sigma);
+      }
+    }
+    alive.erase(std::remove_if(alive.begin(), alive.end(),
+                               [&](int j) {
+                                 return scores[j] <= params.score_threshold;
+                               }),
+                alive.end());
+  }
+}
+
+} // namespace
+
+void NmsBoxes::reserve(size_t n) {
+  x1.reserve(n);
+  y1.reserve(n);
+  x2.reserve(n);
+  y2.reserve(n);
+  scores.reserve(n);
+  class_ids.reserve(n);
+}
+
+void NmsBoxes::clear() {
+  x1.clear();
+  y1.clear();
+  x2.clear();
+  y2.clear();
+  scores.clear();
+  class_ids.clear();
+}
+
+void NmsBoxes::Add(float x1, float y1, float x2, float y2, float score,
+                   int class_id) {
+  this->x1.push_back(x1);
+  this->y1.push_back(y1);
+  this->x2.push_back(x2);
+  this->y2.push_back(y2);
+  scores.push_back(score);
+  class_ids.push_back(class_id);
+}
+
+void NmsBoxes::AddXYWH(float x, float y, float w, float h, float score,
+                       int class_id) {
+  Add(x, y, x + w, y + h, score, class_id);
+}
+
+void NmsBoxes::AddCenter(float cx, float cy, float w, float h, float score,
+                         int class_id) {
+  Add(cx - 0.5f * w, cy - 0.5f * h, cx + 0.5f * w, cy + 0.5f * h, score,
+      class_id);
+}
+
+int Nms(const NmsBoxes &boxes, const NmsParams &params, std::vector<int> *keep,
+        std::vector<float> *keep_scores) {
+  return Nms(boxes, params, GetSimdLevel(), keep, keep_scores);
+}
+
+int Nms(const NmsBoxes &boxes, const NmsParams &params, SimdLevel level,
+        std::vector<int> *keep, std::vector<float> *keep_scores) {
+  keep->clear();
+  if (keep_scores != nullptr) {
+    keep_scores->clear();
+  }
+  if (level > GetSimdLevel()) {
+    LOG_ERROR("simd level not supported: {}", SimdLevelName(level));
+    return -1;
+  }
+  if (params.method != NmsMethod::kHard && params.soft_sigma <= 0.0f) {
+    LOG_ERROR("invalid soft_sigma: {}", params.soft_sigma);
+    return -1;
+  }
+
+  SortedBoxes sorted;
+  int ret = Prepare(boxes, params, &sorted);
+  if (ret != 0) {
+    return ret;
+  }
+  if (params.method == NmsMethod::kHard) {
+    HardNms(&sorted, params, GetSuppressKernel(level), keep, keep_scores);
+  } else {
+    SoftNms(sorted, params, keep, keep_scores);
+  }
+  return 0;
+}
+
+int BatchedNms(inference::ThreadPool *pool, const std::vector<NmsBoxes> &batch,
+               const NmsParams &params, std::vector<std::vector<int>> *keeps) {
+  int batch_size = (int)batch.size();
+  keeps->resize(batch_size);
+  if (batch_size == 0) {
+    return 0;
+  }
+
+  std::vector<std::future<int>> futures;
+  if (pool != nullptr) {
+    futures.reserve(batch_size - 1);
+    for (int i = 1; i < batch_size; i++) {
+      futures.push_back(pool->Submit([&batch, &params, keeps, i]() {
+        return Nms(batch[i], params, &(*keeps)[i]);
+      }));
+    }
+  }
+
+  int ret = 0;
+  int serial_end = pool != nullptr ? 1 : batch_size;
+  for (int i = 0; i < serial_end; i++) {
+    if (Nms(batch[i], params, &(*keeps)[i]) != 0) {
+      ret = -1;
+    }
+  }
+  // 等待全部完成, 保证返回前不再访问 keeps
+  for (auto &future : futures) {
+    if (future.get() != 0) {
+      ret = -1;
+    }
+  }
+  return ret;
+}
+
+} // namespace imgutils
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <vector>
+
+#include "inference/utils/thread_pool.h"
+#include "modelzoo/common/blob_kernels.h"
+
+namespace imgutils {
+
+enum class NmsMethod {
+  kHard = 0,         // 与 cv::dnn::NMSBoxes 相同的贪心 NMS
+  kSoftLinear = 1,   // soft-NMS, IoU 超过阈值时分数乘以 1 - IoU
+  kSoftGaussian = 2, // soft-NMS, 分数乘以 exp(-IoU^2 / sigma)
+};
+
+struct NmsParams {
+  float score_threshold = 0.25f; // 分数需要严格大于该值
+  float iou_threshold = 0.5f;    // IoU 严格大于该值时抑制
+  // 为 true 时只在同类别的框之间抑制, 否则不区分类别
+  bool class_aware = true;
+  int top_k = 0;      // 只保留分数最高的 top_k 个候选参与 NMS, 0 为不限制
+  int max_output = 0; // 最多输出的框数, 0 为不限制
+  NmsMethod method = NmsMethod::kHard;
+  float soft_sigma = 0.5f; // kSoftGaussian 的 sigma
+};
+
+/**
+ * @brief NMS 的输入, 以 SoA 保存 [x1, y1, x2, y2] 格式的浮点框,
+ * 宽高为 x2 - x1 和 y2 - y1
+ */
+struct NmsBoxes {
+  std::vector<float> x1;
+  std::vector<float> y1;
+  std::vector<float> x2;
+  std::vector<float> y2;
+  std::vector<float> scores;
+  std::vector<int> class_ids;
+
+  size_t size() const { return scores.size(); }
+  void reserve(size_t n);
+  void clear();
+
+  void Add(float x1, float y1, float x2, float y2, float score,
+           int class_id = 0);
+  // 左上角和宽高
+  void AddXYWH(float x, float y, float w, float h, float score,
+               int class_id = 0);
+  // 中心点和宽高, 即 YOLO 输出的格式
+  void AddCenter(float cx, float cy, float w, float h, float score,
+                 int class_id = 0);
+};
+
+/**
+ * @brief 对 boxes 做 NMS, keep 中为保留的框在 boxes 中的下标, 按(衰减后的)
+ * 分数降序排列, 分数相同时下标小的在前; keep_scores 不为空时输出对应的分数
+ *
+ * 过滤分数并选出 top_k 后按分数排序, 类别感知时给每个类别的坐标加上不同的
+ * 偏移, 使不同类别的框不相交, 一次扫描完成所有类别. kHard 按分数顺序扫描,
+ * 每保留一个框用 SIMD 一次计算它与后面所有未抑制框的 IoU
+ */
+int Nms(const NmsBoxes &boxes, const NmsParams &params, std::vector<int> *keep,
+        std::vector<float> *keep_scores = nullptr);
+
+// 指定指令集的版本, 用于测试和基准测试
+int Nms(const NmsBoxes &boxes, const NmsParams &params, SimdLevel level,
+        std::vector<int> *keep, std::vector<float> *keep_scores = nullptr);
+
+/**
+ * @brief 多张图像的 NMS, batch[i] 的结果写入 keeps[i]; pool 不为空时每张
+ * 图像分发到线程池中, 调用线程处理第一张. 任意一张失败时返回 -1
+ */
+int BatchedNms(inference::ThreadPool *pool, const std::vector<NmsBoxes> &batch,
+               const NmsParams &params, std::vector<std::vector<int>> *keeps);
+
+} // namespace imgutils
@@ -0,0 +1,396 @@
+#include "preprocess.h"
+
+#include "blob_kernels.h"
+
+#include <cpptoolkit/log/log.h>
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <filesystem>
+#include <type_traits>
+
+namespace fs = std::filesystem;
+
+namespace imgutils {
+
+namespace {
+
+// 把 roi 以外的区域填充为 pad, roi 之内由转换内核写入
+template <typename T>
+void FillPadding(T *blob, int channels, TensorLayout layout,
+                 const cv::Size &dst_size, const cv::Rect &roi, const T *pad) {
+  auto fill = [&](T *dst, int pixels) {
+    if (layout == TensorLayout::kNCHW) {
+      std::fill_n(dst, pixels, pad[0]);
+      return;
+    }
+    for (int i = 0; i < pixels; i++) {
+      std::copy_n(pad, channels, dst + i * channels);
+    }
+  };
+
+  // NCHW 逐个平面填充, NHWC 把整个 tensor 看作一个平面
+  int plane_num = layout == TensorLayout::kNCHW ? channels : 1;
+  int pixel_size = layout == TensorLayout::kNCHW ? 1 : channels;
+  for (int c = 0; c < plane_num; c++) {
+    T *plane = blob + c * dst_size.area();
+    for (int y = 0; y < dst_size.height; y++) {
+      T *row = plane + (size_t)y * dst_size.width * pixel_size;
+      if (y < roi.y || y >= roi.y + roi.height) {
+        fill(row, dst_size.width);
+        continue;
+      }
+      fill(row, roi.x);
+      fill(row + (roi.x + roi.width) * pixel_size,
+           dst_size.width - roi.x - roi.width);
+    }
+    pad++;
+  }
+}
+
+const char *ResizeModeName(ResizeMode mode) {
+  switch (mode) {
+  case ResizeMode::kLetterBox:
+    return "letterbox";
+  case ResizeMode::kStretch:
+    return "stretch";
+  case ResizeMode::kNone:
+    return "none";
+  }
+  return "unknown";
+}
+
+template <typename T>
+int ReadArray(const cv::FileNode &node, const char *name, T *values,
+              int count) {
+  if (!node.isSeq() || (int)node.size() != count) {
+    LOG_ERROR("preprocess spec [{}] must be a list of {} values", name, count);
+    return -1;
+  }
+  for (int i = 0; i < count; i++) {
+    values[i] = (T)(double)node[i];
+  }
+  return 0;
+}
+
+} // namespace
+
+std::ostream &operator<<(std::ostream &s, const PreprocessSpec &spec) {
+  s << "PreprocessSpec(size:" << spec.size.width << "x" << spec.size.height
+    << ", resize_mode:" << ResizeModeName(spec.resize_mode)
+    << ", center:" << spec.center << ", pad_value:" << spec.pad_value
+    << ", mean:[" << spec.mean[0] << ", " << spec.mean[1] << ", "
+    << spec.mean[2] << "], std:[" << spec.stddev[0] << ", " << spec.stddev[1]
+    << ", " << spec.stddev[2] << "], channels:" << spec.channels
+    << ", channel_order:" << (spec.to_rgb ? "rgb" : "bgr") << ", layout:"
+    << (spec.layout == TensorLayout::kNCHW ? "nchw" : "nhwc")
+    << ", data_type:" << (spec.data_type == inference::kFP16 ? "fp16" : "fp32")
+    << ")";
+  return s;
+}
+
+int LoadPreprocessSpec(const std::string &path, PreprocessSpec *spec) {
+  cv::FileStorage fs;
+  try {
+    if (!fs.open(path, cv::FileStorage::READ)) {
+      LOG_ERROR("open preprocess spec failed: {}", path);
+      return -1;
+    }
+  } catch (const cv::Exception &e) {
+    LOG_ERROR("parse preprocess spec failed: {}, {}", path, e.what());
+    return -1;
+  }
+
+  PreprocessSpec result = *spec;
+  cv::FileNode node = fs["size"];
+  if (!node.empty()) {
+    int size[2];
+    if (ReadArray(node, "size", size, 2) != 0) {
+      return -1;
+    }
+    result.size = cv::Size(size[0], size[1]);
+  }
+  node = fs["resize_mode"];
+  if (!node.empty()) {
+    std::string mode = node.string();
+    if (mode == "letterbox") {
+      result.resize_mode = ResizeMode::kLetterBox;
+    } else if (mode == "stretch") {
+      result.resize_mode = ResizeMode::kStretch;
+    } else if (mode == "none") {
+      result.resize_mode = ResizeMode::kNone;
+    } else {
+      LOG_ERROR("unknown resize_mode: {}", mode);
+      return -1;
+    }
+  }
+  if (!fs["center"].empty()) {
+    result.center = (int)fs["center"] != 0;
+  }
+  if (!fs["pad_value"].empty()) {
+    result.pad_value = (float)fs["pad_value"];
+  }
+  if (!fs["mean"].empty() &&
+      ReadArray(fs["mean"], "mean", result.mean.data(), 3) != 0) {
+    return -1;
+  }
+  if (!fs["std"].empty() &&
+      ReadArray(fs["std"], "std", result.stddev.data(), 3) != 0) {
+    return -1;
+  }
+  if (!fs["channels"].empty()) {
+    result.channels = (int)fs["channels"];
+  }
+  node = fs["channel_order"];
+  if (!node.empty()) {
+    std::string order = node.string();
+    if (order != "rgb" && order != "bgr") {
+      LOG_ERROR("unknown channel_order: {}", order);
+      return -1;
+    }
+    result.to_rgb = order == "rgb";
+  }
+  node = fs["layout"];
+  if (!node.empty()) {
+    std::string layout = node.string();
+    if (layout != "nchw" && layout != "nhwc") {
+      LOG_ERROR("unknown layout: {}", layout);
+      return -1;
+    }
+    result.layout =
+        layout == "nchw" ? TensorLayout::kNCHW : TensorLayout::kNHWC;
+  }
+  node = fs["data_type"];
+  if (!node.empty()) {
+    std::string data_type = node.string();
+    if (data_type != "fp32" && data_type != "fp16") {
+      LOG_ERROR("unknown data_type: {}", data_type);
+      return -1;
+    }
+    result.data_type =
+        data_type == "fp32" ? inference::kFP32 : inference::kFP16;
+  }
+
+  *spec = result;
+  return 0;
+}
+
+std::string GetPreprocessSpecPath(const std::string &model_path) {
+  return fs::path(model_path).replace_extension(".preprocess.yaml").string();
+}
+
+int LoadPreprocessSpecForModel(const std::string &model_path,
+                               PreprocessSpec *spec) {
+  if (model_path.empty()) {
+    return 0;
+  }
+  std::string path = GetPreprocessSpecPath(model_path);
+  std::error_code ec;
+  if (!fs::exists(path, ec)) {
+    return 0;
+  }
+  int ret = LoadPreprocessSpec(path, spec);
+  if (ret == 0) {
+    LOG_INFO("load preprocess spec from {}", path);
+  }
+  return ret;
+}
+
+int Preprocessor::SetSpec(const PreprocessSpec &spec) {
+  if (spec.channels != 1 && spec.channels != 3) {
+    LOG_ERROR("preprocess channels must be 1 or 3, channels:{}", spec.channels);
+    return -1;
+  }
+  for (int c = 0; c < 3; c++) {
+    if (spec.stddev[c] == 0.0f) {
+      LOG_ERROR("preprocess std must not be 0");
+      return -1;
+    }
+  }
+
+  spec_ = spec;
+  lut_fp32_.resize(3 * 256);
+  lut_fp16_.resize(3 * 256);
+  for (int c = 0; c < 3; c++) {
+    scale_[c] = 1.0f / spec.stddev[c];
+    bias_[c] = -spec.mean[c] / spec.stddev[c];
+    for (int v = 0; v < 256; v++) {
+      lut_fp32_[c * 256 + v] = v * scale_[c] + bias_[c];
+      lut_fp16_[c * 256 + v] = half_float::half(lut_fp32_[c * 256 + v]);
+    }
+  }
+  return 0;
+}
+
+int Preprocessor::SetSpecForModel(const std::string &model_path) {
+  PreprocessSpec spec;
+  if (LoadPreprocessSpecForModel(model_path, &spec) != 0 ||
+      SetSpec(spec) != 0) {
+    LOG_ERROR("invalid preprocess spec: {}, use default",
+              GetPreprocessSpecPath(model_path));
+    SetSpec(PreprocessSpec());
+    return -1;
+  }
+  return 0;
+}
+
+template <typename T>
+void Preprocessor::Convert(const cv::Mat &src, const cv::Size &dst_size,
+                           const cv::Rect &roi, T *blob) {
+  const int channels = spec_.channels;
+  const int src_channels = src.channels();
+  // 输出通道 c 取自输入的哪个通道
+  int src_channel[3] = {0, 0, 0};
+  for (int c = 0; c < channels && src_channels == 3; c++) {
+    src_channel[c] = spec_.to_rgb ? 2 - c : c;
+  }
+
+  T pad[3];
+  for (int c = 0; c < channels; c++) {
+    pad[c] = T(spec_.pad_value * scale_[c] + bias_[c]);
+  }
+  FillPadding(blob, channels, spec_.layout, dst_size, roi, pad);
+
+  if (spec_.layout == TensorLayout::kNCHW) {
+    size_t plane = dst_size.area();
+    T *origin = blob + (size_t)roi.y * dst_size.width + roi.x;
+    if (src_channels == 3) {
+      // 交换平面的顺序完成 BGR 到 RGB 的转换
+      T *planes[3];
+      ChannelAffine affine;
+      for (int c = 0; c < 3; c++) {
+        planes[src_channel[c]] = origin + c * plane;
+        affine.scale[src_channel[c]] = scale_[c];
+        affine.bias[src_channel[c]] = bias_[c];
+      }
+      HwcToPlanes(src, planes, dst_size.width, affine);
+    } else {
+      // 灰度图依次写入每个输出通道
+      for (int c = 0; c < channels; c++) {
+        T *planes[1] = {origin + c * plane};
+        ChannelAffine affine;
+        affine.scale[0] = scale_[c];
+        affine.bias[0] = bias_[c];
+        HwcToPlanes(src, planes, dst_size.width, affine);
+      }
+    }
+    return;
+  }
+
+  const T *lut = nullptr;
+  if constexpr (std::is_same_v<T, float>) {
+    lut = lut_fp32_.data();
+  } else {
+    lut = lut_fp16_.data();
+  }
+  for (int y = 0; y < roi.height; y++) {
+    const uint8_t *s = src.ptr<uint8_t>(y);
+    T *d = blob + ((size_t)(roi.y + y) * dst_size.width + roi.x) * channels;
+    for (int x = 0; x < roi.width; x++) {
+      for (int c = 0; c < channels; c++) {
+        d[c] = lut[c * 256 + s[src_channel[c]]];
+      }
+      s += src_channels;
+      d += channels;
+    }
+  }
+}
+
+int Preprocessor::Run(const cv::Mat &img, const cv::Size &dst_size, void *blob,
+                      inference::TensorDataType data_type,
+                      PreprocessInfo *info) {
+  if (img.empty() || (img.type() != CV_8UC3 && img.type() != CV_8UC1)) {
+    LOG_ERROR("input img.type():{}, need CV_8UC1 or CV_8UC3", img.type());
+    return -1;
+  }
+  if (data_type != inference::kFP32 && data_type != inference::kFP16) {
+    LOG_ERROR("data type not supported: {}", (int)data_type);
+    return -1;
+  }
+
+  const cv::Mat *src = &img;
+  if (spec_.channels == 1 && img.channels() == 3) {
+    cv::cvtColor(img, gray_, cv::COLOR_BGR2GRAY);
+    src = &gray_;
+  }
+
+  PreprocessInfo result;
+  switch (spec_.resize_mode) {
+  case ResizeMode::kLetterBox:
+    // 长边缩放到输入大小, 与 LetterBoxPadImage 的缩放比例相同
+    if (img.cols * dst_size.height >= img.rows * dst_size.width) {
+      result.scale = img.cols / (float)dst_size.width;
+      result.resized = cv::Size(dst_size.width, int(img.rows / result.scale));
+    } else {
+      result.scale = img.rows / (float)dst_size.height;
+      result.resized = cv::Size(int(img.cols / result.scale), dst_size.height);
+    }
+    result.scale_y = result.scale;
+    if (spec_.center) {
+      result.pad = cv::Point((dst_size.width - result.resized.width) / 2,
+                             (dst_size.height - result.resized.height) / 2);
+    }
+    break;
+  case ResizeMode::kStretch:
+    result.scale = img.cols / (float)dst_size.width;
+    result.scale_y = img.rows / (float)dst_size.height;
+    result.resized = dst_size;
+    break;
+  case ResizeMode::kNone:
+    if (img.size() != dst_size) {
+      LOG_ERROR("img size {}x{} != input size {}x{}", img.cols, img.rows,
+                dst_size.width, dst_size.height);
+      return -1;
+    }
+    result.resized = dst_size;
+    break;
+  }
+
+  // 大小相同时直接从原图转换, 否则缩放到复用的 resized_ 中
+  if (result.resized != src->size()) {
+    cv::resize(*src, resized_, result.resized);
+    src = &resized_;
+  }
+
+  cv::Rect roi(result.pad, result.resized);
+  if (data_type == inference::kFP32) {
+    Convert(*src, dst_size, roi, (float *)blob);
+  } else {
+    Convert(*src, dst_size, roi, (half_float::half *)blob);
+  }
+
+  if (info != nullptr) {
+    *info = result;
+  }
+  return 0;
+}
+
+int Preprocessor::Run(const cv::Mat &img, void *blob, PreprocessInfo *info) {
+  return Run(img, spec_.size, blob, spec_.data_type, info);
+}
+
+int Preprocessor::Run(const cv::Mat &img,
+                      const inference::TensorDataPointer &tensor,
+                      PreprocessInfo *info) {
+  const auto &shape = tensor.shape;
+  bool nchw = spec_.layout == TensorLayout::kNCHW;
+  if (shape.size() != 4 || shape[nchw ? 1 : 3] != spec_.channels) {
+    LOG_ERROR("input tensor shape must be {} with {} channels, dims:{}",
+              nchw ? "[N, C, H, W]" : "[N, H, W, C]", spec_.channels,
+              shape.size());
+    return -1;
+  }
+  cv::Size dst_size((int)shape[nchw ? 3 : 2], (int)shape[nchw ? 2 : 1]);
+  size_t elem_size = tensor.data_type == inference::kFP16
+                         ? sizeof(half_float::half)
+                         : sizeof(float);
+  if ((size_t)tensor.mem_size <
+      spec_.channels * dst_size.area() * elem_size) {
+    LOG_ERROR("input tensor mem_size:{} too small for {}x{}", tensor.mem_size,
+              dst_size.width, dst_size.height);
+    return -1;
+  }
+  return Run(img, dst_size, tensor.p, tensor.data_type, info);
+}
+
+} // namespace imgutils
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <array>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <cpptoolkit/fp16/half.hpp>
+#include <opencv2/core.hpp>
+
+#include "inference/tensor/tensor.h"
+
+namespace imgutils {
+
+enum class ResizeMode {
+  kLetterBox = 0, // 长边缩放到输入大小, 保持宽高比, 其余位置填充 pad_value
+  kStretch = 1,   // 宽高分别缩放到输入大小
+  kNone = 2,      // 不缩放, 图像大小必须与输入大小相同
+};
+
+enum class TensorLayout {
+  kNCHW = 0,
+  kNHWC = 1,
+};
+
+/**
+ * @brief 模型的预处理描述, 输出 = (像素值 - mean[c]) / stddev[c]
+ *
+ * 默认值为 YOLO 系列的预处理: letterbox 到左上角, 填 0, 除以 255, RGB, NCHW
+ */
+struct PreprocessSpec {
+  cv::Size size = {640, 640}; // 模型输入大小, 按 tensor 运行时以 tensor 为准
+  ResizeMode resize_mode = ResizeMode::kLetterBox;
+  bool center = false;    // letterbox 时居中放置, 否则放在左上角
+  float pad_value = 0.0f; // letterbox 填充的像素值, 与输入像素同一值域
+  // 按输出的通道顺序, 与输入像素同一值域
+  std::array<float, 3> mean = {0.0f, 0.0f, 0.0f};
+  std::array<float, 3> stddev = {255.0f, 255.0f, 255.0f};
+  int channels = 3;   // 输出通道数, 1 时 BGR 输入先转换为灰度
+  bool to_rgb = true; // 输入为 BGR, 为 true 时输出 RGB
+  TensorLayout layout = TensorLayout::kNCHW;
+  // 按 tensor 运行时以 tensor 为准
+  inference::TensorDataType data_type = inference::kFP32;
+};
+
+std::ostream &operator<<(std::ostream &s, const PreprocessSpec &spec);
+
+/**
+ * @brief 从 yaml/json 文件(cv::FileStorage 格式)读取预处理描述,
+ * 文件中没有的字段保持 spec 中原有的值, 例如:
+ *
+ *   size: [640, 640]           # 宽, 高
+ *   resize_mode: letterbox     # letterbox | stretch | none
+ *   center: 0
+ *   pad_value: 114
+ *   mean: [123.675, 116.28, 103.53]
+ *   std: [58.395, 57.12, 57.375]
+ *   channels: 3
+ *   channel_order: rgb         # rgb | bgr
+ *   layout: nchw               # nchw | nhwc
+ *   data_type: fp32            # fp32 | fp16
+ */
+int LoadPreprocessSpec(const std::string &path, PreprocessSpec *spec);
+
+// 模型旁边的预处理描述文件, 例如 yolov8n.onnx 对应 yolov8n.preprocess.yaml
+std::string GetPreprocessSpecPath(const std::string &model_path);
+
+/**
+ * @brief 读取模型旁边的预处理描述文件, 文件不存在时返回 0 且不修改 spec
+ */
+int LoadPreprocessSpecForModel(const std::string &model_path,
+                               PreprocessSpec *spec);
+
+// 预处理的坐标变换, 模型输入中的坐标 = 原图坐标 / scale + pad
+struct PreprocessInfo {
+  float scale = 1.0f;   // 宽度方向 原图尺寸 / 缩放后尺寸
+  float scale_y = 1.0f; // 高度方向, 除 kStretch 外与 scale 相同
+  cv::Size resized;     // 缩放后的图像大小
+  cv::Point pad;        // 缩放后图像在模型输入中的左上角
+};
+
+/**
+ * @brief 按 PreprocessSpec 把 BGR 或灰度图像直接写入模型的输入 tensor
+ *
+ * 每个输入像素只读写一次: 缩放到复用的内部缓存后, 颜色转换和归一化在同一次
+ * 遍历中完成(NCHW 使用 SIMD 内核, NHWC 使用查表), 只对填充区域单独赋值;
+ * 不拷贝原图, 预热后不再分配内存. 每个模型实例持有一个, 不能在多个线程中
+ * 同时使用
+ */
+class Preprocessor {
+public:
+  Preprocessor() { SetSpec(PreprocessSpec()); }
+  explicit Preprocessor(const PreprocessSpec &spec) { SetSpec(spec); }
+
+  int SetSpec(const PreprocessSpec &spec);
+  const PreprocessSpec &GetSpec() const { return spec_; }
+
+  /**
+   * @brief 使用模型旁边的预处理描述文件, 文件不存在时使用默认的
+   * PreprocessSpec; 文件无效时同样使用默认值并返回 -1
+   */
+  int SetSpecForModel(const std::string &model_path);
+
+  // 输入大小和数据类型取 spec, blob 需要容纳 channels * size.area() 个元素
+  int Run(const cv::Mat &img, void *blob, PreprocessInfo *info);
+
+  // 输入大小和数据类型取 tensor, 形状为 [N, C, H, W] 或 [N, H, W, C]
+  int Run(const cv::Mat &img, const inference::TensorDataPointer &tensor,
+          PreprocessInfo *info);
+
+private:
+  int Run(const cv::Mat &img, const cv::Size &dst_size, void *blob,
+          inference::TensorDataType data_type, PreprocessInfo *info);
+
+  template <typename T>
+  void Convert(const cv::Mat &src, const cv::Size &dst_size,
+               const cv::Rect &roi, T *blob);
+
+  PreprocessSpec spec_;
+  // 输出通道 c 的变换, 由 mean/stddev 计算
+  std::array<float, 3> scale_;
+  std::array<float, 3> bias_;
+  // NHWC 使用的查找表, lut[c * 256 + v] 为像素值 v 在输出通道 c 的结果
+  std::vector<float> lut_fp32_;
+  std::vector<half_float::half> lut_fp16_;
+  cv::Mat gray_;
+  cv::Mat resized_;
+};
+
+} // namespace imgutils
@@ -0,0 +1,317 @@
+#include "rotated_nms.h"
+
+#include <cpptoolkit/log/log.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ROTATED_NMS_X86 1
+#include <immintrin.h>
+#define KERNEL_TARGET(isa) __attribute__((target(isa)))
+#else
+#define ROTATED_NMS_X86 0
+#endif
+
+namespace imgutils {
+
+namespace {
+
+constexpr float kEps = 1e-7f;
+
+// 框的协方差 [[a, c], [c, b]] 和 sqrt(det)
+struct Covariance {
+  float a = 0.0f;
+  float b = 0.0f;
+  float c = 0.0f;
+  float s = 0.0f;
+};
+
+Covariance CovarianceOf(float w, float h, float angle) {
+  Covariance cov;
+  if (w < 0 || h < 0) {
+    return cov;
+  }
+  float a = w * w / 12;
+  float b = h * h / 12;
+  float cos_r = cosf(angle);
+  float sin_r = sinf(angle);
+  cov.a = a * cos_r * cos_r + b * sin_r * sin_r;
+  cov.b = a * sin_r * sin_r + b * cos_r * cos_r;
+  cov.c = (a - b) * sin_r * cos_r;
+  cov.s = std::sqrt(std::max(cov.a * cov.b - cov.c * cov.c, 0.0f));
+  return cov;
+}
+
+// dx, dy 为两个框中心的差
+float ProbIoU(float dx, float dy, const Covariance &cov1,
+              const Covariance &cov2) {
+  float a = cov1.a + cov2.a;
+  float b = cov1.b + cov2.b;
+  float c = cov1.c + cov2.c;
+  float det = a * b - c * c;
+  float t1 = (a * dy * dy + b * dx * dx) / (det + kEps);
+  float t2 = (c * -dx * dy) / (det + kEps);
+  float t3 = std::log(det / (4 * cov1.s * cov2.s + kEps) + kEps);
+  float bd = 0.25f * t1 + 0.5f * t2 + 0.5f * t3;
+  float hd = std::sqrt(1.0f - std::exp(-std::min(std::max(bd, kEps), 100.0f)) +
+                       kEps);
+  return 1.0f - hd;
+}
+
+// 按类别和分数排序后的候选框
+struct SortedBoxes {
+  std::vector<float> cx;
+  std::vector<float> cy;
+  // ProbIoU 超过阈值时中心距离的平方小于 reach[i] + reach[j]
+  std::vector<float> reach;
+  std::vector<Covariance> cov;
+  std::vector<int> index; // 在输入中的下标
+
+  int size() const { return (int)index.size(); }
+};
+
+// 把 [begin, end) 中未被抑制且中心足够近的 j 依次写入 near, 返回个数
+using NearKernel = int (*)(const SortedBoxes &boxes, int i, int begin,
+                           int end, const int32_t *suppressed, int *near);
+
+inline int NearScalar(const SortedBoxes &b, int i, int begin, int end,
+                      const int32_t *suppressed, int *near, int count) {
+  for (int j = begin; j < end; j++) {
+    float dx = b.cx[i] - b.cx[j];
+    float dy = b.cy[i] - b.cy[j];
+    if (suppressed[j] == 0 && dx * dx + dy * dy < b.reach[i] + b.reach[j]) {
+      near[count++] = j;
+    }
+  }
+  return count;
+}
+
+int NearScalar(const SortedBoxes &b, int i, int begin, int end,
+               const int32_t *suppressed, int *near) {
+  return NearScalar(b, i, begin, end, suppressed, near, 0);
+}
+
+#if ROTATED_NMS_X86
+
+KERNEL_TARGET("avx2")
+int NearAVX2(const SortedBoxes &b, int i, int begin, int end,
+             const int32_t *suppressed, int *near) {
+  const __m256 cx = _mm256_set1_ps(b.cx[i]);
+  const __m256 cy = _mm256_set1_ps(b.cy[i]);
+  const __m256 reach = _mm256_set1_ps(b.reach[i]);
+  int count = 0;
+  int j = begin;
+  for (; j + 8 <= end; j += 8) {
+    __m256 dx = _mm256_sub_ps(cx, _mm256_loadu_ps(&b.cx[j]));
+    __m256 dy = _mm256_sub_ps(cy, _mm256_loadu_ps(&b.cy[j]));
+    __m256 d2 = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+    __m256 limit = _mm256_add_ps(reach, _mm256_loadu_ps(&b.reach[j]));
+    __m256 close = _mm256_cmp_ps(d2, limit, _CMP_LT_OQ);
+    __m256i alive = _mm256_cmpeq_epi32(
+        _mm256_loadu_si256((const __m256i *)(suppressed + j)),
+        _mm256_setzero_si256());
+    unsigned mask = _mm256_movemask_ps(
+        _mm256_and_ps(close, _mm256_castsi256_ps(alive)));
+    while (mask != 0) {
+      near[count++] = j + __builtin_ctz(mask);
+      mask &= mask - 1;
+    }
+  }
+  return NearScalar(b, i, j, end, suppressed, near, count);
+}
+
+#endif
+
+// SSE4.1 及以下使用标量实现
+NearKernel GetNearKernel(SimdLevel level) {
+#if ROTATED_NMS_X86
+  if (level >= SimdLevel::kAVX2) {
+    return NearAVX2;
+  }
+#endif
+  return NearScalar;
+}
+
+/**
+ * ProbIoU = 1 - sqrt(1 - exp(-bd) + eps) > T 等价于 bd < B,
+ * B = -ln(1 + eps - (1 - T)^2). bd 中 t3 >= 0, 前两项是以 Σ1 + Σ2 为协方差的
+ * 马氏距离, 不小于 |d|^2 / (4 * trace(Σ1 + Σ2)), 所以 |d|^2 >= 4B * (trace1 +
+ * trace2) 时一定不会抑制, 与角度无关. 留出余量覆盖 eps 和舍入误差;
+ * 退化的框和 B 超过 bd 的截断值 100 时不使用该下界
+ */
+float ReachOf(const Covariance &cov, float bound) {
+  constexpr float kMinSqrtDet = 1e-2f;
+  if (!(bound < 100.0f) || cov.s < kMinSqrtDet) {
+    return std::numeric_limits<float>::infinity();
+  }
+  return 4.0f * (bound * 1.05f + 1e-2f) * (cov.a + cov.b);
+}
+
+int Prepare(const RotatedNmsBoxes &boxes, const NmsParams &params,
+            SortedBoxes *sorted) {
+  size_t n = boxes.size();
+  if (boxes.cx.size() != n || boxes.cy.size() != n || boxes.w.size() != n ||
+      boxes.h.size() != n || boxes.angle.size() != n ||
+      boxes.class_ids.size() != n) {
+    LOG_ERROR("rotated nms boxes size mismatch, scores:{}, cx:{}, cy:{}, "
+              "w:{}, h:{}, angle:{}, class_ids:{}",
+              n, boxes.cx.size(), boxes.cy.size(), boxes.w.size(),
+              boxes.h.size(), boxes.angle.size(), boxes.class_ids.size());
+    return -1;
+  }
+
+  auto &index = sorted->index;
+  index.clear();
+  for (size_t i = 0; i < n; i++) {
+    if (boxes.scores[i] > params.score_threshold) {
+      index.push_back((int)i);
+    }
+  }
+  auto by_score = [&](int a, int b) {
+    return boxes.scores[a] > boxes.scores[b] ||
+           (boxes.scores[a] == boxes.scores[b] && a < b);
+  };
+  if (params.top_k > 0 && (int)index.size() > params.top_k) {
+    std::partial_sort(index.begin(), index.begin() + params.top_k,
+                      index.end(), by_score);
+    index.resize(params.top_k);
+  } else {
+    std::sort(index.begin(), index.end(), by_score);
+  }
+  // 同类别的框连续存放, 桶内仍按分数降序
+  if (params.class_aware) {
+    std::stable_sort(index.begin(), index.end(), [&](int a, int b) {
+      return boxes.class_ids[a] < boxes.class_ids[b];
+    });
+  }
+
+  float one_minus_t = 1.0f - params.iou_threshold;
+  float bound = -std::log(1.0f + kEps - one_minus_t * one_minus_t);
+  int m = (int)index.size();
+  sorted->cx.resize(m);
+  sorted->cy.resize(m);
+  sorted->reach.resize(m);
+  sorted->cov.resize(m);
+  for (int k = 0; k < m; k++) {
+    int i = index[k];
+    sorted->cx[k] = boxes.cx[i];
+    sorted->cy[k] = boxes.cy[i];
+    sorted->cov[k] = CovarianceOf(boxes.w[i], boxes.h[i], boxes.angle[i]);
+    sorted->reach[k] = ReachOf(sorted->cov[k], bound);
+  }
+  return 0;
+}
+
+} // namespace
+
+void RotatedNmsBoxes::reserve(size_t n) {
+  cx.reserve(n);
+  cy.reserve(n);
+  w.reserve(n);
+  h.reserve(n);
+  angle.reserve(n);
+  scores.reserve(n);
+  class_ids.reserve(n);
+}
+
+void RotatedNmsBoxes::clear() {
+  cx.clear();
+  cy.clear();
+  w.clear();
+  h.clear();
+  angle.clear();
+  scores.clear();
+  class_ids.clear();
+}
+
+void RotatedNmsBoxes::Add(float cx, float cy, float w, float h, float angle,
+                          float score, int class_id) {
+  this->cx.push_back(cx);
+  this->cy.push_back(cy);
+  this->w.push_back(w);
+  this->h.push_back(h);
+  this->angle.push_back(angle);
+  scores.push_back(score);
+  class_ids.push_back(class_id);
+}
+
+float ProbIoU(float cx1, float cy1, float w1, float h1, float angle1,
+              float cx2, float cy2, float w2, float h2, float angle2) {
+  return ProbIoU(cx1 - cx2, cy1 - cy2, CovarianceOf(w1, h1, angle1),
+                 CovarianceOf(w2, h2, angle2));
+}
+
+int RotatedNms(const RotatedNmsBoxes &boxes, const NmsParams &params,
+               std::vector<int> *keep) {
+  return RotatedNms(boxes, params, GetSimdLevel(), keep);
+}
+
+int RotatedNms(const RotatedNmsBoxes &boxes, const NmsParams &params,
+               SimdLevel level, std::vector<int> *keep) {
+  keep->clear();
+  if (level > GetSimdLevel()) {
+    LOG_ERROR("simd level not supported: {}", SimdLevelName(level));
+    return -1;
+  }
+  if (params.method != NmsMethod::kHard) {
+    LOG_ERROR("rotated nms only supports hard nms");
+    return -1;
+  }
+
+  SortedBoxes sorted;
+  int ret = Prepare(boxes, params, &sorted);
+  if (ret != 0) {
+    return ret;
+  }
+
+  NearKernel near_kernel = GetNearKernel(level);
+  int n = sorted.size();
+  std::vector<int32_t> suppressed(n, 0);
+  std::vector<int> near(n);
+  for (int begin = 0; begin < n;) {
+    // 当前类别的桶 [begin, end)
+    int end = begin + 1;
+    while (params.class_aware && end < n &&
+           boxes.class_ids[sorted.index[end]] ==
+               boxes.class_ids[sorted.index[begin]]) {
+      end++;
+    }
+    if (!params.class_aware) {
+      end = n;
+    }
+
+    for (int i = begin; i < end; i++) {
+      if (suppressed[i] != 0) {
+        continue;
+      }
+      keep->push_back(sorted.index[i]);
+      int count =
+          near_kernel(sorted, i, i + 1, end, suppressed.data(), near.data());
+      for (int k = 0; k < count; k++) {
+        int j = near[k];
+        float iou = ProbIoU(sorted.cx[i] - sorted.cx[j],
+                            sorted.cy[i] - sorted.cy[j], sorted.cov[i],
+                            sorted.cov[j]);
+        if (iou > params.iou_threshold) {
+          suppressed[j] = -1;
+        }
+      }
+    }
+    begin = end;
+  }
+
+  // 各个桶的结果合并后按分数降序排列
+  std::sort(keep->begin(), keep->end(), [&](int a, int b) {
+    return boxes.scores[a] > boxes.scores[b] ||
+           (boxes.scores[a] == boxes.scores[b] && a < b);
+  });
+  if (params.max_output > 0 && (int)keep->size() > params.max_output) {
+    keep->resize(params.max_output);
+  }
+  return 0;
+}
+
+} // namespace imgutils
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <vector>
+
+#include "modelzoo/common/blob_kernels.h"
+#include "modelzoo/common/nms.h"
+
+namespace imgutils {
+
+/**
+ * @brief 旋转框 NMS 的输入, 以 SoA 保存 [center_x, center_y, w, h, angle],
+ * angle 为弧度
+ */
+struct RotatedNmsBoxes {
+  std::vector<float> cx;
+  std::vector<float> cy;
+  std::vector<float> w;
+  std::vector<float> h;
+  std::vector<float> angle;
+  std::vector<float> scores;
+  std::vector<int> class_ids;
+
+  size_t size() const { return scores.size(); }
+  void reserve(size_t n);
+  void clear();
+
+  void Add(float cx, float cy, float w, float h, float angle, float score,
+           int class_id = 0);
+};
+
+/**
+ * @brief 两个旋转框的 ProbIoU, 把框看作二维高斯分布, 由 Bhattacharyya 距离
+ * 计算, 取值 [0, 1]
+ */
+float ProbIoU(float cx1, float cy1, float w1, float h1, float angle1,
+              float cx2, float cy2, float w2, float h2, float angle2);
+
+/**
+ * @brief 按 ProbIoU 的旋转框 NMS, 参数和输出与 Nms 相同, 只支持 kHard
+ *
+ * 每个框的协方差只计算一次, 按类别分桶后在桶内按分数扫描. 由 ProbIoU 阈值
+ * 推出的中心距离下界先用 SIMD 排除大部分框对, 只有剩下的框对才计算完整的
+ * ProbIoU, 不需要三角函数
+ */
+int RotatedNms(const RotatedNmsBoxes &boxes, const NmsParams &params,
+               std::vector<int> *keep);
+
+// 指定指令集的版本, 用于测试和基准测试
+int RotatedNms(const RotatedNmsBoxes &boxes, const NmsParams &params,
+               SimdLevel level, std::vector<int> *keep);
+
+} // namespace imgutils
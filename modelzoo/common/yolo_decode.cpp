@@ -0,0 +1,338 @@
+#include "yolo_decode.h"
+#include "yolo_head.hpp"
+
+#include <cpptoolkit/log/log.h>
+#include <cpptoolkit/strings/to_string.h>
+
+#include <cstdint>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define YOLO_DECODE_X86 1
+#include <immintrin.h>
+#define KERNEL_TARGET(isa) __attribute__((target(isa)))
+#else
+#define YOLO_DECODE_X86 0
+#endif
+
+namespace imgutils {
+
+namespace {
+
+// 处理 [begin, end) 范围, 也用于 SIMD 实现的尾部
+inline void LoadFp16Scalar(const half_float::half *src, int begin, int end,
+                           float *dst) {
+  for (int i = begin; i < end; i++) {
+    dst[i] = (float)src[i];
+  }
+}
+
+inline void MaxArgmaxScalar(const float *row, int begin, int end,
+                            int class_id, float *max, int *argmax) {
+  for (int i = begin; i < end; i++) {
+    bool greater = row[i] > max[i];
+    max[i] = greater ? row[i] : max[i];
+    argmax[i] = greater ? class_id : argmax[i];
+  }
+}
+
+inline void MaxArgmax4Scalar(const float *const *rows, int begin, int end,
+                             int class_id, float *max, int *argmax) {
+  for (int k = 0; k < 4; k++) {
+    MaxArgmaxScalar(rows[k], begin, end, class_id + k, max, argmax);
+  }
+}
+
+inline int SelectScalar(const float *max, int begin, int end, float threshold,
+                        int *index, int count) {
+  for (int i = begin; i < end; i++) {
+    if (max[i] > threshold) {
+      index[count++] = i;
+    }
+  }
+  return count;
+}
+
+void LoadFp16Scalar(const half_float::half *src, int n, float *dst) {
+  LoadFp16Scalar(src, 0, n, dst);
+}
+
+void MaxArgmaxScalar(const float *row, int n, int class_id, float *max,
+                     int *argmax) {
+  MaxArgmaxScalar(row, 0, n, class_id, max, argmax);
+}
+
+void MaxArgmax4Scalar(const float *const *rows, int n, int class_id,
+                      float *max, int *argmax) {
+  MaxArgmax4Scalar(rows, 0, n, class_id, max, argmax);
+}
+
+int SelectScalar(const float *max, int n, float threshold, int *index) {
+  return SelectScalar(max, 0, n, threshold, index, 0);
+}
+
+#if YOLO_DECODE_X86
+
+KERNEL_TARGET("sse4.1")
+void MaxArgmaxSSE41(const float *row, int n, int class_id, float *max,
+                    int *argmax) {
+  const __m128i id = _mm_set1_epi32(class_id);
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m128 v = _mm_loadu_ps(row + i);
+    __m128 m = _mm_loadu_ps(max + i);
+    __m128 greater = _mm_cmpgt_ps(v, m);
+    __m128i a = _mm_loadu_si128((const __m128i *)(argmax + i));
+    _mm_storeu_ps(max + i, _mm_blendv_ps(m, v, greater));
+    _mm_storeu_si128((__m128i *)(argmax + i),
+                     _mm_blendv_epi8(a, id, _mm_castps_si128(greater)));
+  }
+  MaxArgmaxScalar(row, i, n, class_id, max, argmax);
+}
+
+KERNEL_TARGET("sse4.1")
+void MaxArgmax4SSE41(const float *const *rows, int n, int class_id,
+                     float *max, int *argmax) {
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m128 m = _mm_loadu_ps(max + i);
+    __m128i a = _mm_loadu_si128((const __m128i *)(argmax + i));
+    for (int k = 0; k < 4; k++) {
+      __m128 v = _mm_loadu_ps(rows[k] + i);
+      __m128 greater = _mm_cmpgt_ps(v, m);
+      m = _mm_blendv_ps(m, v, greater);
+      a = _mm_blendv_epi8(a, _mm_set1_epi32(class_id + k),
+                          _mm_castps_si128(greater));
+    }
+    _mm_storeu_ps(max + i, m);
+    _mm_storeu_si128((__m128i *)(argmax + i), a);
+  }
+  MaxArgmax4Scalar(rows, i, n, class_id, max, argmax);
+}
+
+KERNEL_TARGET("sse4.1")
+int SelectSSE41(const float *max, int n, float threshold, int *index) {
+  const __m128 t = _mm_set1_ps(threshold);
+  int count = 0;
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    unsigned mask = _mm_movemask_ps(_mm_cmpgt_ps(_mm_loadu_ps(max + i), t));
+    while (mask != 0) {
+      index[count++] = i + __builtin_ctz(mask);
+      mask &= mask - 1;
+    }
+  }
+  return SelectScalar(max, i, n, threshold, index, count);
+}
+
+KERNEL_TARGET("avx2,f16c")
+void LoadFp16AVX2(const half_float::half *src, int n, float *dst) {
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m128i h = _mm_loadu_si128((const __m128i *)(src + i));
+    _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(h));
+  }
+  LoadFp16Scalar(src, i, n, dst);
+}
+
+KERNEL_TARGET("avx2")
+void MaxArgmaxAVX2(const float *row, int n, int class_id, float *max,
+                   int *argmax) {
+  const __m256i id = _mm256_set1_epi32(class_id);
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256 v = _mm256_loadu_ps(row + i);
+    __m256 m = _mm256_loadu_ps(max + i);
+    __m256 greater = _mm256_cmp_ps(v, m, _CMP_GT_OQ);
+    __m256i a = _mm256_loadu_si256((const __m256i *)(argmax + i));
+    _mm256_storeu_ps(max + i, _mm256_blendv_ps(m, v, greater));
+    _mm256_storeu_si256(
+        (__m256i *)(argmax + i),
+        _mm256_blendv_epi8(a, id, _mm256_castps_si256(greater)));
+  }
+  MaxArgmaxScalar(row, i, n, class_id, max, argmax);
+}
+
+KERNEL_TARGET("avx2")
+void MaxArgmax4AVX2(const float *const *rows, int n, int class_id,
+                    float *max, int *argmax) {
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256 m = _mm256_loadu_ps(max + i);
+    __m256i a = _mm256_loadu_si256((const __m256i *)(argmax + i));
+    for (int k = 0; k < 4; k++) {
+      __m256 v = _mm256_loadu_ps(rows[k] + i);
+      __m256 greater = _mm256_cmp_ps(v, m, _CMP_GT_OQ);
+      m = _mm256_blendv_ps(m, v, greater);
+      a = _mm256_blendv_epi8(a, _mm256_set1_epi32(class_id + k),
+                             _mm256_castps_si256(greater));
+    }
+    _mm256_storeu_ps(max + i, m);
+    _mm256_storeu_si256((__m256i *)(argmax + i), a);
+  }
+  MaxArgmax4Scalar(rows, i, n, class_id, max, argmax);
+}
+
+KERNEL_TARGET("avx2")
+int SelectAVX2(const float *max, int n, float threshold, int *index) {
+  const __m256 t = _mm256_set1_ps(threshold);
+  int count = 0;
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    unsigned mask = _mm256_movemask_ps(
+        _mm256_cmp_ps(_mm256_loadu_ps(max + i), t, _CMP_GT_OQ));
+    // 通过阈值的 anchor 很少, 大多数块 mask 为 0
+    while (mask != 0) {
+      index[count++] = i + __builtin_ctz(mask);
+      mask &= mask - 1;
+    }
+  }
+  return SelectScalar(max, i, n, threshold, index, count);
+}
+
+#endif
+
+template <typename T>
+void DecodeWithHead(const T *data, int anchor_num, int class_num,
+                    int extra_num, float threshold,
+                    const YoloRowKernels &kernels,
+                    YoloCandidates *candidates) {
+  // 模型库中的输出头使用编译期特化的版本, 其余的类别数走通用版本
+  if (YoloV8DetectHead::Match(class_num, extra_num)) {
+    DecodeYoloHead<YoloV8DetectHead>(data, anchor_num, class_num, extra_num,
+                                     threshold, kernels, candidates);
+  } else if (Yolo11PoseHead::Match(class_num, extra_num)) {
+    DecodeYoloHead<Yolo11PoseHead>(data, anchor_num, class_num, extra_num,
+                                   threshold, kernels, candidates);
+  } else if (Yolo11SegHead::Match(class_num, extra_num)) {
+    DecodeYoloHead<Yolo11SegHead>(data, anchor_num, class_num, extra_num,
+                                  threshold, kernels, candidates);
+  } else if (Yolo11ObbHead::Match(class_num, extra_num)) {
+    DecodeYoloHead<Yolo11ObbHead>(data, anchor_num, class_num, extra_num,
+                                  threshold, kernels, candidates);
+  } else {
+    DecodeYoloHead<DynamicYoloHead>(data, anchor_num, class_num, extra_num,
+                                    threshold, kernels, candidates);
+  }
+}
+
+} // namespace
+
+// AVX-512 使用 AVX2 实现, 类别行很短时更宽的向量收益不大;
+// SSE4.1 没有 F16C, FP16 使用标量转换
+const YoloRowKernels &GetYoloRowKernels(SimdLevel level) {
+  static const YoloRowKernels scalar = {LoadFp16Scalar, MaxArgmaxScalar,
+                                        MaxArgmax4Scalar, SelectScalar};
+#if YOLO_DECODE_X86
+  static const YoloRowKernels sse41 = {LoadFp16Scalar, MaxArgmaxSSE41,
+                                       MaxArgmax4SSE41, SelectSSE41};
+  static const YoloRowKernels avx2 = {LoadFp16AVX2, MaxArgmaxAVX2,
+                                      MaxArgmax4AVX2, SelectAVX2};
+  if (level >= SimdLevel::kAVX2) {
+    return avx2;
+  }
+  if (level == SimdLevel::kSSE41) {
+    return sse41;
+  }
+#endif
+  return scalar;
+}
+
+void YoloCandidates::clear() {
+  boxes.clear();
+  scores.clear();
+  class_ids.clear();
+  anchors.clear();
+  extras.clear();
+  extra_num = 0;
+}
+
+void ToNmsBoxes(const YoloCandidates &candidates, NmsBoxes *boxes) {
+  boxes->clear();
+  boxes->reserve(candidates.size());
+  for (size_t i = 0; i < candidates.size(); i++) {
+    const auto &box = candidates.boxes[i];
+    boxes->AddCenter(box[0], box[1], box[2], box[3], candidates.scores[i],
+                     candidates.class_ids[i]);
+  }
+}
+
+int DecodeYoloHead(const inference::TensorDataPointer &tensor, int class_num,
+                   float threshold, YoloCandidates *candidates) {
+  return DecodeYoloHead(tensor, class_num, threshold, GetSimdLevel(),
+                        candidates);
+}
+
+int DecodeYoloHead(const inference::TensorDataPointer &tensor, int class_num,
+                   float threshold, SimdLevel level,
+                   YoloCandidates *candidates) {
+  candidates->clear();
+  if (level > GetSimdLevel()) {
+    LOG_ERROR("simd level not supported: {}", SimdLevelName(level));
+    return -1;
+  }
+
+  const auto &shape = tensor.shape;
+  if (tensor.p == nullptr || shape.size() != 3 || class_num <= 0 ||
+      shape[1] < 4 + class_num) {
+    LOG_ERROR("invalid yolo output, shape:{}, class_num:{}",
+              cpptoolkit::ToString(shape), class_num);
+    return -1;
+  }
+
+  int anchor_num = (int)shape[2];
+  int extra_num = (int)shape[1] - 4 - class_num;
+  const auto &kernels = GetYoloRowKernels(level);
+  if (tensor.data_type == inference::kFP32) {
+    DecodeWithHead((const float *)tensor.p, anchor_num, class_num, extra_num,
+                   threshold, kernels, candidates);
+    return 0;
+  }
+  if (tensor.data_type == inference::kFP16) {
+    DecodeWithHead((const half_float::half *)tensor.p, anchor_num, class_num,
+                   extra_num, threshold, kernels, candidates);
+    return 0;
+  }
+  LOG_ERROR("unsupported data type: {}", (int)tensor.data_type);
+  return -1;
+}
+
+int DecodeYoloDetect(const inference::TensorDataPointer &tensor, int class_num,
+                     const Threshold &threshold, float img_scale,
+                     std::vector<DetectBox> *result) {
+  YoloCandidates candidates;
+  int ret =
+      DecodeYoloHead(tensor, class_num, threshold.det_threshold, &candidates);
+  if (ret != 0) {
+    return ret;
+  }
+
+  // 按类别 NMS, 不同类别的框互不抑制
+  NmsBoxes nms_boxes;
+  ToNmsBoxes(candidates, &nms_boxes);
+  NmsParams nms_params;
+  nms_params.score_threshold = threshold.det_threshold;
+  nms_params.iou_threshold = threshold.iou_threshold;
+  std::vector<int> nms_result;
+  ret = Nms(nms_boxes, nms_params, &nms_result);
+  if (ret != 0) {
+    return ret;
+  }
+  for (int idx : nms_result) {
+    const auto &box = candidates.boxes[idx];
+    float x = box[0];
+    float y = box[1];
+    float w = box[2];
+    float h = box[3];
+    DetectBox result_box;
+    result_box.class_id = candidates.class_ids[idx];
+    result_box.confidence = candidates.scores[idx];
+    result_box.x = int((x - 0.5 * w) * img_scale);
+    result_box.y = int((y - 0.5 * h) * img_scale);
+    result_box.w = int(w * img_scale);
+    result_box.h = int(h * img_scale);
+    result->push_back(result_box);
+  }
+  return 0;
+}
+
+} // namespace imgutils
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "inference/tensor/tensor.h"
+#include "modelzoo/common/blob_kernels.h"
+#include "modelzoo/common/detect_common.hpp"
+#include "modelzoo/common/nms.h"
+
+namespace imgutils {
+
+// 分数超过阈值的 anchor, 按 anchor 下标升序排列
+struct YoloCandidates {
+  std::vector<cv::Vec4f> boxes; // 模型输入中的 [center_x, center_y, w, h]
+  std::vector<float> scores;    // 最大的类别分数
+  std::vector<int> class_ids;
+  std::vector<int> anchors;
+  // 类别之后的通道(关键点, mask 系数, 角度等), 每个 anchor extra_num 个
+  std::vector<float> extras;
+  int extra_num = 0;
+
+  size_t size() const { return scores.size(); }
+  const float *Extra(size_t i) const { return extras.data() + i * extra_num; }
+  void clear();
+};
+
+/**
+ * @brief 在 [1, 4 + class_num + extra_num, anchor_num] 的 YOLO 输出上原地解码,
+ * 不转置也不整体转换数据类型
+ *
+ * 以 anchor 分块, 逐类别行对整块做 SIMD 的 running max/argmax, 用阈值得到
+ * 掩码后只为剩下的 anchor 读取框和 extra 通道; FP16 输出按块由 F16C 转换.
+ * 与 cv::minMaxLoc 相同, 分数相等时取较小的类别, 分数需要严格大于 threshold.
+ * 类别数和 extra 通道数与 yolo_head.hpp 中模型库的输出头一致时使用编译期特化
+ * 的实现, 其余的在运行期处理
+ */
+int DecodeYoloHead(const inference::TensorDataPointer &tensor, int class_num,
+                   float threshold, YoloCandidates *candidates);
+
+/**
+ * @brief 指定指令集的版本, 用于测试和基准测试, level 超过当前 CPU 支持的
+ * 指令集时返回 -1
+ */
+int DecodeYoloHead(const inference::TensorDataPointer &tensor, int class_num,
+                   float threshold, SimdLevel level,
+                   YoloCandidates *candidates);
+
+/**
+ * @brief 把候选框转换为 NMS 的输入, 下标与 candidates 一致, 坐标仍在模型输入中
+ */
+void ToNmsBoxes(const YoloCandidates &candidates, NmsBoxes *boxes);
+
+/**
+ * @brief 解码 [1, 4 + class_num, anchor_num] 的检测输出并按类别 NMS,
+ * 坐标乘以 img_scale 还原到原图, 结果追加到 result
+ */
+int DecodeYoloDetect(const inference::TensorDataPointer &tensor, int class_num,
+                     const Threshold &threshold, float img_scale,
+                     std::vector<DetectBox> *result);
+
+} // namespace imgutils
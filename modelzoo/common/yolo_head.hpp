@@ -0,0 +1,162 @@
+#pragma once
+
+#include <algorithm>
+#include <type_traits>
+
+#include "modelzoo/common/yolo_decode.h"
+
+namespace imgutils {
+
+// 类别数或 extra 通道数在运行期才确定
+constexpr int kDynamicCount = -1;
+
+enum class YoloHeadType {
+  kDetect = 0,
+  kPose = 1, // extra 为关键点, 每个点 2 或 3 个通道
+  kSeg = 2,  // extra 为 mask 系数
+  kObb = 3,  // extra 为角度
+};
+
+/**
+ * @brief YOLO 输出头的编译期描述, 输出为
+ * [1, 4 + class_num + extra_num, anchor_num]
+ */
+template <YoloHeadType kType, int kClassNum, int kExtraNum>
+struct YoloHead {
+  static constexpr YoloHeadType type = kType;
+  static constexpr int class_num = kClassNum;
+  static constexpr int extra_num = kExtraNum;
+
+  static_assert(kClassNum == kDynamicCount || kClassNum > 0);
+  static_assert(kExtraNum == kDynamicCount ||
+                (kType == YoloHeadType::kDetect && kExtraNum == 0) ||
+                (kType == YoloHeadType::kPose && kExtraNum % 3 == 0) ||
+                (kType == YoloHeadType::kSeg && kExtraNum > 0) ||
+                (kType == YoloHeadType::kObb && kExtraNum == 1));
+
+  // 运行期的类别数和 extra 通道数是否与该输出头一致
+  static bool Match(int class_num, int extra_num) {
+    return (kClassNum == kDynamicCount || kClassNum == class_num) &&
+           (kExtraNum == kDynamicCount || kExtraNum == extra_num);
+  }
+};
+
+// 模型库中 COCO/DOTA 模型的输出头
+using YoloV8DetectHead = YoloHead<YoloHeadType::kDetect, 80, 0>;
+using Yolo11PoseHead = YoloHead<YoloHeadType::kPose, 1, 51>;
+using Yolo11SegHead = YoloHead<YoloHeadType::kSeg, 80, 32>;
+using Yolo11ObbHead = YoloHead<YoloHeadType::kObb, 15, 1>;
+using DynamicYoloHead =
+    YoloHead<YoloHeadType::kDetect, kDynamicCount, kDynamicCount>;
+
+// 按指令集选择的逐行内核, 由 GetYoloRowKernels 返回
+struct YoloRowKernels {
+  // dst[i] = src[i], i in [0, n)
+  void (*load_fp16)(const half_float::half *src, int n, float *dst);
+  // row[i] > max[i] 时更新 max[i] 和 argmax[i] = class_id
+  void (*max_argmax)(const float *row, int n, int class_id, float *max,
+                     int *argmax);
+  // 与 max_argmax 相同, 一次处理 class_id 开始的 4 个类别行,
+  // max/argmax 只读写一次
+  void (*max_argmax4)(const float *const *rows, int n, int class_id,
+                      float *max, int *argmax);
+  // 把 max[i] > threshold 的 i 依次写入 index, 返回个数
+  int (*select)(const float *max, int n, float threshold, int *index);
+};
+
+/**
+ * @brief level 对应的逐行内核, 调用方保证 level 不超过 GetSimdLevel()
+ */
+const YoloRowKernels &GetYoloRowKernels(SimdLevel level);
+
+/**
+ * @brief 按 Head 解码 YOLO 输出, 见 DecodeYoloHead(tensor, ...)
+ *
+ * Head 的类别数和 extra 通道数在编译期确定时, 类别循环和 extra 的拷贝都是
+ * 定长的; 单类别(pose)直接在分数行上选取, 不需要 running max/argmax.
+ * 取 kDynamicCount 的字段使用 class_num/extra_num 参数, 否则忽略参数
+ */
+template <typename Head, typename T>
+void DecodeYoloHead(const T *data, int anchor_num, int class_num,
+                    int extra_num, float threshold,
+                    const YoloRowKernels &kernels,
+                    YoloCandidates *candidates) {
+  // 每次处理的 anchor 数, running max/argmax 和转换缓存都留在 L1 中
+  constexpr int kTileAnchors = 512;
+  constexpr bool kFixedClass = Head::class_num != kDynamicCount;
+  constexpr bool kFixedExtra = Head::extra_num != kDynamicCount;
+  const int classes = kFixedClass ? Head::class_num : class_num;
+  const int extras = kFixedExtra ? Head::extra_num : extra_num;
+  const int extra_begin = 4 + classes;
+
+  alignas(64) float max[kTileAnchors];
+  alignas(64) int argmax[kTileAnchors];
+  alignas(64) float row_buf[4][kTileAnchors];
+  alignas(64) int index[kTileAnchors];
+
+  candidates->clear();
+  candidates->extra_num = extras;
+  for (int begin = 0; begin < anchor_num; begin += kTileAnchors) {
+    int n = std::min(kTileAnchors, anchor_num - begin);
+    // 第 channel 个通道中当前块的 n 个值, FP16 时转换到 buf 中
+    auto row = [&](int channel, float *buf) -> const float * {
+      const T *src = data + (size_t)channel * anchor_num + begin;
+      if constexpr (std::is_same_v<T, float>) {
+        return src;
+      } else {
+        kernels.load_fp16(src, n, buf);
+        return buf;
+      }
+    };
+
+    const float *scores = nullptr;
+    if constexpr (kFixedClass && Head::class_num == 1) {
+      scores = row(4, max);
+    } else {
+      scores = max;
+      const float *first = row(4, max);
+      if (first != max) {
+        std::copy(first, first + n, max);
+      }
+      std::fill(argmax, argmax + n, 0);
+      int c = 1;
+      for (; c + 4 <= classes; c += 4) {
+        const float *rows[4] = {
+            row(4 + c, row_buf[0]), row(5 + c, row_buf[1]),
+            row(6 + c, row_buf[2]), row(7 + c, row_buf[3])};
+        kernels.max_argmax4(rows, n, c, max, argmax);
+      }
+      for (; c < classes; c++) {
+        kernels.max_argmax(row(4 + c, row_buf[0]), n, c, max, argmax);
+      }
+    }
+
+    int count = kernels.select(scores, n, threshold, index);
+    if (count == 0) {
+      continue;
+    }
+    size_t extra_offset = candidates->extras.size();
+    candidates->extras.resize(extra_offset + (size_t)count * extras);
+    float *extra_dst = candidates->extras.data() + extra_offset;
+    for (int k = 0; k < count; k++) {
+      int i = index[k];
+      size_t anchor = begin + i;
+      auto value = [&](int channel) {
+        return (float)data[(size_t)channel * anchor_num + anchor];
+      };
+      candidates->boxes.emplace_back(value(0), value(1), value(2), value(3));
+      candidates->scores.push_back(scores[i]);
+      if constexpr (kFixedClass && Head::class_num == 1) {
+        candidates->class_ids.push_back(0);
+      } else {
+        candidates->class_ids.push_back(argmax[i]);
+      }
+      candidates->anchors.push_back((int)anchor);
+      for (int e = 0; e < extras; e++) {
+        *extra_dst++ = value(extra_begin + e);
+      }
+    }
+  }
+}
+
+} // namespace imgutils
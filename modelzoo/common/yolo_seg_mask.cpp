@@ -0,0 +1,83 @@
+#include "yolo_seg_mask.h"
+
+#include <cpptoolkit/log/log.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include <opencv2/imgproc.hpp>
+
+namespace imgutils {
+
+void DecodeYoloSegMask(const cv::Mat &mask_coeffs, const cv::Mat &protos,
+                       const cv::Vec4f &trans, const cv::Size &raw_size,
+                       const cv::Size &net_size, const cv::Rect &bound,
+                       float mask_threshold, cv::Mat *mask,
+                       std::vector<cv::Point> *contour) {
+  int seg_ch = protos.size[1];
+  int seg_h = protos.size[2];
+  int seg_w = protos.size[3];
+  int net_w = net_size.width;
+  int net_h = net_size.height;
+
+  int r_x = floor((bound.x * trans[0] + trans[2]) / net_w * seg_w);
+  int r_y = floor((bound.y * trans[1] + trans[3]) / net_h * seg_h);
+  int r_w =
+      ceil(((bound.x + bound.width) * trans[0] + trans[2]) / net_w * seg_w) -
+      r_x;
+  int r_h =
+      ceil(((bound.y + bound.height) * trans[1] + trans[3]) / net_h * seg_h) -
+      r_y;
+  r_w = std::max(r_w, 1);
+  r_h = std::max(r_h, 1);
+
+  LOG_DEBUG("mask bound:{}, {}, {}, {}, {}, {}", r_x, r_y, r_w, r_h, seg_w,
+            seg_h);
+
+  if (r_x + r_w > seg_w) // crop
+  {
+    seg_w - r_x > 0 ? r_w = seg_w - r_x : r_x -= 1;
+  }
+  if (r_y + r_h > seg_h) {
+    seg_h - r_y > 0 ? r_h = seg_h - r_y : r_y -= 1;
+  }
+  std::vector<cv::Range> roi_rangs = {cv::Range(0, 1), cv::Range::all(),
+                                      cv::Range(r_y, r_h + r_y),
+                                      cv::Range(r_x, r_w + r_x)};
+  cv::Mat temp_mask = protos(roi_rangs).clone();
+  cv::Mat roi_protos = temp_mask.reshape(0, {seg_ch, r_w * r_h});
+  cv::Mat matmul_res = (mask_coeffs * roi_protos).t();
+  cv::Mat masks_feature = matmul_res.reshape(1, {r_h, r_w});
+  cv::Mat dest;
+  cv::exp(-masks_feature, dest); // sigmoid
+  dest = 1.0 / (1.0 + dest);
+  int left = floor((net_w / seg_w * r_x - trans[2]) / trans[0]);
+  int top = floor((net_h / seg_h * r_y - trans[3]) / trans[1]);
+  int width = ceil(net_w / seg_w * r_w / trans[0]);
+  int height = ceil(net_h / seg_h * r_h / trans[1]);
+  cv::Mat resized;
+  cv::resize(dest, resized, cv::Size(width, height));
+  *mask = resized(bound - cv::Point(left, top)) > mask_threshold;
+
+  // 获得边界框
+  cv::Mat real_img = cv::Mat::zeros(raw_size.height, raw_size.width, CV_8UC1);
+
+  auto roi = real_img(bound);
+  mask->copyTo(roi);
+
+  std::vector<std::vector<cv::Point>> contours;
+  cv::findContours(real_img, contours, cv::RETR_EXTERNAL,
+                   cv::CHAIN_APPROX_SIMPLE);
+  contour->clear();
+  if (contours.size() > 0) {
+    int idx = 0;
+    for (int i = 0; i < contours.size(); i++) {
+      if (contours[i].size() > contours[idx].size()) {
+        idx = i;
+      }
+    }
+    *contour = contours[idx];
+  }
+}
+
+} // namespace imgutils
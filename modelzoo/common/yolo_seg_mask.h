@@ -0,0 +1,24 @@
+#pragma once
+
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+namespace imgutils {
+
+/**
+ * @brief 由目标的 mask 系数和 YOLO 分割模型的原型 mask 计算目标的 mask
+ *
+ * mask_coeffs 为 [1, mask_ch] 的 CV_32F, protos 为 [1, mask_ch, seg_h, seg_w]
+ * 的原型 mask; trans 为原图到模型输入 net_size 的 [scale_x, scale_y, pad_x,
+ * pad_y], bound 为原图中的目标框. 只在 bound 对应的原型区域上做矩阵乘和
+ * sigmoid, mask 为 bound 内超过 mask_threshold 的二值 mask, contour 为原图中
+ * 最大的外轮廓
+ */
+void DecodeYoloSegMask(const cv::Mat &mask_coeffs, const cv::Mat &protos,
+                       const cv::Vec4f &trans, const cv::Size &raw_size,
+                       const cv::Size &net_size, const cv::Rect &bound,
+                       float mask_threshold, cv::Mat *mask,
+                       std::vector<cv::Point> *contour);
+
+} // namespace imgutils
@@ -7,6 +7,8 @@
 #include <cpptoolkit/log/log.h>
 #include <cpptoolkit/strings/to_string.h>
 
+#include <array>
+
 namespace modelzoo {
 
 using ::cpptoolkit::ToString;
@@ -27,7 +29,20 @@ public:
       Deinit();
       return -1;
     }
-    return ret;
+    if (ret != 0) {
+      return ret;
+    }
+
+    // 输出直接写入成员变量, 不再从内部 buffer 拷贝
+    ret = engine.BindOutput("y", confidence_.data(),
+                            {1, (int64_t)confidence_.size()}, inference::kFP32);
+    ret |= engine.BindOutput("z", &idx_, {1}, inference::kInt64);
+    if (ret != 0) {
+      LOG_ERROR("bind output failed");
+      Deinit();
+      return -1;
+    }
+    return 0;
   }
 
   void Deinit() { engine.Deinit(); }
@@ -54,18 +69,24 @@ public:
     // LOG_INFO("i_desc:\n{}", cpptoolkit::MapToString(i_desc));
     // LOG_INFO("o_desc:\n{}", cpptoolkit::MapToString(o_desc));
 
-    auto i_tensor = engine.GetInputTensors();
-    auto x_tensor = &i_tensor.at("x");
-    if (!x_tensor) {
-      THROW_RUNTIME_EXCEPTION("x_tensor is null");
+    if (!img.isContinuous()) {
+      THROW_RUNTIME_EXCEPTION("img must be continuous");
     }
 
-    CHECK_MSG(x_tensor->data_type == inference::kUint8,
-              fmt::format("x_tensor data_type error!!!, x_tensor->data_type:{}",
-                          cpptoolkit::ToString(x_tensor->data_type)));
-    memcpy(x_tensor->p, img.data, img.total());
+    // 直接使用图像数据作为输入, 不再拷贝到内部 buffer
+    int ret = engine.BindInput("x", img.data, {1, 1, img.rows, img.cols},
+                               inference::kUint8);
+    if (ret != 0) {
+      THROW_RUNTIME_EXCEPTION(
+          fmt::format("bind input failed!!! img size:{}x{}", img.cols,
+                      img.rows));
+    }
 
-    engine.Run();
+    // 输入在每次推理前重新绑定, 不会使用已经释放的图像
+    ret = engine.Run();
+    if (ret != 0) {
+      THROW_RUNTIME_EXCEPTION(fmt::format("run engine failed:{}", ret));
+    }
 
     // [2025-11-05 15:39:09.960] [info] [mnist_add_process.hpp:54 Classify]
     // i_desc: {x:TensorDesc {data_type:TensorDataType::Uint8, shape:[1, 1, 28,
@@ -76,18 +97,8 @@ public:
     // element_size:10}, z:TensorDesc {data_type:TensorDataType::Int64,
     // shape:[1], element_size:1}}
 
-    auto o_tensor = engine.GetOutputTensors();
-    auto y_tensor = &o_tensor.at("y");
-    if (!y_tensor) {
-      THROW_RUNTIME_EXCEPTION("y_tensor is null");
-    }
-    auto z_tensor = &o_tensor.at("z");
-    if (!z_tensor) {
-      THROW_RUNTIME_EXCEPTION("z_tensor is null");
-    }
-
-    std::span<float> confidence((float *)y_tensor->p, 10);
-    int64_t idx = *(int64_t *)(z_tensor->p);
+    std::span<float> confidence(confidence_);
+    int64_t idx = idx_;
 
     // LOG_INFO("confidence:{}", cpptoolkit::SpanToString(confidence));
     // LOG_INFO("idx:{}", idx);
@@ -101,6 +112,9 @@ public:
 
 private:
   inference::OnnxRuntimeEngine engine;
+  // 绑定的输出
+  std::array<float, 10> confidence_ = {};
+  int64_t idx_ = 0;
 };
 
 } // namespace modelzoo
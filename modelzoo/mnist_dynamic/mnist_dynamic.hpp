@@ -4,8 +4,11 @@
 #include <cpptoolkit/exception/exception.h>
 #include <cpptoolkit/log/log.h>
 #include <cpptoolkit/strings/to_string.h>
+#include "modelzoo/common/batch_preprocess.h"
 #include "modelzoo/common/img_common.hpp"
 
+#include <algorithm>
+
 namespace modelzoo {
 
 using ::cpptoolkit::ToString;
@@ -15,7 +18,12 @@ class MnistDynamic {
 public:
   using BatchResult = std::vector<std::pair<int, float>>;
 
-  MnistDynamic() {}
+  /**
+   * @param preprocess_pool 按 batch 并行预处理的线程池, 由调用方持有并且
+   * 生命周期长于本对象, 为空时在调用线程串行预处理
+   */
+  explicit MnistDynamic(inference::ThreadPool *preprocess_pool = nullptr)
+      : preprocess_pool_(preprocess_pool) {}
   ~MnistDynamic() { Deinit(); }
 
   int Init(const inference::InferenceParams &params) {
@@ -57,12 +65,14 @@ public:
             "img idx:{} type error, cur_img_type:{}, need_img_type:{}", i,
             imgs[i].type(), CV_8UC1));
       }
+    }
 
-      auto p = i_tensor.p_arr[i];
-      imgutils::BlobNormalizeFromImage(imgs[i], p, i_tensor.data_type);
+    int ret = imgutils::BlobNormalizeBatch(preprocess_pool_, imgs, i_tensor);
+    if (ret != 0) {
+      THROW_RUNTIME_EXCEPTION(fmt::format("Failed to preprocess, ret:{}", ret));
     }
 
-    int ret = engine.Run(batch_size);
+    ret = engine.Run(batch_size);
     if (ret != 0) {
       THROW_RUNTIME_EXCEPTION(fmt::format("Failed to run engine, ret:{}", ret));
     }
@@ -84,6 +94,8 @@ public:
 
 private:
   inference::OnnxRuntimeEngine engine;
+  // 不持有, 为空时串行预处理
+  inference::ThreadPool *preprocess_pool_ = nullptr;
 };
 
 } // namespace modelzoo
@@ -2,6 +2,8 @@
 #include "inference/onnxruntime/onnxruntime.h"
 #include <cpptoolkit/log/log.h>
 #include "modelzoo/common/img_common.hpp"
+#include "modelzoo/common/rotated_nms.h"
+#include "modelzoo/common/yolo_decode.h"
 
 #define M_PI 3.14159265358979323846
 
@@ -9,27 +11,6 @@ namespace modelzoo {
 
 namespace {
 
-void covariance_matrix(float w, float h, float r, float &a_val, float &b_val,
-                       float &c_val) {
-  // 检查输入参数的有效性
-  if (w < 0 || h < 0) {
-    a_val = b_val = c_val = 0;
-    return;
-  }
-  float a = (w * w) / 12;
-  float b = (h * h) / 12;
-  float cos_r = cosf(r);
-  float sin_r = sinf(r);
-
-  a_val = a * cos_r * cos_r + b * sin_r * sin_r;
-  b_val = a * sin_r * sin_r + b * cos_r * cos_r;
-  c_val = (a - b) * sin_r * cos_r;
-}
-
-float square(float x) {
-  return x * x; // 返回输入数的平方
-}
-
 cv::Point rotate_point(float x, float y, float theta) {
   float x_new = x * cos(theta) - y * sin(theta);
   float y_new = x * sin(theta) + y * cos(theta);
@@ -38,59 +19,28 @@ cv::Point rotate_point(float x, float y, float theta) {
 
 using YoloTempBox = Yolo11NObb::Box;
 
-float probiou2(const YoloTempBox &obb1, const YoloTempBox &obb2, float eps) {
-  float a1, b1, c1;
-  float a2, b2, c2;
-
-  covariance_matrix(obb1.box[2], obb1.box[3], obb1.angle, a1, b1, c1);
-  covariance_matrix(obb2.box[2], obb2.box[3], obb2.angle, a2, b2, c2);
-
-  float x1 = obb1.box[0] + obb1.box[2] / 2;
-  float y1 = obb1.box[1] + obb1.box[3] / 2;
-  float x2 = obb2.box[0] + obb2.box[2] / 2;
-  float y2 = obb2.box[1] + obb2.box[3] / 2;
-
-  float t1 = ((a1 + a2) * square(y1 - y2) + (b1 + b2) * square(x1 - x2)) /
-             ((a1 + a2) * (b1 + b2) - square(c1 + c2) + eps);
-  float t2 = ((c1 + c2) * (x2 - x1) * (y1 - y2)) /
-             ((a1 + a2) * (b1 + b2) - square(c1 + c2) + eps);
-  float t3 = log(
-      ((a1 + a2) * (b1 + b2) - square(c1 + c2)) /
-          (4 * sqrt(a1 * b1 - square(c1)) * sqrt(a2 * b2 - square(c2)) + eps) +
-      eps);
-
-  float bd = 0.25f * t1 + 0.5f * t2 + 0.5f * t3;
-  float hd = sqrtf(1.0f - expf(-fminf(fmaxf(bd, eps), 100.0f)) + eps);
-
-  return 1.0f - hd;
-}
-
+// 按 probiou 去除同类别重叠的旋转框, 结果按分数降序排列
 void ProbiouNMS(std::vector<YoloTempBox> &yolo_temp_boxes, float nmsThresh) {
-  std::sort(yolo_temp_boxes.begin(), yolo_temp_boxes.end(),
-            [](const YoloTempBox &a, const YoloTempBox &b) {
-              return a.score > b.score;
-            });
-  std::vector<bool> remove_flags(yolo_temp_boxes.size(), false);
-
-  for (size_t i = 0; i < yolo_temp_boxes.size(); ++i) {
-    if (remove_flags[i] || yolo_temp_boxes[i].score == 0)
-      continue;
-
-    for (size_t j = i + 1; j < yolo_temp_boxes.size(); ++j) {
-      if (remove_flags[j] || yolo_temp_boxes[j].score == 0 ||
-          yolo_temp_boxes[i].class_id != yolo_temp_boxes[j].class_id)
-        continue;
-
-      if (probiou2(yolo_temp_boxes[i], yolo_temp_boxes[j], 1e-7) > nmsThresh) {
-        remove_flags[j] = true;
-      }
-    }
+  imgutils::RotatedNmsBoxes boxes;
+  boxes.reserve(yolo_temp_boxes.size());
+  for (const auto &b : yolo_temp_boxes) {
+    boxes.Add(b.box[0], b.box[1], b.box[2], b.box[3], b.angle, b.score,
+              b.class_id);
+  }
+  imgutils::NmsParams params;
+  params.score_threshold = 0.0f;
+  params.iou_threshold = nmsThresh;
+  params.class_aware = true;
+  std::vector<int> keep;
+  if (imgutils::RotatedNms(boxes, params, &keep) != 0) {
+    LOG_ERROR("rotated nms failed");
+    yolo_temp_boxes.clear();
+    return;
   }
   std::vector<YoloTempBox> newBoxes;
-  for (size_t i = 0; i < yolo_temp_boxes.size(); ++i) {
-    if (!remove_flags[i]) {
-      newBoxes.push_back(yolo_temp_boxes[i]);
-    }
+  newBoxes.reserve(keep.size());
+  for (int i : keep) {
+    newBoxes.push_back(yolo_temp_boxes[i]);
   }
   yolo_temp_boxes = std::move(newBoxes);
 }
@@ -134,7 +84,22 @@ int Yolo11NObb::Init(const inference::InferenceParams &params) {
     return -1;
   }
 
-  return ret;
+  if (ret != 0) {
+    return ret;
+  }
+
+  images_handle_ = engine_->GetInputHandle("images");
+  output0_handle_ = engine_->GetOutputHandle("output0");
+  if (images_handle_ == inference::kInvalidTensorHandle ||
+      output0_handle_ == inference::kInvalidTensorHandle) {
+    LOG_ERROR("model input/output name mismatch");
+    Deinit();
+    return -1;
+  }
+
+  // 描述文件无效时已回退到默认的 YOLO 预处理, 不影响初始化
+  preprocessor_.SetSpecForModel(params.model_path);
+  return 0;
 }
 
 void Yolo11NObb::Deinit() { engine_->Deinit(); }
@@ -174,48 +139,40 @@ int Yolo11NObb::DetectObb(const cv::Mat &img, Result &result) {
 }
 
 int Yolo11NObb::Preprocess(const cv::Mat &img) {
-  auto i_tensor = engine_->GetInputTensors().at("images");
-  auto [dst_img, img_scale] =
-      imgutils::LetterBoxPadImage(img, cv::Size(1024, 1024));
+  const auto &i_tensor = engine_->GetInputTensor(images_handle_);
+  imgutils::PreprocessInfo info;
+  int ret = preprocessor_.Run(img, i_tensor, &info);
+  if (ret != 0) {
+    return ret;
+  }
 
   image_info_.raw_size.width = img.cols;
   image_info_.raw_size.height = img.rows;
-  image_info_.trans = {1.0f / img_scale, 1.0f / img_scale, 0, 0};
-
-  imgutils::BlobNormalizeFromImage(dst_img, i_tensor.p, i_tensor.data_type);
+  image_info_.trans = {1.0f / info.scale, 1.0f / info.scale, (float)info.pad.x,
+                       (float)info.pad.y};
   return 0;
 }
 
 int Yolo11NObb::Postprocess(Result &result) {
-  auto o_tensor = engine_->GetOutputTensors().at("output0");
-  const auto &o_shape = o_tensor.shape;
-  const auto &o_data = o_tensor.p;
-  const auto &o_data_type = o_tensor.data_type;
-
-  cv::Mat o_tensor_data = cv::Mat(o_shape[1], o_shape[2], CV_32F, o_data);
-  o_tensor_data = o_tensor_data.t();
-  auto tensor_p = (float *)o_tensor_data.data;
-
-  int stride_len = o_shape[1];
-  int obj_cnt = o_shape[2];
+  const auto &o_tensor = engine_->GetOutputTensor(output0_handle_);
+  // [1, 4 + class_num + 1, obj_cnt], 角度在类别之后
+  imgutils::YoloCandidates candidates;
+  int ret = imgutils::DecodeYoloHead(o_tensor, class_num_,
+                                     threshold_.det_threshold, &candidates);
+  if (ret != 0) {
+    return ret;
+  }
+  if (candidates.extra_num < 1) {
+    LOG_ERROR("obb output has no angle channel");
+    return -1;
+  }
 
   std::vector<YoloTempBox> yolo_temp_boxes;
-
-  for (int i = 0; i < obj_cnt; i++) {
-    float *start_data = tensor_p + i * stride_len;
-    cv::Vec4f box = {start_data[0], start_data[1], start_data[2],
-                     start_data[3]};
-
-    cv::Mat conf = cv::Mat(1, class_num_, CV_32F, start_data + 4);
-    cv::Point class_id;
-    double maxClassScore;
-    cv::minMaxLoc(conf, nullptr, &maxClassScore, nullptr, &class_id);
-    auto *angle = start_data + 4 + class_num_;
-
-    if (maxClassScore > threshold_.det_threshold) {
-      yolo_temp_boxes.push_back(
-          {box, *angle, (float)maxClassScore, class_id.x});
-    }
+  yolo_temp_boxes.reserve(candidates.size());
+  for (size_t i = 0; i < candidates.size(); i++) {
+    yolo_temp_boxes.push_back({candidates.boxes[i], *candidates.Extra(i),
+                               candidates.scores[i],
+                               candidates.class_ids[i]});
   }
 
   ProbiouNMS(yolo_temp_boxes, threshold_.nms_threshold);
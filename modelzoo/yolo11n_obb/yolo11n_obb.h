@@ -1,6 +1,7 @@
 #pragma once
 
 #include "inference/inference.h"
+#include "modelzoo/common/preprocess.h"
 #include <opencv2/opencv.hpp>
 
 namespace inference {
@@ -52,6 +53,9 @@ private:
   int Postprocess(Result &result);
 
   std::unique_ptr<inference::OnnxRuntimeEngine> engine_;
+  inference::TensorHandle images_handle_ = inference::kInvalidTensorHandle;
+  inference::TensorHandle output0_handle_ = inference::kInvalidTensorHandle;
+  imgutils::Preprocessor preprocessor_;
   ImageInfo image_info_;
   int class_num_ = 0;
   Thresholds threshold_;
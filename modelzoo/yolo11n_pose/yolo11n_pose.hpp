@@ -8,7 +8,10 @@
 
 #include "modelzoo/common/detect_common.hpp"
 #include "modelzoo/common/img_common.hpp"
+#include "modelzoo/common/nms.h"
 #include "modelzoo/common/pose_common.hpp"
+#include "modelzoo/common/preprocess.h"
+#include "modelzoo/common/yolo_decode.h"
 
 #define DUMP_MODEL_IO
 
@@ -54,7 +57,19 @@ public:
       return -1;
     }
 
-    return ret;
+    if (ret != 0) {
+      return ret;
+    }
+
+    images_handle_ = engine.GetInputHandle("images");
+    output0_handle_ = engine.GetOutputHandle("output0");
+    if (images_handle_ == inference::kInvalidTensorHandle ||
+        output0_handle_ == inference::kInvalidTensorHandle) {
+      LOG_ERROR("model input/output name mismatch");
+      Deinit();
+      return -1;
+    }
+    return 0;
   }
 
   std::string DumpModel() { return engine.DumpModelInfo(); }
@@ -100,90 +115,59 @@ private:
       return -1;
     }
 
-    auto i_tensor = engine.GetInputTensors().at("images");
-    auto [dst_img, img_scale] =
-        imgutils::LetterBoxPadImage(img, cv::Size(640, 640));
-    img_scales_ = img_scale;
-    imgutils::BlobNormalizeFromImage(dst_img, i_tensor.p, i_tensor.data_type);
+    const auto &i_tensor = engine.GetInputTensor(images_handle_);
+    imgutils::PreprocessInfo info;
+    int ret = preprocessor_.Run(img, i_tensor, &info);
+    if (ret != 0) {
+      return ret;
+    }
+    img_scales_ = info.scale;
     return 0;
   }
 
   int Postprocess(Result &result) {
-    auto o_tensor = engine.GetOutputTensors().at("output0");
-    const auto &o_shape = o_tensor.shape;
-    const auto &o_data = o_tensor.p;
-    const auto &o_data_type = o_tensor.data_type;
-    int signalResultNum = o_shape[1]; // 4 + 1 + kpt_tensor_size
-    int class_cnt = 1;
-    int strideNum = o_shape[2]; // 8400
-
-    std::vector<int> class_ids;
-    std::vector<float> confidences;
-    std::vector<cv::Rect> boxes;
-    cv::Mat rawData;
-
-    if (o_data_type == inference::TensorDataType::kFP32) {
-      rawData = cv::Mat(o_shape[1], o_shape[2], CV_32F, o_data);
-    } else if (o_data_type == inference::TensorDataType::kFP16) {
-      rawData = cv::Mat(o_shape[1], o_shape[2], CV_16F, o_data);
-      rawData.convertTo(rawData, CV_32F);
-    }
-    rawData = rawData.t();
-    float *data = (float *)rawData.data;
-
-    std::vector<float *> key_pointers;
-    key_pointers.reserve(strideNum);
-    confidences.reserve(strideNum);
-    class_ids.reserve(strideNum);
-
-    for (int i = 0; i < strideNum; ++i) {
-      float *classesScores = data + 4;
-      cv::Mat scores(1, class_cnt, CV_32FC1, classesScores);
-      cv::Point class_id;
-      double maxClassScore;
-      cv::minMaxLoc(scores, 0, &maxClassScore, 0, &class_id);
-      if (maxClassScore > threshold_.det_threshold) {
-        confidences.push_back(maxClassScore);
-        class_ids.push_back(class_id.x);
-        float x = data[0];
-        float y = data[1];
-        float w = data[2];
-        float h = data[3];
-        int left = int((x - 0.5 * w) * img_scales_);
-        int top = int((y - 0.5 * h) * img_scales_);
-        int width = int(w * img_scales_);
-        int height = int(h * img_scales_);
-        boxes.push_back(cv::Rect(left, top, width, height));
-        key_pointers.push_back(data + 5);
-      }
-      data += signalResultNum;
+    const auto &o_tensor = engine.GetOutputTensor(output0_handle_);
+    // [1, 4 + 1 + kpt_tensor_size, 8400], 关键点在 extra 通道中
+    imgutils::YoloCandidates candidates;
+    int ret = imgutils::DecodeYoloHead(o_tensor, 1, threshold_.det_threshold,
+                                       &candidates);
+    if (ret != 0) {
+      return ret;
     }
-    std::vector<int> nmsResult;
-    cv::dnn::NMSBoxes(boxes, confidences, threshold_.det_threshold,
-                      threshold_.iou_threshold, nmsResult);
-    for (int i = 0; i < nmsResult.size(); ++i) {
-      int idx = nmsResult[i];
 
+    imgutils::NmsBoxes nms_boxes;
+    imgutils::ToNmsBoxes(candidates, &nms_boxes);
+    imgutils::NmsParams nms_params;
+    nms_params.score_threshold = threshold_.det_threshold;
+    nms_params.iou_threshold = threshold_.iou_threshold;
+    std::vector<int> nmsResult;
+    ret = imgutils::Nms(nms_boxes, nms_params, &nmsResult);
+    if (ret != 0) {
+      return ret;
+    }
+    for (int idx : nmsResult) {
       // detect box
-      auto &box = boxes[idx];
+      const auto &box = candidates.boxes[idx];
+      float x = box[0];
+      float y = box[1];
+      float w = box[2];
+      float h = box[3];
       imgutils::DetectBox result_box;
-      result_box.class_id = class_ids[idx];
-      result_box.confidence = confidences[idx];
-      result_box.x = box.x;
-      result_box.y = box.y;
-      result_box.w = box.width;
-      result_box.h = box.height;
-
-      auto kps = DecodeKeyPoints(key_pointers, idx);
+      result_box.class_id = candidates.class_ids[idx];
+      result_box.confidence = candidates.scores[idx];
+      result_box.x = int((x - 0.5 * w) * img_scales_);
+      result_box.y = int((y - 0.5 * h) * img_scales_);
+      result_box.w = int(w * img_scales_);
+      result_box.h = int(h * img_scales_);
+
+      auto kps = DecodeKeyPoints(candidates.Extra(idx));
       result.push_back({result_box, kps});
     }
 
     return 0;
   }
 
-  imgutils::KeyPointList DecodeKeyPoints(const std::vector<float *> &kp_tensor,
-                                         int idx) {
-    auto p = kp_tensor[idx];
+  imgutils::KeyPointList DecodeKeyPoints(const float *p) {
     int point_num = kpt_shapes_[0];
     int point_tensor_len = kpt_shapes_[1];
     imgutils::KeyPointList kps;
@@ -201,7 +185,10 @@ private:
   }
 
   inference::OnnxRuntimeEngine engine;
+  inference::TensorHandle images_handle_ = inference::kInvalidTensorHandle;
+  inference::TensorHandle output0_handle_ = inference::kInvalidTensorHandle;
   Threshold threshold_ = {0.1, 0.5};
+  imgutils::Preprocessor preprocessor_;
   float img_scales_ = 0.0f;
   std::vector<int> kpt_shapes_;
 };
@@ -21,127 +21,61 @@ TensorDesc(data_type:TensorDataType::FP32, shape:[1, 32, 160, 160], element_size
 #include <cpptoolkit/log/log.h>
 #include <cpptoolkit/strings/to_string.h>
 #include "modelzoo/common/img_common.hpp"
+#include "modelzoo/common/nms.h"
+#include "modelzoo/common/yolo_decode.h"
+#include "modelzoo/common/yolo_seg_mask.h"
 
 namespace {
 
-int seg_ch = 32;
-int seg_w = 160, seg_h = 160;
 int net_w = 640, net_h = 640;
 float accu_thresh = 0.25, mask_thresh = 0.5;
 
-void GetMask(const cv::Mat &mask_info, const cv::Mat &mask_data,
-             const modelzoo::Yolo11NSeg::ImageInfo &para, cv::Rect bound,
-             cv::Mat &mast_out, std::vector<cv::Point> &mask_countours) {
-  cv::Vec4f trans = para.trans;
-  int r_x = floor((bound.x * trans[0] + trans[2]) / net_w * seg_w);
-  int r_y = floor((bound.y * trans[1] + trans[3]) / net_h * seg_h);
-  int r_w =
-      ceil(((bound.x + bound.width) * trans[0] + trans[2]) / net_w * seg_w) -
-      r_x;
-  int r_h =
-      ceil(((bound.y + bound.height) * trans[1] + trans[3]) / net_h * seg_h) -
-      r_y;
-  r_w = MAX(r_w, 1);
-  r_h = MAX(r_h, 1);
-
-  LOG_DEBUG("mask bound:{}, {}, {}, {}, {}, {}", r_x, r_y, r_w, r_h, seg_w,
-            seg_h);
-
-  if (r_x + r_w > seg_w) // crop
-  {
-    seg_w - r_x > 0 ? r_w = seg_w - r_x : r_x -= 1;
-  }
-  if (r_y + r_h > seg_h) {
-    seg_h - r_y > 0 ? r_h = seg_h - r_y : r_y -= 1;
-  }
-  std::vector<cv::Range> roi_rangs = {cv::Range(0, 1), cv::Range::all(),
-                                      cv::Range(r_y, r_h + r_y),
-                                      cv::Range(r_x, r_w + r_x)};
-  cv::Mat temp_mask = mask_data(roi_rangs).clone();
-  cv::Mat protos = temp_mask.reshape(0, {seg_ch, r_w * r_h});
-  cv::Mat matmul_res = (mask_info * protos).t();
-  cv::Mat masks_feature = matmul_res.reshape(1, {r_h, r_w});
-  cv::Mat dest;
-  cv::exp(-masks_feature, dest); // sigmoid
-  dest = 1.0 / (1.0 + dest);
-  int left = floor((net_w / seg_w * r_x - trans[2]) / trans[0]);
-  int top = floor((net_h / seg_h * r_y - trans[3]) / trans[1]);
-  int width = ceil(net_w / seg_w * r_w / trans[0]);
-  int height = ceil(net_h / seg_h * r_h / trans[1]);
-  cv::Mat mask;
-  cv::resize(dest, mask, cv::Size(width, height));
-  mast_out = mask(bound - cv::Point(left, top)) > mask_thresh;
-
-  // 获得边界框
-  cv::Mat real_img =
-      cv::Mat::zeros(para.raw_size.height, para.raw_size.width, CV_8UC1);
-
-  auto roi = real_img(bound);
-  mast_out.copyTo(roi);
-
-  std::vector<std::vector<cv::Point>> contours;
-  cv::findContours(real_img, contours, cv::RETR_EXTERNAL,
-                   cv::CHAIN_APPROX_SIMPLE);
-  mask_countours.clear();
-  if (contours.size() > 0) {
-    int idx = 0;
-    for (int i = 0; i < contours.size(); i++) {
-      if (contours[i].size() > contours[idx].size()) {
-        idx = i;
-      }
-    }
-    mask_countours = contours[idx];
-  }
-}
-
-void DecodeOutput(cv::Mat &output0, cv::Mat &output1,
-                  modelzoo::Yolo11NSeg::ImageInfo para,
-                  std::vector<modelzoo::Yolo11NSeg::ResultObj> &output,
-                  int class_cnt) {
+int DecodeOutput(const inference::TensorDataPointer &output0,
+                 cv::Mat &output1, modelzoo::Yolo11NSeg::ImageInfo para,
+                 modelzoo::Yolo11NSeg::Result &output, int class_cnt) {
   auto trans = para.trans;
   LOG_DEBUG("start decode output, trans:{}, {}, {}, {}", trans[0], trans[1],
             trans[2], trans[3]);
   output.clear();
-  std::vector<int> class_ids;
-  std::vector<float> accus;
-  std::vector<cv::Rect> boxes;
-  std::vector<std::vector<float>> masks;
-  int data_width = class_cnt + 4 + 32;
-  int rows = output0.rows;
-  float *pdata = (float *)output0.data;
-  for (int r = 0; r < rows; ++r) {
-    cv::Mat scores(1, class_cnt, CV_32FC1, pdata + 4);
-    cv::Point class_id;
-    double max_socre;
-    minMaxLoc(scores, 0, &max_socre, 0, &class_id);
-    if (max_socre >= accu_thresh) {
-      masks.push_back(
-          std::vector<float>(pdata + 4 + class_cnt, pdata + data_width));
-
-      float w = pdata[2] / para.trans[0];
-      float h = pdata[3] / para.trans[1];
-      int left = MAX(
-          int((pdata[0] - para.trans[2]) / para.trans[0] - 0.5 * w + 0.5), 0);
-      int top = MAX(
-          int((pdata[1] - para.trans[3]) / para.trans[1] - 0.5 * h + 0.5), 0);
-      class_ids.push_back(class_id.x);
-      accus.push_back(max_socre);
-      boxes.push_back(cv::Rect(left, top, int(w + 0.5), int(h + 0.5)));
-    }
-    pdata += data_width; // next line
+  imgutils::YoloCandidates candidates;
+  int ret = imgutils::DecodeYoloHead(output0, class_cnt, accu_thresh,
+                                     &candidates);
+  if (ret != 0) {
+    return ret;
   }
+
+  // 与 ultralytics 一致按类别 NMS
+  imgutils::NmsBoxes nms_boxes;
+  imgutils::ToNmsBoxes(candidates, &nms_boxes);
+  imgutils::NmsParams nms_params;
+  nms_params.score_threshold = accu_thresh;
+  nms_params.iou_threshold = mask_thresh;
   std::vector<int> nms_result;
-  cv::dnn::NMSBoxes(boxes, accus, accu_thresh, mask_thresh, nms_result);
-  for (int i = 0; i < nms_result.size(); ++i) {
-    int idx = nms_result[i];
-    // boxes[idx] =
-    // boxes[idx] & cv::Rect(0, 0, para.raw_size.width, para.raw_size.height);
-    modelzoo::Yolo11NSeg::ResultObj result = {class_ids[idx], accus[idx],
-                                              boxes[idx]};
-    GetMask(cv::Mat(masks[idx]).t(), output1, para, boxes[idx], result.mask,
-            result.mask_countours);
+  ret = imgutils::Nms(nms_boxes, nms_params, &nms_result);
+  if (ret != 0) {
+    return ret;
+  }
+  for (int idx : nms_result) {
+    const auto &box = candidates.boxes[idx];
+    float w = box[2] / para.trans[0];
+    float h = box[3] / para.trans[1];
+    int left =
+        MAX(int((box[0] - para.trans[2]) / para.trans[0] - 0.5 * w + 0.5), 0);
+    int top =
+        MAX(int((box[1] - para.trans[3]) / para.trans[1] - 0.5 * h + 0.5), 0);
+    cv::Rect bound(left, top, int(w + 0.5), int(h + 0.5));
+    // bound = bound & cv::Rect(0, 0, para.raw_size.width,
+    // para.raw_size.height);
+    modelzoo::Yolo11NSeg::ResultObj result = {candidates.class_ids[idx],
+                                              candidates.scores[idx], bound};
+    cv::Mat mask_info(1, candidates.extra_num, CV_32F,
+                      (void *)candidates.Extra(idx));
+    imgutils::DecodeYoloSegMask(mask_info, output1, para.trans, para.raw_size,
+                                cv::Size(net_w, net_h), bound, mask_thresh,
+                                &result.mask, &result.mask_countours);
     output.push_back(result);
   }
+  return 0;
 }
 
 } // namespace
@@ -162,7 +96,21 @@ int Yolo11NSeg::Init(const inference::InferenceParams &params) {
     return -1;
   }
 
-  return ret;
+  if (ret != 0) {
+    return ret;
+  }
+
+  images_handle_ = engine_->GetInputHandle("images");
+  output0_handle_ = engine_->GetOutputHandle("output0");
+  output1_handle_ = engine_->GetOutputHandle("output1");
+  if (images_handle_ == inference::kInvalidTensorHandle ||
+      output0_handle_ == inference::kInvalidTensorHandle ||
+      output1_handle_ == inference::kInvalidTensorHandle) {
+    LOG_ERROR("model input/output name mismatch");
+    Deinit();
+    return -1;
+  }
+  return 0;
 }
 
 void Yolo11NSeg::Deinit() { engine_->Deinit(); }
@@ -202,35 +150,31 @@ int Yolo11NSeg::Segment(const cv::Mat &img, Result &result) {
 }
 
 int Yolo11NSeg::Preprocess(const cv::Mat &img) {
-  auto i_tensor = engine_->GetInputTensors().at("images");
-  auto [dst_img, img_scale] =
-      imgutils::LetterBoxPadImage(img, cv::Size(640, 640));
-  // img_scales_ = img_scale;
+  const auto &i_tensor = engine_->GetInputTensor(images_handle_);
+  imgutils::PreprocessInfo info;
+  int ret = preprocessor_.Run(img, i_tensor, &info);
+  if (ret != 0) {
+    return ret;
+  }
   img_info_.raw_size.width = img.cols;
   img_info_.raw_size.height = img.rows;
-  img_info_.trans = {1.0f / img_scale, 1.0f / img_scale, 0, 0};
-
-  imgutils::BlobNormalizeFromImage(dst_img, i_tensor.p, i_tensor.data_type);
+  img_info_.trans = {1.0f / info.scale, 1.0f / info.scale, (float)info.pad.x,
+                     (float)info.pad.y};
   return 0;
 }
 
 int Yolo11NSeg::Postprocess(Result &result) {
-  auto output_0 = engine_->GetOutputTensors().at("output0");
-  auto output_1 = engine_->GetOutputTensors().at("output1");
+  const auto &output_0 = engine_->GetOutputTensor(output0_handle_);
+  const auto &output_1 = engine_->GetOutputTensor(output1_handle_);
 
-  auto data_shape = output_0.shape;
-  cv::Mat output0 = cv::Mat(cv::Size((int)data_shape[2], (int)data_shape[1]),
-                            CV_32F, output_0.p)
-                        .t();
-  auto mask_shape = output_1.shape;
+  const auto &mask_shape = output_1.shape;
   std::vector<int> mask_sz = {1, (int)mask_shape[1], (int)mask_shape[2],
                               (int)mask_shape[3]};
   cv::Mat output1 = cv::Mat(mask_sz, CV_32F, output_1.p);
   // ImageInfo img_info = {cv::Size(640, 640),
   // {1.0f / img_scales_ , 1.0f / img_scales_, 0, 0}};
 
-  DecodeOutput(output0, output1, img_info_, result, 80);
-  return 0;
+  return DecodeOutput(output_0, output1, img_info_, result, 80);
 }
 
 void Yolo11NSeg::DrawResult(cv::Mat &img, Result &result,
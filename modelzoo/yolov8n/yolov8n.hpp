@@ -8,6 +8,9 @@
 
 #include "modelzoo/common/detect_common.hpp"
 #include "modelzoo/common/img_common.hpp"
+#include "modelzoo/common/nms.h"
+#include "modelzoo/common/preprocess.h"
+#include "modelzoo/common/yolo_decode.h"
 
 #define DUMP_MODEL_IO
 
@@ -47,7 +50,22 @@ public:
       return -1;
     }
 
-    return ret;
+    if (ret != 0) {
+      return ret;
+    }
+
+    images_handle_ = engine.GetInputHandle("images");
+    output0_handle_ = engine.GetOutputHandle("output0");
+    if (images_handle_ == inference::kInvalidTensorHandle ||
+        output0_handle_ == inference::kInvalidTensorHandle) {
+      LOG_ERROR("model input/output name mismatch");
+      Deinit();
+      return -1;
+    }
+
+    // 描述文件无效时已回退到默认的 YOLO 预处理, 不影响初始化
+    preprocessor_.SetSpecForModel(params.model_path);
+    return 0;
   }
 
   void Deinit() { engine.Deinit(); }
@@ -86,82 +104,26 @@ public:
 
 private:
   int Preprocess(const cv::Mat &img) {
-    auto i_tensor = engine.GetInputTensors().at("images");
-    auto [dst_img, img_scale] =
-        imgutils::LetterBoxPadImage(img, cv::Size(640, 640));
-    img_scales_ = img_scale;
-    imgutils::BlobNormalizeFromImage(dst_img, i_tensor.p, i_tensor.data_type);
+    const auto &i_tensor = engine.GetInputTensor(images_handle_);
+    imgutils::PreprocessInfo info;
+    int ret = preprocessor_.Run(img, i_tensor, &info);
+    if (ret != 0) {
+      return ret;
+    }
+    img_scales_ = info.scale;
     return 0;
   }
 
   int Postprocess(Result &result) {
-    auto o_tensor = engine.GetOutputTensors().at("output0");
-    const auto &o_shape = o_tensor.shape;
-    const auto &o_data = o_tensor.p;
-    const auto &o_data_type = o_tensor.data_type;
-    int signalResultNum = o_shape[1]; // 84
-    int class_cnt = class_num_;
-    int strideNum = o_shape[2]; // 8400
-
-    std::vector<int> class_ids;
-    std::vector<float> confidences;
-    std::vector<cv::Rect> boxes;
-    cv::Mat rawData;
-
-    if (o_data_type == inference::TensorDataType::kFP32) {
-      rawData = cv::Mat(o_shape[1], o_shape[2], CV_32F, o_data);
-    } else if (o_data_type == inference::TensorDataType::kFP16) {
-      rawData = cv::Mat(o_shape[1], o_shape[2], CV_16F, o_data);
-      rawData.convertTo(rawData, CV_32F);
-    }
-    rawData = rawData.t();
-    float *data = (float *)rawData.data;
-
-    for (int i = 0; i < strideNum; ++i) {
-      float *classesScores = data + 4;
-      cv::Mat scores(1, class_cnt, CV_32FC1, classesScores);
-      cv::Point class_id;
-      double maxClassScore;
-      cv::minMaxLoc(scores, 0, &maxClassScore, 0, &class_id);
-      if (maxClassScore > threshold_.det_threshold) {
-        confidences.push_back(maxClassScore);
-        class_ids.push_back(class_id.x);
-        float x = data[0];
-        float y = data[1];
-        float w = data[2];
-        float h = data[3];
-
-        int left = int((x - 0.5 * w) * img_scales_);
-        int top = int((y - 0.5 * h) * img_scales_);
-
-        int width = int(w * img_scales_);
-        int height = int(h * img_scales_);
-
-        boxes.push_back(cv::Rect(left, top, width, height));
-      }
-      data += signalResultNum;
-    }
-    std::vector<int> nmsResult;
-    cv::dnn::NMSBoxes(boxes, confidences, threshold_.det_threshold,
-                      threshold_.iou_threshold, nmsResult);
-    for (int i = 0; i < nmsResult.size(); ++i) {
-      auto &box = boxes[nmsResult[i]];
-      int idx = nmsResult[i];
-      imgutils::DetectBox result_box;
-      result_box.class_id = class_ids[idx];
-      result_box.confidence = confidences[idx];
-      result_box.x = box.x;
-      result_box.y = box.y;
-      result_box.w = box.width;
-      result_box.h = box.height;
-      result.push_back(result_box);
-      // LOG_INFO("result !!");
-    }
-
-    return 0;
+    const auto &o_tensor = engine.GetOutputTensor(output0_handle_);
+    return imgutils::DecodeYoloDetect(o_tensor, class_num_, threshold_,
+                                      img_scales_, &result);
   }
 
   inference::OnnxRuntimeEngine engine;
+  inference::TensorHandle images_handle_ = inference::kInvalidTensorHandle;
+  inference::TensorHandle output0_handle_ = inference::kInvalidTensorHandle;
+  imgutils::Preprocessor preprocessor_;
   Threshold threshold_ = {0.1, 0.5};
   float img_scales_ = 0.0f;
   int class_num_ = 0;
@@ -0,0 +1,72 @@
+#include "modelzoo/common/blob_kernels.h"
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace {
+
+// 逐像素的参考实现
+std::vector<float> HwcToChwReference(const cv::Mat &img, float scale) {
+  int channels = img.channels();
+  std::vector<float> blob(channels * img.total());
+  for (int c = 0; c < channels; c++) {
+    for (int h = 0; h < img.rows; h++) {
+      for (int w = 0; w < img.cols; w++) {
+        blob[c * img.total() + h * img.cols + w] =
+            img.ptr<uint8_t>(h)[w * channels + c] * scale;
+      }
+    }
+  }
+  return blob;
+}
+
+void CheckAllSimdLevels(const cv::Mat &img) {
+  const float scale = 1.0f / 255.0f;
+  auto expected = HwcToChwReference(img, scale);
+  for (int level = 0; level <= (int)imgutils::GetSimdLevel(); level++) {
+    auto simd_level = (imgutils::SimdLevel)level;
+    for (bool parallel : {false, true}) {
+      std::vector<float> fp32(expected.size());
+      std::vector<half_float::half> fp16(expected.size());
+      imgutils::HwcToChw(img, fp32.data(), scale, simd_level, parallel);
+      imgutils::HwcToChw(img, fp16.data(), scale, simd_level, parallel);
+      for (size_t i = 0; i < expected.size(); i++) {
+        ASSERT_EQ(fp32[i], expected[i])
+            << imgutils::SimdLevelName(simd_level) << " index " << i;
+        ASSERT_NEAR((float)fp16[i], expected[i], 1e-3)
+            << imgutils::SimdLevelName(simd_level) << " index " << i;
+      }
+    }
+  }
+}
+
+} // namespace
+
+TEST(BlobKernels, HwcToChw_C3) {
+  // 宽度不是 16 的倍数, 覆盖 SIMD 实现的尾部
+  for (auto size : {cv::Size(15, 3), cv::Size(37, 29), cv::Size(640, 640)}) {
+    cv::Mat img(size, CV_8UC3);
+    cv::randu(img, cv::Scalar::all(0), cv::Scalar::all(256));
+    CheckAllSimdLevels(img);
+  }
+}
+
+TEST(BlobKernels, HwcToChw_C1) {
+  for (auto size : {cv::Size(15, 3), cv::Size(37, 29), cv::Size(640, 640)}) {
+    cv::Mat img(size, CV_8UC1);
+    cv::randu(img, cv::Scalar::all(0), cv::Scalar::all(256));
+    CheckAllSimdLevels(img);
+  }
+}
+
+TEST(BlobKernels, HwcToChw_Roi) {
+  cv::Mat img(100, 120, CV_8UC3);
+  cv::randu(img, cv::Scalar::all(0), cv::Scalar::all(256));
+  CheckAllSimdLevels(img(cv::Rect(3, 5, 97, 61)));
+}
+
+TEST(BlobKernels, HwcToChw_InvalidType) {
+  cv::Mat img(8, 8, CV_32FC3);
+  std::vector<float> blob(3 * 64);
+  EXPECT_THROW(imgutils::HwcToChw(img, blob.data(), 1.0f), std::runtime_error);
+}
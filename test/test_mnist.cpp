@@ -1,8 +1,21 @@
 #include "inference/onnxruntime/onnxruntime.h"
+#include "inference/onnxruntime/onnxruntime_engine_group.h"
+#include "inference/onnxruntime/onnxruntime_profile.h"
+#include "inference/pool/engine_pool.h"
 #include <cpptoolkit/log/log.h>
+#include <cpptoolkit/strings/to_string.h>
 #include "modelzoo/common/img_common.hpp"
 #include <gtest/gtest.h>
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+#include <unistd.h>
+
 namespace {
 
 const std::string fp32_model_path = "modelzoo/mnist/mnist.onnx";
@@ -42,6 +55,625 @@ void RunMnistModel(const std::string &model_path,
   ASSERT_TRUE(max_index == 0) << "classify result error: " << max_index;
 }
 
+// Init 之前和 Init 失败之后, 默认上下文上的接口返回错误而不是崩溃
+void RunMnistModelNotReady(const std::string &model_path,
+                           inference::DeviceType device_type) {
+  auto check_not_ready = [](inference::OnnxRuntimeEngine &engine) {
+    EXPECT_FALSE(engine.IsReady());
+    EXPECT_NE(engine.Warmup(), 0);
+    EXPECT_NE(engine.Run(), 0);
+    EXPECT_TRUE(engine.GetInputTensors().empty());
+    EXPECT_TRUE(engine.GetOutputTensors().empty());
+    EXPECT_EQ(engine.GetInputTensor(0).p, nullptr);
+    EXPECT_EQ(engine.GetOutputTensor(0).p, nullptr);
+    float data[10] = {};
+    EXPECT_NE(engine.BindOutput("linear_2", data, {1, 10}, inference::kFP32),
+              0);
+  };
+
+  ::inference::OnnxRuntimeEngine engine;
+  check_not_ready(engine);
+
+  auto params = inference::GetDefaultOnnxRuntimeEngineParams();
+  params.device_type = device_type;
+  params.model_path = model_path + ".not_exist";
+  ASSERT_NE(engine.Init(params), 0);
+  check_not_ready(engine);
+}
+
+void RunMnistModelMultiContext(const std::string &model_path,
+                               inference::DeviceType device_type,
+                               int thread_num) {
+  cv::Mat img = cv::imread(test_img_path);
+  ASSERT_FALSE(img.empty()) << "Failed to read image: " << test_img_path;
+  cv::cvtColor(img, img, cv::COLOR_BGR2GRAY);
+
+  auto params = inference::GetDefaultOnnxRuntimeEngineParams();
+  params.device_type = device_type;
+  params.model_path = model_path;
+
+  ::inference::OnnxRuntimeEngine engine;
+  int ret = engine.Init(params);
+  ASSERT_TRUE(ret == 0) << "Failed to init engine: " << ret;
+
+  std::atomic<int> error_cnt = 0;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < thread_num; t++) {
+    threads.emplace_back([&]() {
+      auto ctx = engine.CreateExecContext();
+      if (!ctx) {
+        error_cnt++;
+        return;
+      }
+      auto input_tensor = ctx->GetInputTensors().at("x");
+      imgutils::BlobNormalizeFromImage(img, input_tensor.p,
+                                       input_tensor.data_type);
+      for (int i = 0; i < 10; i++) {
+        if (ctx->Run() != 0) {
+          error_cnt++;
+          continue;
+        }
+        auto output_tensor = ctx->GetOutputTensors().at("linear_2");
+        int max_idx = imgutils::GetMaxFromSoftmax(
+            output_tensor.p, output_tensor.mem_size, output_tensor.data_type);
+        if (max_idx != 0) {
+          error_cnt++;
+        }
+      }
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  ASSERT_EQ(error_cnt.load(), 0) << "multi context run failed";
+}
+
+void RunMnistModelAsync(const std::string &model_path,
+                        inference::DeviceType device_type) {
+  cv::Mat img = cv::imread(test_img_path);
+  ASSERT_FALSE(img.empty()) << "Failed to read image: " << test_img_path;
+  cv::cvtColor(img, img, cv::COLOR_BGR2GRAY);
+
+  auto params = inference::GetDefaultOnnxRuntimeEngineParams();
+  params.device_type = device_type;
+  params.model_path = model_path;
+
+  ::inference::OnnxRuntimeEngine engine;
+  int ret = engine.Init(params);
+  ASSERT_TRUE(ret == 0) << "Failed to init engine: " << ret;
+
+  auto input_tensor = engine.GetInputTensors().at("x");
+  imgutils::BlobNormalizeFromImage(img, input_tensor.p, input_tensor.data_type);
+
+  auto future = engine.RunAsync();
+  ASSERT_TRUE(future.get() == 0) << "Failed to run engine async";
+
+  std::promise<int> done;
+  engine.RunAsync(-1, [&done](int ret) { done.set_value(ret); });
+  ASSERT_TRUE(done.get_future().get() == 0) << "Failed to run engine async";
+
+  auto output_tensor = engine.GetOutputTensors().at("linear_2");
+  int max_idx = imgutils::GetMaxFromSoftmax(
+      output_tensor.p, output_tensor.mem_size, output_tensor.data_type);
+  ASSERT_TRUE(max_idx == 0) << "classify result error: " << max_idx;
+}
+
+void RunMnistModelAsyncPending(const std::string &model_path,
+                               inference::DeviceType device_type) {
+  auto params = inference::GetDefaultOnnxRuntimeEngineParams();
+  params.device_type = device_type;
+  params.model_path = model_path;
+  params.async_thread_num = 1;
+
+  ::inference::OnnxRuntimeEngine engine;
+  int ret = engine.Init(params);
+  ASSERT_TRUE(ret == 0) << "Failed to init engine: " << ret;
+
+  // 唯一的工作线程阻塞在回调中, 之后提交的推理都在排队
+  std::promise<void> release;
+  auto released = release.get_future().share();
+  auto blocking_ctx = engine.CreateExecContext();
+  blocking_ctx->RunAsync(-1, [released](int) { released.wait(); });
+
+  // 同一个上下文同时只能有一个未完成的异步推理
+  auto future = engine.RunAsync();
+  EXPECT_EQ(engine.RunAsync().get(), -1);
+
+  auto pending_ctx = engine.CreateExecContext();
+  auto pending_future = pending_ctx->RunAsync();
+  std::thread releaser([&release]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    release.set_value();
+  });
+  // 上下文销毁时等待排队中的推理执行完成
+  pending_ctx.reset();
+  releaser.join();
+  EXPECT_EQ(pending_future.get(), 0);
+  EXPECT_EQ(future.get(), 0);
+
+  // 完成之后可以再次提交
+  EXPECT_EQ(engine.RunAsync().get(), 0);
+}
+
+// 缓存目录中的文件, 包括没有重命名的临时文件
+std::vector<std::filesystem::path>
+ListCacheFiles(const std::filesystem::path &dir) {
+  std::vector<std::filesystem::path> files;
+  for (auto &entry : std::filesystem::directory_iterator(dir)) {
+    files.push_back(entry.path());
+  }
+  return files;
+}
+
+void RunMnistModelOptimizedCache(const std::string &model_path,
+                                 inference::DeviceType device_type) {
+  cv::Mat img = cv::imread(test_img_path);
+  ASSERT_FALSE(img.empty()) << "Failed to read image: " << test_img_path;
+  cv::cvtColor(img, img, cv::COLOR_BGR2GRAY);
+
+  auto cache_dir =
+      std::filesystem::temp_directory_path() / "mnist_optimized_model_cache";
+  std::filesystem::remove_all(cache_dir);
+
+  auto params = inference::GetDefaultOnnxRuntimeEngineParams();
+  params.device_type = device_type;
+  params.model_path = model_path;
+  params.graph_optimize_level = 99;
+  params.optimized_model_cache_dir = cache_dir.string();
+
+  // 第一次 Init 没有命中, 写入缓存
+  ::inference::OnnxRuntimeEngine engine;
+  ASSERT_EQ(engine.Init(params), 0);
+  auto files = ListCacheFiles(cache_dir);
+  ASSERT_EQ(files.size(), 1u);
+  ASSERT_EQ(files[0].extension(), ".onnx");
+  auto cache_time = std::filesystem::last_write_time(files[0]);
+
+  // 第二次 Init 命中, 直接加载缓存, 不再重写
+  engine.Deinit();
+  ASSERT_EQ(engine.Init(params), 0);
+  ASSERT_EQ(ListCacheFiles(cache_dir), files);
+  ASSERT_EQ(std::filesystem::last_write_time(files[0]), cache_time);
+
+  const auto &input_tensor = engine.GetInputTensor(engine.GetInputHandle("x"));
+  imgutils::BlobNormalizeFromImage(img, input_tensor.p, input_tensor.data_type);
+  ASSERT_TRUE(engine.Run() == 0) << "Failed to run engine";
+  const auto &output_tensor =
+      engine.GetOutputTensor(engine.GetOutputHandle("linear_2"));
+  int max_idx = imgutils::GetMaxFromSoftmax(
+      output_tensor.p, output_tensor.mem_size, output_tensor.data_type);
+  ASSERT_TRUE(max_idx == 0) << "classify result error: " << max_idx;
+
+  // key 按内容计算, 复制到其他目录的同名模型命中同一个缓存
+  engine.Deinit();
+  auto copy_dir = cache_dir.parent_path() / "mnist_optimized_model_copy";
+  std::filesystem::create_directories(copy_dir);
+  auto copy_path = copy_dir / std::filesystem::path(model_path).filename();
+  std::filesystem::copy_file(
+      model_path, copy_path,
+      std::filesystem::copy_options::overwrite_existing);
+  auto copy_params = params;
+  copy_params.model_path = copy_path.string();
+  ASSERT_EQ(engine.Init(copy_params), 0);
+  ASSERT_EQ(ListCacheFiles(cache_dir), files);
+  engine.Deinit();
+  std::filesystem::remove_all(copy_dir);
+
+  // 损坏的缓存加载失败后删除, 从原始模型重新生成
+  {
+    std::ofstream corrupt(files[0], std::ios::binary | std::ios::trunc);
+    corrupt << "not a model";
+  }
+  ASSERT_EQ(engine.Init(params), 0);
+  ASSERT_EQ(ListCacheFiles(cache_dir), files);
+  ASSERT_GT(std::filesystem::file_size(files[0]), 11u);
+  ASSERT_EQ(engine.Run(), 0);
+
+  // 优化等级是 key 的一部分
+  engine.Deinit();
+  params.graph_optimize_level = 1;
+  ASSERT_EQ(engine.Init(params), 0);
+  ASSERT_EQ(ListCacheFiles(cache_dir).size(), 2u);
+
+  engine.Deinit();
+  std::filesystem::remove_all(cache_dir);
+}
+
+void RunMnistModelSharedEnv(const std::string &model_path,
+                            inference::DeviceType device_type) {
+  auto params = inference::GetDefaultOnnxRuntimeEngineParams();
+  params.device_type = device_type;
+  params.model_path = model_path;
+
+  // 第一个 engine 创建不使用全局线程池的 Ort::Env
+  ::inference::OnnxRuntimeEngine engine;
+  ASSERT_EQ(engine.Init(params), 0);
+
+  // 之后的 engine 共享这个 Env, 要求全局线程池时 Init 失败
+  auto global_params = params;
+  global_params.use_global_thread_pool = true;
+  ::inference::OnnxRuntimeEngine global_engine;
+  ASSERT_NE(global_engine.Init(global_params), 0);
+  ASSERT_FALSE(global_engine.IsReady());
+
+  ::inference::OnnxRuntimeEngine other_engine;
+  ASSERT_EQ(other_engine.Init(params), 0);
+  ASSERT_EQ(other_engine.Run(), 0);
+
+  // 所有 engine 释放后 Env 随之销毁, 可以重新按全局线程池创建
+  engine.Deinit();
+  other_engine.Deinit();
+  ASSERT_EQ(global_engine.Init(global_params), 0);
+  ASSERT_EQ(global_engine.Run(), 0);
+
+  // 全局线程数不一致时同样失败
+  global_params.global_intra_op_num_threads = 3;
+  ::inference::OnnxRuntimeEngine conflict_engine;
+  ASSERT_NE(conflict_engine.Init(global_params), 0);
+}
+
+void RunMnistModelSharedMmap(const std::string &model_path,
+                             inference::DeviceType device_type,
+                             int engine_num) {
+  cv::Mat img = cv::imread(test_img_path);
+  ASSERT_FALSE(img.empty()) << "Failed to read image: " << test_img_path;
+  cv::cvtColor(img, img, cv::COLOR_BGR2GRAY);
+
+  auto params = inference::GetDefaultOnnxRuntimeEngineParams();
+  params.device_type = device_type;
+  params.model_path = model_path;
+  params.model_load_mode = inference::kModelLoadSharedMmap;
+
+  std::vector<std::unique_ptr<inference::OnnxRuntimeEngine>> engines;
+  for (int i = 0; i < engine_num; i++) {
+    auto engine = std::make_unique<inference::OnnxRuntimeEngine>();
+    int ret = engine->Init(params);
+    ASSERT_TRUE(ret == 0) << "Failed to init engine: " << ret;
+    engines.push_back(std::move(engine));
+  }
+
+  // 所有 engine 共享同一份映射
+  auto mapping = inference::MappedFile::OpenShared(model_path);
+  ASSERT_TRUE(mapping != nullptr) << "Failed to map model: " << model_path;
+  ASSERT_EQ(mapping.use_count(), engine_num + 1);
+
+  for (auto &engine : engines) {
+    auto input_tensor = engine->GetInputTensors().at("x");
+    imgutils::BlobNormalizeFromImage(img, input_tensor.p,
+                                     input_tensor.data_type);
+    ASSERT_TRUE(engine->Run() == 0) << "Failed to run engine";
+    auto output_tensor = engine->GetOutputTensors().at("linear_2");
+    int max_idx = imgutils::GetMaxFromSoftmax(
+        output_tensor.p, output_tensor.mem_size, output_tensor.data_type);
+    ASSERT_TRUE(max_idx == 0) << "classify result error: " << max_idx;
+  }
+}
+
+void RunMnistModelGroup(const std::string &model_path,
+                        inference::DeviceType device_type, int engine_num) {
+  cv::Mat img = cv::imread(test_img_path);
+  ASSERT_FALSE(img.empty()) << "Failed to read image: " << test_img_path;
+  cv::cvtColor(img, img, cv::COLOR_BGR2GRAY);
+
+  auto params = inference::GetDefaultOnnxRuntimeEngineParams();
+  params.device_type = device_type;
+  params.model_path = model_path;
+
+  inference::OnnxRuntimeEngineGroup group;
+  int ret = group.Init(params, engine_num);
+  ASSERT_TRUE(ret == 0) << "Failed to init engine group: " << ret;
+  ASSERT_EQ(group.Size(), engine_num);
+  ASSERT_TRUE(group.GetEngine(engine_num) == nullptr);
+
+  for (int i = 0; i < group.Size(); i++) {
+    auto *engine = group.GetEngine(i);
+    auto input_tensor = engine->GetInputTensors().at("x");
+    imgutils::BlobNormalizeFromImage(img, input_tensor.p,
+                                     input_tensor.data_type);
+    ASSERT_TRUE(engine->Run() == 0) << "Failed to run engine " << i;
+    auto output_tensor = engine->GetOutputTensors().at("linear_2");
+    int max_idx = imgutils::GetMaxFromSoftmax(
+        output_tensor.p, output_tensor.mem_size, output_tensor.data_type);
+    ASSERT_TRUE(max_idx == 0) << "classify result error: " << max_idx;
+  }
+}
+
+// 进程的常驻内存, 读取失败返回 0
+int64_t GetResidentBytes() {
+  std::ifstream statm("/proc/self/statm");
+  int64_t total = 0, resident = 0;
+  if (!(statm >> total >> resident)) {
+    return 0;
+  }
+  return resident * sysconf(_SC_PAGESIZE);
+}
+
+// group 中的 engine 共享 initializer 和预处理后的权重, 增加 engine 不再
+// 增加一份权重的常驻内存
+void RunMnistModelGroupMemory(const std::string &model_path,
+                              inference::DeviceType device_type) {
+  if (GetResidentBytes() == 0) {
+    GTEST_SKIP() << "resident memory is not available";
+  }
+  auto params = inference::GetDefaultOnnxRuntimeEngineParams();
+  params.device_type = device_type;
+  params.model_path = model_path;
+
+  auto init_group = [&](inference::OnnxRuntimeEngineGroup &group,
+                        int engine_num) {
+    ASSERT_EQ(group.Init(params, engine_num), 0);
+    for (int i = 0; i < group.Size(); i++) {
+      ASSERT_EQ(group.GetEngine(i)->Run(), 0);
+    }
+  };
+
+  // Ort::Env 和共享 arena 的创建不计入
+  inference::OnnxRuntimeEngineGroup warmup;
+  init_group(warmup, 1);
+
+  constexpr int kEngineNum = 8;
+  int64_t base = GetResidentBytes();
+  inference::OnnxRuntimeEngineGroup one;
+  init_group(one, 1);
+  int64_t one_bytes = GetResidentBytes() - base;
+
+  base = GetResidentBytes();
+  inference::OnnxRuntimeEngineGroup many;
+  init_group(many, kEngineNum);
+  int64_t many_bytes = GetResidentBytes() - base;
+
+  // 不共享时每个 engine 至少多一份权重
+  int64_t model_size = (int64_t)std::filesystem::file_size(model_path);
+  int64_t per_engine = (many_bytes - one_bytes) / (kEngineNum - 1);
+  LOG_INFO("engine group resident bytes, one: {}, {}: {}, per engine: {}, "
+           "model size: {}",
+           one_bytes, kEngineNum, many_bytes, per_engine, model_size);
+  EXPECT_LT(per_engine, model_size / 4);
+}
+
+void RunMnistModelPool(const std::string &model_path,
+                       inference::DeviceType device_type, int instance_num) {
+  cv::Mat img = cv::imread(test_img_path);
+  ASSERT_FALSE(img.empty()) << "Failed to read image: " << test_img_path;
+  cv::cvtColor(img, img, cv::COLOR_BGR2GRAY);
+
+  auto params = inference::GetDefaultOnnxRuntimeEngineParams();
+  params.device_type = device_type;
+  params.model_path = model_path;
+
+  inference::EnginePoolParams pool_params;
+  pool_params.instance_num = instance_num;
+
+  inference::EnginePool pool;
+  int ret = pool.Init(params, pool_params);
+  ASSERT_TRUE(ret == 0) << "Failed to init engine pool: " << ret;
+  ASSERT_EQ(pool.InstanceNum(), instance_num);
+  ASSERT_FALSE(pool.GetInstanceCpus(0).empty());
+
+  std::vector<std::future<int>> futures;
+  for (int i = 0; i < instance_num * 4; i++) {
+    futures.push_back(pool.Submit([&img](inference::InferenceEngine *engine) {
+      auto input_tensor = engine->GetInputTensors().at("x");
+      imgutils::BlobNormalizeFromImage(img, input_tensor.p,
+                                       input_tensor.data_type);
+      if (engine->Run() != 0) {
+        return -1;
+      }
+      auto output_tensor = engine->GetOutputTensors().at("linear_2");
+      return imgutils::GetMaxFromSoftmax(
+          output_tensor.p, output_tensor.mem_size, output_tensor.data_type);
+    }));
+  }
+  for (auto &future : futures) {
+    int max_idx = future.get();
+    ASSERT_TRUE(max_idx == 0) << "classify result error: " << max_idx;
+  }
+}
+
+void RunMnistModelStats(const std::string &model_path,
+                        inference::DeviceType device_type) {
+  auto params = inference::GetDefaultOnnxRuntimeEngineParams();
+  params.device_type = device_type;
+  params.model_path = model_path;
+
+  ::inference::OnnxRuntimeEngine engine;
+  int ret = engine.Init(params);
+  ASSERT_TRUE(ret == 0) << "Failed to init engine: " << ret;
+  ASSERT_TRUE(engine.Warmup() == 0);
+  ASSERT_EQ(engine.GetStats().run_count, 0u);
+
+  const uint64_t run_num = 5;
+  for (uint64_t i = 0; i < run_num; i++) {
+    ASSERT_TRUE(engine.Run() == 0) << "Failed to run engine";
+  }
+  auto ctx = engine.CreateExecContext();
+  ASSERT_TRUE(ctx->Run() == 0);
+
+  size_t io_bytes = 0;
+  for (auto &[name, tensor] : engine.GetInputTensors()) {
+    io_bytes += tensor.mem_size;
+  }
+  for (auto &[name, tensor] : engine.GetOutputTensors()) {
+    io_bytes += tensor.mem_size;
+  }
+
+  auto stats = engine.GetStats();
+  LOG_INFO("{}", cpptoolkit::ToString(stats));
+  ASSERT_EQ(stats.run_count, run_num + 1);
+  ASSERT_EQ(stats.failed_count, 0u);
+  ASSERT_EQ(stats.run.count, run_num + 1);
+  ASSERT_LE(stats.total.p50_us, stats.total.p99_us);
+  ASSERT_LE(stats.total.p99_us, stats.total.max_us);
+  ASSERT_GT(stats.total.max_us, 0);
+  ASSERT_DOUBLE_EQ(stats.bound_bytes_per_run, io_bytes);
+
+  engine.ResetStats();
+  ASSERT_EQ(engine.GetStats().run_count, 0u);
+}
+
+void RunMnistModelProfile(const std::string &model_path,
+                          inference::DeviceType device_type) {
+  auto params = inference::GetDefaultOnnxRuntimeEngineParams();
+  params.device_type = device_type;
+  params.model_path = model_path;
+  params.enable_profiling = true;
+  params.profile_prefix = "mnist_profile";
+
+  ::inference::OnnxRuntimeEngine engine;
+  int ret = engine.Init(params);
+  ASSERT_TRUE(ret == 0) << "Failed to init engine: " << ret;
+
+  const int run_num = 3;
+  for (int i = 0; i < run_num; i++) {
+    ASSERT_TRUE(engine.Run() == 0) << "Failed to run engine";
+  }
+  auto profile_files = engine.EndProfiling();
+  ASSERT_EQ(profile_files.size(), 1u);
+  ASSERT_TRUE(engine.EndProfiling().empty());
+
+  inference::ProfileSummary summary;
+  ret = inference::ParseOnnxRuntimeProfile(profile_files, &summary);
+  ASSERT_TRUE(ret == 0) << "Failed to parse profile: " << profile_files[0];
+  LOG_INFO("{}", inference::DumpProfileSummary(summary));
+  ASSERT_EQ(summary.run_count, run_num);
+  ASSERT_FALSE(summary.op_types.empty());
+  ASSERT_FALSE(summary.nodes.empty());
+  for (auto &node : summary.nodes) {
+    ASSERT_EQ(node.count % run_num, 0) << node.name;
+  }
+
+  for (auto &file : profile_files) {
+    std::filesystem::remove(file);
+  }
+}
+
+void RunMnistModelTensorHandle(const std::string &model_path,
+                               inference::DeviceType device_type) {
+  cv::Mat img = cv::imread(test_img_path);
+  ASSERT_FALSE(img.empty()) << "Failed to read image: " << test_img_path;
+  cv::cvtColor(img, img, cv::COLOR_BGR2GRAY);
+
+  auto params = inference::GetDefaultOnnxRuntimeEngineParams();
+  params.device_type = device_type;
+  params.model_path = model_path;
+
+  ::inference::OnnxRuntimeEngine engine;
+  int ret = engine.Init(params);
+  ASSERT_TRUE(ret == 0) << "Failed to init engine: " << ret;
+
+  auto input_handle = engine.GetInputHandle("x");
+  auto output_handle = engine.GetOutputHandle("linear_2");
+  ASSERT_NE(input_handle, inference::kInvalidTensorHandle);
+  ASSERT_NE(output_handle, inference::kInvalidTensorHandle);
+  ASSERT_EQ(engine.GetInputHandle("not_exist"),
+            inference::kInvalidTensorHandle);
+  ASSERT_TRUE(engine.GetInputTensor(inference::kInvalidTensorHandle).p ==
+              nullptr);
+
+  // 句柄返回的引用在多次推理之间保持不变
+  const auto &input_tensor = engine.GetInputTensor(input_handle);
+  const auto &output_tensor = engine.GetOutputTensor(output_handle);
+  ASSERT_EQ(input_tensor.p, engine.GetInputTensors().at("x").p);
+  ASSERT_EQ(output_tensor.p, engine.GetOutputTensors().at("linear_2").p);
+  for (int i = 0; i < 3; i++) {
+    imgutils::BlobNormalizeFromImage(img, input_tensor.p,
+                                     input_tensor.data_type);
+    ASSERT_TRUE(engine.Run() == 0) << "Failed to run engine";
+    ASSERT_EQ(&output_tensor, &engine.GetOutputTensor(output_handle));
+    int max_idx = imgutils::GetMaxFromSoftmax(
+        output_tensor.p, output_tensor.mem_size, output_tensor.data_type);
+    ASSERT_TRUE(max_idx == 0) << "classify result error: " << max_idx;
+  }
+}
+
+void RunMnistModelOrtAllocatedOutputs(const std::string &model_path,
+                                      inference::DeviceType device_type) {
+  cv::Mat img = cv::imread(test_img_path);
+  ASSERT_FALSE(img.empty()) << "Failed to read image: " << test_img_path;
+  cv::cvtColor(img, img, cv::COLOR_BGR2GRAY);
+
+  auto params = inference::GetDefaultOnnxRuntimeEngineParams();
+  params.device_type = device_type;
+  params.model_path = model_path;
+  params.ort_allocated_outputs = {"linear_2"};
+
+  ::inference::OnnxRuntimeEngine engine;
+  int ret = engine.Init(params);
+  ASSERT_TRUE(ret == 0) << "Failed to init engine: " << ret;
+
+  auto output_handle = engine.GetOutputHandle("linear_2");
+  const auto &output_tensor = engine.GetOutputTensor(output_handle);
+  // 推理之前 onnxruntime 还没有分配输出
+  ASSERT_TRUE(output_tensor.p == nullptr);
+
+  const auto &input_tensor = engine.GetInputTensor(engine.GetInputHandle("x"));
+  imgutils::BlobNormalizeFromImage(img, input_tensor.p, input_tensor.data_type);
+  for (int i = 0; i < 2; i++) {
+    ASSERT_TRUE(engine.Run() == 0) << "Failed to run engine";
+    ASSERT_TRUE(output_tensor.p != nullptr);
+    ASSERT_EQ(output_tensor.shape, (inference::TensorShape{1, 10}));
+    ASSERT_EQ(output_tensor.mem_size, (int64_t)(10 * sizeof(float)));
+    ASSERT_TRUE(output_tensor.p_arr.empty());
+    int max_idx = imgutils::GetMaxFromSoftmax(
+        output_tensor.p, output_tensor.mem_size, output_tensor.data_type);
+    ASSERT_TRUE(max_idx == 0) << "classify result error: " << max_idx;
+  }
+
+  // onnxruntime 分配的输出不能绑定调用方的 buffer
+  std::array<float, 10> output = {};
+  ASSERT_NE(engine.BindOutput("linear_2", output.data(), {1, 10},
+                              inference::kFP32),
+            0);
+}
+
+void RunMnistModelBindBuffer(const std::string &model_path,
+                             inference::DeviceType device_type) {
+  cv::Mat img = cv::imread(test_img_path);
+  ASSERT_FALSE(img.empty()) << "Failed to read image: " << test_img_path;
+  cv::cvtColor(img, img, cv::COLOR_BGR2GRAY);
+
+  auto params = inference::GetDefaultOnnxRuntimeEngineParams();
+  params.device_type = device_type;
+  params.model_path = model_path;
+
+  ::inference::OnnxRuntimeEngine engine;
+  int ret = engine.Init(params);
+  ASSERT_TRUE(ret == 0) << "Failed to init engine: " << ret;
+
+  std::vector<float> input(28 * 28);
+  std::array<float, 10> output = {};
+  imgutils::BlobNormalizeFromImage(img, input.data(), inference::kFP32);
+
+  // 数据类型, shape, 对齐不匹配时绑定失败
+  ASSERT_NE(engine.BindInput("x", input.data(), {1, 1, 28, 28},
+                             inference::kFP16),
+            0);
+  ASSERT_NE(engine.BindInput("x", input.data(), {1, 1, 28, 27},
+                             inference::kFP32),
+            0);
+  ASSERT_NE(engine.BindInput("x", (char *)input.data() + 1, {1, 1, 28, 28},
+                             inference::kFP32),
+            0);
+
+  ASSERT_EQ(engine.BindInput("x", input.data(), {1, 1, 28, 28},
+                             inference::kFP32),
+            0);
+  ASSERT_EQ(engine.BindOutput("linear_2", output.data(), {1, 10},
+                              inference::kFP32),
+            0);
+  ASSERT_TRUE(engine.Run() == 0) << "Failed to run engine";
+
+  auto output_handle = engine.GetOutputHandle("linear_2");
+  ASSERT_EQ(engine.GetOutputTensor(output_handle).p, (void *)output.data());
+  int max_idx =
+      imgutils::GetMaxFromSoftmax(output.data(), output.size() * sizeof(float),
+                                  inference::kFP32);
+  ASSERT_TRUE(max_idx == 0) << "classify result error: " << max_idx;
+
+  engine.ClearBindings();
+  ASSERT_NE(engine.GetOutputTensor(output_handle).p, (void *)output.data());
+}
+
 } // namespace
 
 TEST(Mnist, CPU_FP32) { RunMnistModel(fp32_model_path, inference::kCPU); }
@@ -51,3 +683,63 @@ TEST(Mnist, CPU_FP16) { RunMnistModel(fp16_model_path, inference::kCPU); }
 TEST(Mnist, GPU_FP32) { RunMnistModel(fp32_model_path, inference::kGPU); }
 
 TEST(Mnist, GPU_FP16) { RunMnistModel(fp16_model_path, inference::kGPU); }
+
+TEST(Mnist, CPU_FP32_NotReady) {
+  RunMnistModelNotReady(fp32_model_path, inference::kCPU);
+}
+
+TEST(Mnist, CPU_FP32_MultiContext) {
+  RunMnistModelMultiContext(fp32_model_path, inference::kCPU, 4);
+}
+
+TEST(Mnist, CPU_FP32_RunAsync) {
+  RunMnistModelAsync(fp32_model_path, inference::kCPU);
+}
+
+TEST(Mnist, CPU_FP32_RunAsyncPending) {
+  RunMnistModelAsyncPending(fp32_model_path, inference::kCPU);
+}
+
+TEST(Mnist, CPU_FP32_OptimizedModelCache) {
+  RunMnistModelOptimizedCache(fp32_model_path, inference::kCPU);
+}
+
+TEST(Mnist, CPU_FP32_SharedEnv) {
+  RunMnistModelSharedEnv(fp32_model_path, inference::kCPU);
+}
+
+TEST(Mnist, CPU_FP32_SharedMmap) {
+  RunMnistModelSharedMmap(fp32_model_path, inference::kCPU, 3);
+}
+
+TEST(Mnist, CPU_FP32_EngineGroup) {
+  RunMnistModelGroup(fp32_model_path, inference::kCPU, 3);
+}
+
+TEST(Mnist, CPU_FP32_EngineGroupMemory) {
+  RunMnistModelGroupMemory(fp32_model_path, inference::kCPU);
+}
+
+TEST(Mnist, CPU_FP32_TensorHandle) {
+  RunMnistModelTensorHandle(fp32_model_path, inference::kCPU);
+}
+
+TEST(Mnist, CPU_FP32_BindBuffer) {
+  RunMnistModelBindBuffer(fp32_model_path, inference::kCPU);
+}
+
+TEST(Mnist, CPU_FP32_OrtAllocatedOutputs) {
+  RunMnistModelOrtAllocatedOutputs(fp32_model_path, inference::kCPU);
+}
+
+TEST(Mnist, CPU_FP32_EnginePool) {
+  RunMnistModelPool(fp32_model_path, inference::kCPU, 2);
+}
+
+TEST(Mnist, CPU_FP32_Stats) {
+  RunMnistModelStats(fp32_model_path, inference::kCPU);
+}
+
+TEST(Mnist, CPU_FP32_Profile) {
+  RunMnistModelProfile(fp32_model_path, inference::kCPU);
+}
@@ -1,3 +1,4 @@
+#include "inference/batcher/dynamic_batcher.h"
 #include "inference/onnxruntime/onnxruntime.h"
 #include <cpptoolkit/exception/exception.h>
 #include <cpptoolkit/log/log.h>
@@ -8,6 +9,7 @@
 
 #include <filesystem>
 #include <regex>
+#include <thread>
 #include <vector>
 
 namespace fs = std::filesystem;
@@ -300,3 +302,118 @@ void RunMnistBatch(const std::string &model_path,
 TEST(Mnist_Batch32, GPU_FP32) {
   RunMnistBatch(fp32_model_path, inference::kGPU, 32);
 }
+
+namespace {
+
+void RunMnistDynamicBatcher(const std::string &model_path,
+                            inference::DeviceType device_type,
+                            int thread_num) {
+  auto samples = PrepareTestImgSamples();
+  ASSERT_TRUE(!samples.empty()) << "No test samples";
+
+  auto params = inference::GetDefaultOnnxRuntimeEngineParams();
+  params.device_type = device_type;
+  params.model_path = model_path;
+  params.max_batch_size = 8;
+
+  inference::OnnxRuntimeEngine engine;
+  int ret = engine.Init(params);
+  ASSERT_TRUE(ret == 0) << "Failed to init engine: " << ret;
+
+  // 先逐个样本推理得到参考结果
+  for (auto &sample : samples) {
+    auto i_tensor = engine.GetInputTensors().at("input");
+    imgutils::BlobNormalizeFromImage(sample.img_data, i_tensor.p_arr[0],
+                                     i_tensor.data_type);
+    ret = engine.Run(1);
+    ASSERT_TRUE(ret == 0) << "Failed to run engine: " << ret;
+    auto o_tensor = engine.GetOutputTensors().at("output");
+    sample.result_idx = imgutils::GetMaxFromSoftmax(
+        o_tensor.p_arr[0], o_tensor.mem_size, o_tensor.data_type);
+  }
+
+  inference::DynamicBatcher batcher;
+  ret = batcher.Init(&engine, {8, 2000});
+  ASSERT_TRUE(ret == 0) << "Failed to init batcher: " << ret;
+
+  std::atomic<int> error_cnt = 0;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < thread_num; t++) {
+    threads.emplace_back([&, t]() {
+      for (int i = t; i < samples.size(); i += thread_num) {
+        auto &sample = samples[i];
+        int max_idx = -1;
+        auto future = batcher.Submit(
+            [&](const inference::InputTensorPointers &inputs) {
+              auto &i_tensor = inputs.at("input");
+              imgutils::BlobNormalizeFromImage(sample.img_data, i_tensor.p,
+                                               i_tensor.data_type);
+              return 0;
+            },
+            [&](const inference::OutputTensorPointers &outputs) {
+              auto &o_tensor = outputs.at("output");
+              max_idx = imgutils::GetMaxFromSoftmax(
+                  o_tensor.p, o_tensor.mem_size, o_tensor.data_type);
+            });
+        if (future.get() != 0 || max_idx != sample.result_idx) {
+          LOG_ERROR("sample:{} max_idx:{}", ToString(sample), max_idx);
+          error_cnt++;
+        }
+      }
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  ASSERT_EQ(error_cnt.load(), 0) << "dynamic batcher result error";
+}
+
+} // namespace
+
+TEST(Mnist_DynamicBatcher, CPU_FP32) {
+  RunMnistDynamicBatcher(fp32_model_path, inference::kCPU, 8);
+}
+
+namespace {
+
+void RunMnistBatchBuckets(const std::string &model_path,
+                          inference::DeviceType device_type,
+                          int max_batch_size) {
+  auto samples = PrepareTestImgSamples();
+  ASSERT_TRUE(!samples.empty()) << "No test samples";
+
+  auto params = inference::GetDefaultOnnxRuntimeEngineParams();
+  params.device_type = device_type;
+  params.model_path = model_path;
+  params.max_batch_size = max_batch_size;
+  {
+    MnistDynamic mnist;
+    mnist.Init(params);
+    for (auto &sample : samples) {
+      sample.result_idx = mnist.Classify({sample.img_data}, 1)[0];
+    }
+  }
+
+  params.batch_buckets = {1, 2, 4};
+  MnistDynamic mnist;
+  mnist.Init(params);
+
+  // 每个 batch size 都路由到能容纳它的最小桶, 补 0 的位置不影响结果
+  for (int batch_size = 1; batch_size <= max_batch_size; batch_size++) {
+    std::vector<cv::Mat> imgs;
+    for (int i = 0; i < batch_size; i++) {
+      imgs.push_back(samples[i % samples.size()].img_data);
+    }
+    auto max_idxs = mnist.Classify(imgs, batch_size);
+    for (int i = 0; i < batch_size; i++) {
+      ASSERT_EQ(max_idxs[i], samples[i % samples.size()].result_idx)
+          << "batch size: " << batch_size << ", index: " << i;
+    }
+  }
+}
+
+} // namespace
+
+TEST(Mnist_BatchBuckets, CPU_FP32) {
+  RunMnistBatchBuckets(fp32_model_path, inference::kCPU, 8);
+}
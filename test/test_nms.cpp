@@ -0,0 +1,187 @@
+#include "modelzoo/common/nms.h"
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+
+// 候选框聚集在若干个目标附近, 有大量重叠
+imgutils::NmsBoxes RandomBoxes(int num, int class_num, int seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> center(50.f, 590.f);
+  std::uniform_real_distribution<float> size(20.f, 120.f);
+  std::normal_distribution<float> jitter(0.f, 6.f);
+  std::uniform_real_distribution<float> score(0.f, 1.f);
+  int object_num = std::max(1, num / 8);
+  std::vector<cv::Vec4f> objects;
+  for (int i = 0; i < object_num; i++) {
+    objects.emplace_back(center(rng), center(rng), size(rng), size(rng));
+  }
+
+  imgutils::NmsBoxes boxes;
+  for (int i = 0; i < num; i++) {
+    const auto &o = objects[i % object_num];
+    boxes.AddCenter(o[0] + jitter(rng), o[1] + jitter(rng),
+                    o[2] + jitter(rng), o[3] + jitter(rng), score(rng),
+                    (i / object_num) % class_num);
+  }
+  return boxes;
+}
+
+// 按定义逐对计算 IoU 的贪心 NMS
+std::vector<int> NmsReference(const imgutils::NmsBoxes &boxes,
+                              const imgutils::NmsParams &params) {
+  std::vector<int> order;
+  for (int i = 0; i < (int)boxes.size(); i++) {
+    if (boxes.scores[i] > params.score_threshold) {
+      order.push_back(i);
+    }
+  }
+  std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+    return boxes.scores[a] > boxes.scores[b];
+  });
+  auto iou = [&](int a, int b) {
+    float w = std::min(boxes.x2[a], boxes.x2[b]) -
+              std::max(boxes.x1[a], boxes.x1[b]);
+    float h = std::min(boxes.y2[a], boxes.y2[b]) -
+              std::max(boxes.y1[a], boxes.y1[b]);
+    float inter = std::max(w, 0.f) * std::max(h, 0.f);
+    float area_a = (boxes.x2[a] - boxes.x1[a]) * (boxes.y2[a] - boxes.y1[a]);
+    float area_b = (boxes.x2[b] - boxes.x1[b]) * (boxes.y2[b] - boxes.y1[b]);
+    return inter / (area_a + area_b - inter);
+  };
+  std::vector<int> keep;
+  for (int i : order) {
+    bool suppressed = false;
+    for (int k : keep) {
+      bool same_class = boxes.class_ids[i] == boxes.class_ids[k];
+      if ((!params.class_aware || same_class) &&
+          iou(i, k) > params.iou_threshold) {
+        suppressed = true;
+        break;
+      }
+    }
+    if (!suppressed) {
+      keep.push_back(i);
+    }
+  }
+  return keep;
+}
+
+} // namespace
+
+TEST(Nms, MatchesReference) {
+  for (int num : {10, 100, 1000}) {
+    auto boxes = RandomBoxes(num, 5, num);
+    for (bool class_aware : {false, true}) {
+      imgutils::NmsParams params;
+      params.class_aware = class_aware;
+      auto expected = NmsReference(boxes, params);
+      ASSERT_GT(expected.size(), 0);
+      for (int level = 0; level <= (int)imgutils::GetSimdLevel(); level++) {
+        std::vector<int> keep;
+        std::vector<float> keep_scores;
+        ASSERT_EQ(imgutils::Nms(boxes, params, (imgutils::SimdLevel)level,
+                                &keep, &keep_scores),
+                  0);
+        EXPECT_EQ(keep, expected) << "num " << num << " aware "
+                                  << class_aware << " level " << level;
+        ASSERT_EQ(keep_scores.size(), keep.size());
+        for (size_t k = 0; k < keep.size(); k++) {
+          EXPECT_EQ(keep_scores[k], boxes.scores[keep[k]]);
+        }
+      }
+    }
+  }
+}
+
+TEST(Nms, ClassAware) {
+  imgutils::NmsBoxes boxes;
+  boxes.AddXYWH(10, 10, 100, 100, 0.9f, 0);
+  boxes.AddXYWH(12, 12, 100, 100, 0.8f, 1);
+  boxes.AddXYWH(14, 14, 100, 100, 0.7f, 1);
+
+  imgutils::NmsParams params;
+  std::vector<int> keep;
+  ASSERT_EQ(imgutils::Nms(boxes, params, &keep), 0);
+  EXPECT_EQ(keep, (std::vector<int>{0, 1}));
+
+  params.class_aware = false;
+  ASSERT_EQ(imgutils::Nms(boxes, params, &keep), 0);
+  EXPECT_EQ(keep, (std::vector<int>{0}));
+}
+
+TEST(Nms, TopKAndMaxOutput) {
+  imgutils::NmsBoxes boxes;
+  for (int i = 0; i < 10; i++) {
+    // 互不相交, 分数递增
+    boxes.AddXYWH(i * 20.f, 0, 10, 10, 0.3f + i * 0.05f);
+  }
+  imgutils::NmsParams params;
+  params.top_k = 3;
+  std::vector<int> keep;
+  ASSERT_EQ(imgutils::Nms(boxes, params, &keep), 0);
+  EXPECT_EQ(keep, (std::vector<int>{9, 8, 7}));
+
+  params.top_k = 0;
+  params.max_output = 2;
+  ASSERT_EQ(imgutils::Nms(boxes, params, &keep), 0);
+  EXPECT_EQ(keep, (std::vector<int>{9, 8}));
+
+  // 分数需要严格大于阈值
+  params.max_output = 0;
+  params.score_threshold = 0.5f;
+  ASSERT_EQ(imgutils::Nms(boxes, params, &keep), 0);
+  EXPECT_EQ(keep.size(), 5);
+}
+
+TEST(Nms, SoftNms) {
+  // IoU = 80 * 100 / (2 * 10000 - 8000) = 2 / 3
+  imgutils::NmsBoxes boxes;
+  boxes.AddXYWH(0, 0, 100, 100, 0.9f);
+  boxes.AddXYWH(20, 0, 100, 100, 0.8f);
+  const float iou = 2.0f / 3.0f;
+
+  imgutils::NmsParams params;
+  params.score_threshold = 0.1f;
+  params.method = imgutils::NmsMethod::kSoftGaussian;
+  std::vector<int> keep;
+  std::vector<float> keep_scores;
+  ASSERT_EQ(imgutils::Nms(boxes, params, &keep, &keep_scores), 0);
+  ASSERT_EQ(keep, (std::vector<int>{0, 1}));
+  EXPECT_FLOAT_EQ(keep_scores[1], 0.8f * std::exp(-iou * iou / 0.5f));
+
+  params.method = imgutils::NmsMethod::kSoftLinear;
+  ASSERT_EQ(imgutils::Nms(boxes, params, &keep, &keep_scores), 0);
+  ASSERT_EQ(keep, (std::vector<int>{0, 1}));
+  EXPECT_NEAR(keep_scores[1], 0.8f * (1.0f - iou), 1e-6);
+
+  // 衰减后低于阈值的框被去掉
+  params.score_threshold = 0.3f;
+  ASSERT_EQ(imgutils::Nms(boxes, params, &keep, &keep_scores), 0);
+  EXPECT_EQ(keep, (std::vector<int>{0}));
+}
+
+TEST(Nms, Batched) {
+  std::vector<imgutils::NmsBoxes> batch;
+  for (int i = 0; i < 8; i++) {
+    batch.push_back(RandomBoxes(200, 3, i));
+  }
+  imgutils::NmsParams params;
+  std::vector<std::vector<int>> expected;
+  ASSERT_EQ(imgutils::BatchedNms(nullptr, batch, params, &expected), 0);
+
+  inference::ThreadPool pool(3);
+  std::vector<std::vector<int>> keeps;
+  ASSERT_EQ(imgutils::BatchedNms(&pool, batch, params, &keeps), 0);
+  ASSERT_EQ(keeps.size(), batch.size());
+  for (size_t i = 0; i < batch.size(); i++) {
+    EXPECT_EQ(keeps[i], NmsReference(batch[i], params));
+    EXPECT_EQ(keeps[i], expected[i]);
+  }
+
+  batch[5].class_ids.pop_back();
+  EXPECT_NE(imgutils::BatchedNms(&pool, batch, params, &keeps), 0);
+}
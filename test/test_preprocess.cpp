@@ -0,0 +1,277 @@
+#include "modelzoo/common/batch_preprocess.h"
+#include "modelzoo/common/img_common.hpp"
+#include "modelzoo/common/preprocess.h"
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// 与 LetterBoxPadImage + BlobNormalizeFromImage 的结果比较
+void CheckLetterBox(const cv::Mat &img, const cv::Size &dst_size,
+                    inference::TensorDataType data_type) {
+  size_t elem_cnt = 3 * dst_size.area();
+  std::vector<float> expected(elem_cnt);
+  auto [dst_img, img_scale] = imgutils::LetterBoxPadImage(img, dst_size);
+  imgutils::BlobNormalizeFromImage(dst_img, expected.data(), data_type);
+
+  // 连续运行两次, 第二次复用缩放结果且输出中残留上一次的数据
+  imgutils::PreprocessSpec spec;
+  spec.size = dst_size;
+  spec.data_type = data_type;
+  imgutils::Preprocessor preprocessor(spec);
+  std::vector<float> blob(elem_cnt, -1.0f);
+  for (int i = 0; i < 2; i++) {
+    imgutils::PreprocessInfo info;
+    ASSERT_EQ(preprocessor.Run(img, blob.data(), &info), 0);
+    EXPECT_FLOAT_EQ(info.scale, img_scale);
+    EXPECT_EQ(info.pad, cv::Point(0, 0));
+    size_t elem_size = data_type == inference::kFP32 ? sizeof(float)
+                                                     : sizeof(half_float::half);
+    ASSERT_EQ(0, memcmp(blob.data(), expected.data(), elem_cnt * elem_size));
+  }
+}
+
+// 用 OpenCV 逐步实现的参考结果, 按 NCHW 或 NHWC 排列
+std::vector<float> Reference(const cv::Mat &img,
+                             const imgutils::PreprocessSpec &spec,
+                             const imgutils::PreprocessInfo &info) {
+  cv::Mat src = img;
+  if (spec.channels == 1 && img.channels() == 3) {
+    cv::cvtColor(img, src, cv::COLOR_BGR2GRAY);
+  }
+  cv::Mat resized;
+  cv::resize(src, resized, info.resized);
+  cv::Mat canvas(spec.size, src.type(), cv::Scalar::all(spec.pad_value));
+  resized.copyTo(canvas(cv::Rect(info.pad, info.resized)));
+  if (spec.channels == 3 && canvas.channels() == 1) {
+    cv::cvtColor(canvas, canvas, cv::COLOR_GRAY2BGR);
+  }
+  if (spec.channels == 3 && spec.to_rgb) {
+    cv::cvtColor(canvas, canvas, cv::COLOR_BGR2RGB);
+  }
+
+  int channels = spec.channels;
+  std::vector<float> blob(channels * canvas.total());
+  for (int y = 0; y < canvas.rows; y++) {
+    for (int x = 0; x < canvas.cols; x++) {
+      for (int c = 0; c < channels; c++) {
+        float v = canvas.ptr<uint8_t>(y)[x * channels + c];
+        v = (v - spec.mean[c]) / spec.stddev[c];
+        size_t pixel = (size_t)y * canvas.cols + x;
+        if (spec.layout == imgutils::TensorLayout::kNCHW) {
+          blob[c * canvas.total() + pixel] = v;
+        } else {
+          blob[pixel * channels + c] = v;
+        }
+      }
+    }
+  }
+  return blob;
+}
+
+void CheckSpec(const cv::Mat &img, const imgutils::PreprocessSpec &spec) {
+  imgutils::Preprocessor preprocessor;
+  ASSERT_EQ(preprocessor.SetSpec(spec), 0);
+  std::vector<float> blob(spec.channels * spec.size.area());
+  imgutils::PreprocessInfo info;
+  ASSERT_EQ(preprocessor.Run(img, blob.data(), &info), 0);
+  auto expected = Reference(img, spec, info);
+  for (size_t i = 0; i < blob.size(); i++) {
+    ASSERT_NEAR(blob[i], expected[i], 1e-5) << spec << " index " << i;
+  }
+}
+
+} // namespace
+
+TEST(Preprocess, LetterBox_C3) {
+  for (auto size : {cv::Size(1920, 1080), cv::Size(300, 500),
+                    cv::Size(640, 640)}) {
+    cv::Mat img(size, CV_8UC3);
+    cv::randu(img, cv::Scalar::all(0), cv::Scalar::all(256));
+    CheckLetterBox(img, cv::Size(640, 640), inference::kFP32);
+    CheckLetterBox(img, cv::Size(640, 640), inference::kFP16);
+  }
+}
+
+TEST(Preprocess, LetterBox_C1) {
+  cv::Mat img(cv::Size(800, 600), CV_8UC1);
+  cv::randu(img, cv::Scalar::all(0), cv::Scalar::all(256));
+  CheckLetterBox(img, cv::Size(640, 640), inference::kFP32);
+}
+
+TEST(Preprocess, Spec) {
+  cv::Mat img(cv::Size(500, 300), CV_8UC3);
+  cv::randu(img, cv::Scalar::all(0), cv::Scalar::all(256));
+
+  // ImageNet 的 mean/std, 居中填充 114
+  imgutils::PreprocessSpec spec;
+  spec.size = cv::Size(224, 224);
+  spec.center = true;
+  spec.pad_value = 114;
+  spec.mean = {123.675f, 116.28f, 103.53f};
+  spec.stddev = {58.395f, 57.12f, 57.375f};
+  CheckSpec(img, spec);
+
+  spec.to_rgb = false;
+  CheckSpec(img, spec);
+
+  spec.layout = imgutils::TensorLayout::kNHWC;
+  CheckSpec(img, spec);
+
+  spec.resize_mode = imgutils::ResizeMode::kStretch;
+  CheckSpec(img, spec);
+
+  // mnist: 灰度 28x28
+  spec = imgutils::PreprocessSpec();
+  spec.size = cv::Size(28, 28);
+  spec.channels = 1;
+  spec.resize_mode = imgutils::ResizeMode::kStretch;
+  CheckSpec(img, spec);
+}
+
+TEST(Preprocess, LoadSpec) {
+  auto path = std::filesystem::temp_directory_path() / "test.preprocess.yaml";
+  {
+    std::ofstream file(path);
+    file << "%YAML:1.0\n"
+         << "size: [224, 224]\n"
+         << "resize_mode: stretch\n"
+         << "mean: [123.675, 116.28, 103.53]\n"
+         << "std: [58.395, 57.12, 57.375]\n"
+         << "channel_order: bgr\n"
+         << "layout: nhwc\n"
+         << "data_type: fp16\n";
+  }
+  EXPECT_EQ(imgutils::GetPreprocessSpecPath(
+                (path.parent_path() / "test.onnx").string()),
+            path.string());
+
+  imgutils::PreprocessSpec spec;
+  ASSERT_EQ(imgutils::LoadPreprocessSpecForModel(
+                (path.parent_path() / "test.onnx").string(), &spec),
+            0);
+  EXPECT_EQ(spec.size, cv::Size(224, 224));
+  EXPECT_EQ(spec.resize_mode, imgutils::ResizeMode::kStretch);
+  EXPECT_FLOAT_EQ(spec.mean[1], 116.28f);
+  EXPECT_FLOAT_EQ(spec.stddev[2], 57.375f);
+  EXPECT_FALSE(spec.to_rgb);
+  EXPECT_EQ(spec.layout, imgutils::TensorLayout::kNHWC);
+  EXPECT_EQ(spec.data_type, inference::kFP16);
+  // 没有出现的字段保持默认值
+  EXPECT_EQ(spec.channels, 3);
+  EXPECT_FALSE(spec.center);
+  std::filesystem::remove(path);
+
+  // 描述文件不存在时不修改 spec
+  imgutils::PreprocessSpec default_spec;
+  EXPECT_EQ(imgutils::LoadPreprocessSpecForModel("not_exist.onnx",
+                                                 &default_spec),
+            0);
+  EXPECT_EQ(default_spec.size, cv::Size(640, 640));
+}
+
+TEST(Preprocess, SpecForModel) {
+  imgutils::Preprocessor preprocessor;
+  ASSERT_EQ(preprocessor.SetSpecForModel("test/data/letterbox_center.onnx"), 0);
+  const auto &spec = preprocessor.GetSpec();
+  EXPECT_EQ(spec.size, cv::Size(320, 256));
+  EXPECT_EQ(spec.resize_mode, imgutils::ResizeMode::kLetterBox);
+  EXPECT_TRUE(spec.center);
+  EXPECT_FLOAT_EQ(spec.pad_value, 114.0f);
+  EXPECT_FLOAT_EQ(spec.mean[0], 123.675f);
+  EXPECT_FLOAT_EQ(spec.stddev[1], 57.12f);
+  EXPECT_FALSE(spec.to_rgb);
+  EXPECT_EQ(spec.layout, imgutils::TensorLayout::kNCHW);
+
+  // 描述文件无效或不存在时使用默认值
+  imgutils::PreprocessSpec default_spec;
+  EXPECT_NE(preprocessor.SetSpecForModel("test/data/invalid.onnx"), 0);
+  EXPECT_EQ(preprocessor.GetSpec().size, default_spec.size);
+  EXPECT_FALSE(preprocessor.GetSpec().center);
+  EXPECT_TRUE(preprocessor.GetSpec().to_rgb);
+
+  ASSERT_EQ(preprocessor.SetSpecForModel("test/data/letterbox_center.onnx"), 0);
+  EXPECT_EQ(preprocessor.SetSpecForModel("test/data/not_exist.onnx"), 0);
+  EXPECT_EQ(preprocessor.GetSpec().size, default_spec.size);
+  EXPECT_FLOAT_EQ(preprocessor.GetSpec().stddev[0], 255.0f);
+}
+
+TEST(Preprocess, TensorTooSmall) {
+  cv::Mat img(cv::Size(64, 64), CV_8UC3, cv::Scalar::all(0));
+  std::vector<float> blob(3 * 32 * 32);
+  inference::TensorDataPointer tensor(blob.data(), blob.size() * sizeof(float),
+                                      blob.size(), {1, 3, 64, 64},
+                                      inference::kFP32, inference::kCPU);
+  imgutils::Preprocessor preprocessor;
+  EXPECT_NE(preprocessor.Run(img, tensor, nullptr), 0);
+}
+
+TEST(Preprocess, Batch) {
+  const int batch_size = 32;
+  std::vector<cv::Mat> imgs;
+  for (int i = 0; i < batch_size; i++) {
+    imgs.emplace_back(cv::Size(28, 28), CV_8UC1, cv::Scalar::all(i));
+  }
+  std::vector<float> blob(batch_size * 28 * 28, -1.0f);
+  inference::TensorDataPointer tensor(blob.data(), 28 * 28 * sizeof(float),
+                                      28 * 28, {1, 1, 28, 28},
+                                      inference::kFP32, inference::kCPU);
+  for (int i = 0; i < batch_size; i++) {
+    tensor.p_arr.push_back(blob.data() + i * 28 * 28);
+  }
+
+  inference::ThreadPool pool(3);
+  ASSERT_EQ(imgutils::BlobNormalizeBatch(&pool, imgs, tensor), 0);
+  for (int i = 0; i < batch_size; i++) {
+    EXPECT_FLOAT_EQ(blob[i * 28 * 28], i / 255.0f);
+    EXPECT_FLOAT_EQ(blob[(i + 1) * 28 * 28 - 1], i / 255.0f);
+  }
+
+  // 任意样本失败时返回错误, 不在线程池中时同样生效
+  auto fail_at_20 = [](int index, void *) { return index == 20 ? -1 : 0; };
+  EXPECT_NE(imgutils::PreprocessBatch(&pool, tensor, batch_size, fail_at_20),
+            0);
+  EXPECT_NE(
+      imgutils::PreprocessBatch(nullptr, tensor, batch_size, fail_at_20), 0);
+  EXPECT_NE(imgutils::PreprocessBatch(&pool, tensor, batch_size + 1,
+                                      [](int, void *) { return 0; }),
+            0);
+}
+
+TEST(Preprocess, BatchParallelThreshold) {
+  const int batch_size = 8;
+  std::vector<void *> dst(batch_size, nullptr);
+  inference::TensorDataPointer tensor;
+  tensor.p_arr = dst;
+  inference::ThreadPool pool(3);
+
+  std::mutex mutex;
+  std::set<std::thread::id> thread_ids;
+  auto record_thread = [&](int, void *) {
+    std::lock_guard<std::mutex> lock(mutex);
+    thread_ids.insert(std::this_thread::get_id());
+    return 0;
+  };
+
+  // 样本较小时只在调用线程执行
+  tensor.mem_size = 28 * 28 * sizeof(float);
+  ASSERT_EQ(imgutils::PreprocessBatch(&pool, tensor, batch_size, record_thread),
+            0);
+  EXPECT_EQ(thread_ids.size(), 1u);
+  EXPECT_EQ(*thread_ids.begin(), std::this_thread::get_id());
+
+  // 达到阈值后分发到线程池, 调用线程处理第一份
+  thread_ids.clear();
+  tensor.mem_size = imgutils::kMinParallelSampleBytes;
+  ASSERT_EQ(imgutils::PreprocessBatch(&pool, tensor, batch_size, record_thread),
+            0);
+  EXPECT_GT(thread_ids.size(), 1u);
+  EXPECT_TRUE(thread_ids.count(std::this_thread::get_id()));
+}
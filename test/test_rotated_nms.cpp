@@ -0,0 +1,173 @@
+#include "modelzoo/common/rotated_nms.h"
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+
+// 候选框聚集在若干个目标附近, 角度和尺寸带有抖动
+imgutils::RotatedNmsBoxes RandomBoxes(int num, int class_num, int seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> center(50.f, 590.f);
+  std::uniform_real_distribution<float> size(5.f, 120.f);
+  std::uniform_real_distribution<float> angle(0.f, 3.14f);
+  std::normal_distribution<float> jitter(0.f, 5.f);
+  std::normal_distribution<float> angle_jitter(0.f, 0.2f);
+  std::uniform_real_distribution<float> score(0.f, 1.f);
+  int object_num = std::max(1, num / 8);
+  std::vector<std::vector<float>> objects;
+  for (int i = 0; i < object_num; i++) {
+    objects.push_back(
+        {center(rng), center(rng), size(rng), size(rng), angle(rng)});
+  }
+
+  imgutils::RotatedNmsBoxes boxes;
+  for (int i = 0; i < num; i++) {
+    const auto &o = objects[i % object_num];
+    boxes.Add(o[0] + jitter(rng), o[1] + jitter(rng),
+              std::max(o[2] + jitter(rng), 1.f),
+              std::max(o[3] + jitter(rng), 1.f), o[4] + angle_jitter(rng),
+              score(rng), (i / object_num) % class_num);
+  }
+  return boxes;
+}
+
+// 按定义计算的 ProbIoU
+float ProbIoUReference(const imgutils::RotatedNmsBoxes &boxes, int i, int j) {
+  auto cov = [&](int k, double *a, double *b, double *c) {
+    double w2 = boxes.w[k] * boxes.w[k] / 12.0;
+    double h2 = boxes.h[k] * boxes.h[k] / 12.0;
+    double cos_r = std::cos(boxes.angle[k]);
+    double sin_r = std::sin(boxes.angle[k]);
+    *a = w2 * cos_r * cos_r + h2 * sin_r * sin_r;
+    *b = w2 * sin_r * sin_r + h2 * cos_r * cos_r;
+    *c = (w2 - h2) * sin_r * cos_r;
+  };
+  double a1, b1, c1, a2, b2, c2;
+  cov(i, &a1, &b1, &c1);
+  cov(j, &a2, &b2, &c2);
+  double dx = boxes.cx[i] - boxes.cx[j];
+  double dy = boxes.cy[i] - boxes.cy[j];
+  double a = a1 + a2, b = b1 + b2, c = c1 + c2;
+  double det = a * b - c * c;
+  double bd = 0.25 * (a * dy * dy + b * dx * dx) / det -
+              0.5 * c * dx * dy / det +
+              0.5 * std::log(det / (4 * std::sqrt(a1 * b1 - c1 * c1) *
+                                    std::sqrt(a2 * b2 - c2 * c2)));
+  bd = std::min(std::max(bd, 1e-7), 100.0);
+  return 1.0 - std::sqrt(1.0 - std::exp(-bd) + 1e-7);
+}
+
+// 逐对计算 ProbIoU 的贪心 NMS
+std::vector<int> RotatedNmsReference(const imgutils::RotatedNmsBoxes &boxes,
+                                     const imgutils::NmsParams &params) {
+  std::vector<int> order;
+  for (int i = 0; i < (int)boxes.size(); i++) {
+    if (boxes.scores[i] > params.score_threshold) {
+      order.push_back(i);
+    }
+  }
+  std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+    return boxes.scores[a] > boxes.scores[b];
+  });
+  std::vector<int> keep;
+  for (int i : order) {
+    bool suppressed = false;
+    for (int k : keep) {
+      bool same_class = boxes.class_ids[i] == boxes.class_ids[k];
+      if ((!params.class_aware || same_class) &&
+          ProbIoUReference(boxes, i, k) > params.iou_threshold) {
+        suppressed = true;
+        break;
+      }
+    }
+    if (!suppressed) {
+      keep.push_back(i);
+    }
+  }
+  return keep;
+}
+
+} // namespace
+
+TEST(RotatedNms, ProbIoU) {
+  EXPECT_NEAR(imgutils::ProbIoU(100, 100, 40, 20, 0.3f, 100, 100, 40, 20, 0.3f),
+              1.0f, 1e-3);
+  // 旋转 180 度后是同一个框
+  EXPECT_NEAR(
+      imgutils::ProbIoU(100, 100, 40, 20, 0.3f, 100, 100, 40, 20, 3.4416f),
+      1.0f, 1e-3);
+  EXPECT_NEAR(imgutils::ProbIoU(100, 100, 40, 20, 0.3f, 400, 400, 40, 20, 0.3f),
+              0.0f, 1e-3);
+  // 宽高互换等价于旋转 90 度
+  EXPECT_NEAR(imgutils::ProbIoU(0, 0, 40, 20, 0.0f, 5, 3, 20, 40, 0.0f),
+              imgutils::ProbIoU(0, 0, 40, 20, 0.0f, 5, 3, 40, 20, 1.5708f),
+              1e-4);
+}
+
+TEST(RotatedNms, MatchesReference) {
+  for (int num : {10, 100, 1000}) {
+    auto boxes = RandomBoxes(num, 5, num);
+    for (float iou_threshold : {0.2f, 0.45f, 0.7f}) {
+      for (bool class_aware : {false, true}) {
+        imgutils::NmsParams params;
+        params.iou_threshold = iou_threshold;
+        params.class_aware = class_aware;
+        auto expected = RotatedNmsReference(boxes, params);
+        ASSERT_GT(expected.size(), 0);
+        for (int level = 0; level <= (int)imgutils::GetSimdLevel(); level++) {
+          std::vector<int> keep;
+          ASSERT_EQ(imgutils::RotatedNms(boxes, params,
+                                         (imgutils::SimdLevel)level, &keep),
+                    0);
+          EXPECT_EQ(keep, expected)
+              << "num " << num << " iou " << iou_threshold << " aware "
+              << class_aware << " level " << level;
+        }
+      }
+    }
+  }
+}
+
+TEST(RotatedNms, ClassAwareAndLimits) {
+  imgutils::RotatedNmsBoxes boxes;
+  boxes.Add(100, 100, 60, 20, 0.5f, 0.9f, 0);
+  boxes.Add(102, 101, 60, 20, 0.55f, 0.8f, 1);
+  boxes.Add(101, 102, 60, 20, 0.45f, 0.7f, 1);
+  boxes.Add(300, 300, 60, 20, 0.5f, 0.6f, 1);
+
+  imgutils::NmsParams params;
+  std::vector<int> keep;
+  ASSERT_EQ(imgutils::RotatedNms(boxes, params, &keep), 0);
+  EXPECT_EQ(keep, (std::vector<int>{0, 1, 3}));
+
+  params.class_aware = false;
+  ASSERT_EQ(imgutils::RotatedNms(boxes, params, &keep), 0);
+  EXPECT_EQ(keep, (std::vector<int>{0, 3}));
+
+  params.max_output = 1;
+  ASSERT_EQ(imgutils::RotatedNms(boxes, params, &keep), 0);
+  EXPECT_EQ(keep, (std::vector<int>{0}));
+
+  params.max_output = 0;
+  params.top_k = 2;
+  ASSERT_EQ(imgutils::RotatedNms(boxes, params, &keep), 0);
+  EXPECT_EQ(keep, (std::vector<int>{0}));
+}
+
+TEST(RotatedNms, InvalidInput) {
+  imgutils::RotatedNmsBoxes boxes;
+  boxes.Add(100, 100, 60, 20, 0.5f, 0.9f);
+  boxes.Add(102, 101, 60, 20, 0.55f, 0.8f);
+  imgutils::NmsParams params;
+  std::vector<int> keep;
+
+  params.method = imgutils::NmsMethod::kSoftLinear;
+  EXPECT_NE(imgutils::RotatedNms(boxes, params, &keep), 0);
+
+  params.method = imgutils::NmsMethod::kHard;
+  boxes.angle.pop_back();
+  EXPECT_NE(imgutils::RotatedNms(boxes, params, &keep), 0);
+}
@@ -0,0 +1,141 @@
+#include "modelzoo/common/yolo_decode.h"
+#include "modelzoo/common/yolo_head.hpp"
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+namespace {
+
+// 逐 anchor 的参考实现, output 为 [channels, anchor_num]
+imgutils::YoloCandidates DecodeReference(const std::vector<float> &output,
+                                         int channels, int anchor_num,
+                                         int class_num, float threshold) {
+  imgutils::YoloCandidates candidates;
+  candidates.extra_num = channels - 4 - class_num;
+  auto value = [&](int c, int a) { return output[c * anchor_num + a]; };
+  for (int a = 0; a < anchor_num; a++) {
+    int class_id = 0;
+    for (int c = 1; c < class_num; c++) {
+      if (value(4 + c, a) > value(4 + class_id, a)) {
+        class_id = c;
+      }
+    }
+    float score = value(4 + class_id, a);
+    if (score > threshold) {
+      candidates.boxes.emplace_back(value(0, a), value(1, a), value(2, a),
+                                    value(3, a));
+      candidates.scores.push_back(score);
+      candidates.class_ids.push_back(class_id);
+      candidates.anchors.push_back(a);
+      for (int c = 4 + class_num; c < channels; c++) {
+        candidates.extras.push_back(value(c, a));
+      }
+    }
+  }
+  return candidates;
+}
+
+void ExpectSame(const imgutils::YoloCandidates &expected,
+                const imgutils::YoloCandidates &actual,
+                imgutils::SimdLevel level) {
+  SCOPED_TRACE(imgutils::SimdLevelName(level));
+  ASSERT_EQ(expected.size(), actual.size());
+  ASSERT_EQ(expected.extra_num, actual.extra_num);
+  EXPECT_EQ(expected.boxes, actual.boxes);
+  EXPECT_EQ(expected.scores, actual.scores);
+  EXPECT_EQ(expected.class_ids, actual.class_ids);
+  EXPECT_EQ(expected.anchors, actual.anchors);
+  EXPECT_EQ(expected.extras, actual.extras);
+}
+
+void CheckAllSimdLevels(int class_num, int extra_num, int anchor_num) {
+  int channels = 4 + class_num + extra_num;
+  // 分数量化到 1/64, 覆盖分数相等的情况, 也不受 FP16 精度影响
+  std::mt19937 rng(class_num);
+  std::uniform_int_distribution<int> dist(0, 63);
+  std::vector<float> output(channels * anchor_num);
+  for (auto &v : output) {
+    v = dist(rng) / 64.0f;
+  }
+  std::vector<half_float::half> output_fp16(output.begin(), output.end());
+
+  const float threshold = 0.9f;
+  auto expected =
+      DecodeReference(output, channels, anchor_num, class_num, threshold);
+  ASSERT_GT(expected.size(), 0);
+
+  inference::TensorShape shape = {1, channels, anchor_num};
+  inference::TensorDataPointer fp32(output.data(),
+                                    output.size() * sizeof(float),
+                                    output.size(), shape, inference::kFP32,
+                                    inference::kCPU);
+  inference::TensorDataPointer fp16(
+      output_fp16.data(), output_fp16.size() * sizeof(half_float::half),
+      output_fp16.size(), shape, inference::kFP16, inference::kCPU);
+  for (int level = 0; level <= (int)imgutils::GetSimdLevel(); level++) {
+    auto simd_level = (imgutils::SimdLevel)level;
+    for (const auto *tensor : {&fp32, &fp16}) {
+      imgutils::YoloCandidates candidates;
+      ASSERT_EQ(imgutils::DecodeYoloHead(*tensor, class_num, threshold,
+                                         simd_level, &candidates),
+                0);
+      ExpectSame(expected, candidates, simd_level);
+    }
+  }
+}
+
+} // namespace
+
+TEST(YoloDecode, Detect) { CheckAllSimdLevels(80, 0, 8400); }
+
+TEST(YoloDecode, Pose) { CheckAllSimdLevels(1, 51, 8400); }
+
+TEST(YoloDecode, Obb) {
+  // anchor 数不是块大小和向量宽度的倍数, 覆盖尾部
+  CheckAllSimdLevels(15, 1, 1029);
+}
+
+TEST(YoloDecode, Seg) { CheckAllSimdLevels(80, 32, 2100); }
+
+TEST(YoloDecode, DynamicHead) {
+  // 不在模型库中的类别数, 走运行期的通用版本
+  CheckAllSimdLevels(7, 3, 777);
+}
+
+TEST(YoloDecode, SpecializedHeadMatchesDynamic) {
+  const int anchor_num = 600;
+  const int channels = 4 + 80 + 32;
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+  std::vector<float> output(channels * anchor_num);
+  for (auto &v : output) {
+    v = dist(rng);
+  }
+  const auto &kernels = imgutils::GetYoloRowKernels(imgutils::GetSimdLevel());
+  imgutils::YoloCandidates expected;
+  imgutils::YoloCandidates actual;
+  imgutils::DecodeYoloHead<imgutils::DynamicYoloHead>(
+      output.data(), anchor_num, 80, 32, 0.98f, kernels, &expected);
+  imgutils::DecodeYoloHead<imgutils::Yolo11SegHead>(
+      output.data(), anchor_num, 80, 32, 0.98f, kernels, &actual);
+  ASSERT_GT(expected.size(), 0);
+  ExpectSame(expected, actual, imgutils::GetSimdLevel());
+
+  EXPECT_TRUE(imgutils::Yolo11SegHead::Match(80, 32));
+  EXPECT_FALSE(imgutils::Yolo11SegHead::Match(80, 0));
+  EXPECT_TRUE(imgutils::DynamicYoloHead::Match(3, 5));
+}
+
+TEST(YoloDecode, InvalidShape) {
+  std::vector<float> output(84 * 10);
+  inference::TensorDataPointer tensor(output.data(),
+                                      output.size() * sizeof(float),
+                                      output.size(), {1, 84, 10},
+                                      inference::kFP32, inference::kCPU);
+  imgutils::YoloCandidates candidates;
+  EXPECT_NE(imgutils::DecodeYoloHead(tensor, 81, 0.5f, &candidates), 0);
+  EXPECT_NE(imgutils::DecodeYoloHead(tensor, 0, 0.5f, &candidates), 0);
+  tensor.shape = {84, 10};
+  EXPECT_NE(imgutils::DecodeYoloHead(tensor, 80, 0.5f, &candidates), 0);
+}